@@ -0,0 +1,70 @@
+//
+//  AllocationCounter.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "AllocationCounter.hpp"
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Heap allocations made by each thread
+thread_local size_t threadAllocations = 0;
+
+} // namespace
+
+// Getter: Returns the heap allocations made by the calling thread so far
+size_t AllocationCounter::getCount() {
+    return threadAllocations;
+}
+
+#ifdef NN_COUNT_ALLOCATIONS
+
+// Replacement global allocation functions: malloc/aligned_alloc and free, plus the count. They live alone in this
+// file so the compiler never sees them inlined next to its builtin operator new. The array and nothrow forms
+// forward to these by default; the aligned forms do not, so they are replaced too
+
+// Allocates size bytes
+void* operator new(std::size_t size) {
+    threadAllocations++;
+    if (void* pointer = std::malloc(size > 0 ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+// Allocates size bytes aligned to alignment (aligned_alloc needs a size that is a multiple of the alignment)
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    threadAllocations++;
+    size_t bytes = static_cast<size_t>(alignment);
+    size_t rounded = (size + bytes - 1) / bytes * bytes;
+    if (void* pointer = std::aligned_alloc(bytes, rounded > 0 ? rounded : bytes)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+// Frees memory from operator new
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+// Frees memory from operator new (sized form)
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+// Frees memory from the aligned operator new
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+// Frees memory from the aligned operator new (sized form)
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+#endif
@@ -0,0 +1,32 @@
+//
+//  AllocationCounter.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef AllocationCounter_hpp
+#define AllocationCounter_hpp
+
+#include <cstddef>
+
+// Per-thread count of heap allocations, for checking that steady-state paths do not allocate.
+// Build with -DNN_COUNT_ALLOCATIONS to replace the global operator new and delete (every form, including the
+// aligned ones) with counting versions; otherwise the standard allocator is left alone and nothing is counted.
+// The count is per thread so counting never makes threads contend on a shared counter.
+class AllocationCounter {
+public:
+    // True if the counting allocator was compiled in
+    static constexpr bool isCompiledIn() {
+#ifdef NN_COUNT_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Getter: Returns the heap allocations made by the calling thread so far (always 0 unless compiled in)
+    static size_t getCount();
+};
+
+#endif /* AllocationCounter_hpp */
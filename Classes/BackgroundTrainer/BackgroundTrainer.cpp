@@ -0,0 +1,191 @@
+//
+//  BackgroundTrainer.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "BackgroundTrainer.hpp"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+// Constructor: Sizes the snapshot slots for the network so publishing never allocates
+BackgroundTrainer::BackgroundTrainer(Network& network, const Dataset& data, int epochs, size_t snapshotInterval)
+    : network(network), data(data), epochs(epochs), snapshotInterval(std::max<size_t>(snapshotInterval, 1)),
+      state(State::Idle), cancelRequested(false), epoch(0), sampleIndex(0), epochLoss(0.0), lastEpochLoss(0.0),
+      middle(1), back(2), front(0) {
+    if (data.getSampleSize() != static_cast<size_t>(network.getInputSize())) {
+        throw std::invalid_argument("Sample size does not match the network input size");
+    }
+    for (Snapshot& snapshot : snapshots) {
+        for (const auto& layer : network.getLayers()) {
+            snapshot.weights.emplace_back(layer->getWeights().begin(), layer->getWeights().end());
+            snapshot.biases.emplace_back(layer->getBiases().begin(), layer->getBiases().end());
+        }
+    }
+}
+
+// Destructor: Cancels and joins a run still in progress
+BackgroundTrainer::~BackgroundTrainer() {
+    cancel();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+// Starts the worker
+void BackgroundTrainer::start() {
+    State expected = State::Idle;
+    if (!state.compare_exchange_strong(expected, State::Running)) {
+        throw std::logic_error("Training was already started");
+    }
+    worker = std::thread(&BackgroundTrainer::run, this);
+}
+
+// Pauses after the current sample
+void BackgroundTrainer::pause() {
+    State expected = State::Running;
+    state.compare_exchange_strong(expected, State::Paused);
+}
+
+// Resumes a paused run
+void BackgroundTrainer::resume() {
+    State expected = State::Paused;
+    if (state.compare_exchange_strong(expected, State::Running)) {
+        state.notify_all();
+    }
+}
+
+// Stops after the current sample; a paused worker is woken so it can see the request
+void BackgroundTrainer::cancel() {
+    cancelRequested.store(true);
+    resume();
+}
+
+// Waits for the worker to exit and rethrows its exception, if any
+void BackgroundTrainer::join() {
+    if (worker.joinable()) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(std::exchange(error, nullptr));
+    }
+}
+
+// True once the worker has stopped
+bool BackgroundTrainer::isDone() const {
+    State current = state.load();
+    return current == State::Finished || current == State::Cancelled || current == State::Failed;
+}
+
+// Worker main loop: the same per-sample training as the GUI's former inline loop
+void BackgroundTrainer::run() {
+    try {
+        std::vector<Scalar> sample(data.getSampleSize()); // Normalized pixels of the current sample
+        size_t numSamples = data.getNumSamples();
+        size_t samplesTrained = 0;
+        publishSnapshot(samplesTrained);
+        for (int e = 0; e < epochs; ++e) {
+            epoch.store(e, std::memory_order_relaxed);
+            double totalLoss = 0.0;
+            for (size_t i = 0; i < numSamples; ++i) {
+                // Block while paused; cancel() switches the state back to Running to wake us
+                state.wait(State::Paused);
+                if (cancelRequested.load(std::memory_order_relaxed)) {
+                    publishSnapshot(samplesTrained);
+                    state.store(State::Cancelled);
+                    return;
+                }
+                sampleIndex.store(i, std::memory_order_relaxed);
+
+                data.getSample(i, sample);
+                totalLoss += network.trainStep(sample, data.getLabel(i));
+                epochLoss.store(totalLoss / static_cast<double>(i + 1), std::memory_order_relaxed);
+
+                if (++samplesTrained % snapshotInterval == 0) {
+                    publishSnapshot(samplesTrained);
+                }
+            }
+            lastEpochLoss.store(totalLoss / static_cast<double>(numSamples), std::memory_order_relaxed);
+            std::cout << "Epoch " << e + 1 << ", Loss: " << totalLoss / numSamples << std::endl;
+        }
+        publishSnapshot(samplesTrained);
+        state.store(State::Finished);
+    } catch (...) {
+        error = std::current_exception();
+        state.store(State::Failed);
+    }
+}
+
+// Copies the parameters into the back slot and swaps it into the middle, marked fresh
+void BackgroundTrainer::publishSnapshot(size_t samplesTrained) {
+    Snapshot& snapshot = snapshots[back];
+    const auto& layers = network.getLayers();
+    for (size_t l = 0; l < layers.size(); ++l) {
+        std::copy(layers[l]->getWeights().begin(), layers[l]->getWeights().end(), snapshot.weights[l].begin());
+        std::copy(layers[l]->getBiases().begin(), layers[l]->getBiases().end(), snapshot.biases[l].begin());
+    }
+    snapshot.samplesTrained = samplesTrained;
+    // Release makes the copy visible to the reader that acquires this slot
+    back = static_cast<uint8_t>(middle.exchange(static_cast<uint8_t>(back | FRESH), std::memory_order_acq_rel) & ~FRESH);
+}
+
+// Returns the newest snapshot, taking the middle slot if the worker published since the last call
+const BackgroundTrainer::Snapshot& BackgroundTrainer::getSnapshot(bool& changed) {
+    changed = (middle.load(std::memory_order_relaxed) & FRESH) != 0;
+    if (changed) {
+        front = static_cast<uint8_t>(middle.exchange(front, std::memory_order_acq_rel) & ~FRESH);
+    }
+    return snapshots[front];
+}
+
+// Getter: Returns the current state
+BackgroundTrainer::State BackgroundTrainer::getState() const {
+    return state.load();
+}
+
+// Getter: Returns the epoch in progress (0-based)
+int BackgroundTrainer::getEpoch() const {
+    return epoch.load(std::memory_order_relaxed);
+}
+
+// Getter: Returns the number of epochs of the run
+int BackgroundTrainer::getEpochs() const {
+    return epochs;
+}
+
+// Getter: Returns the sample in progress within the epoch
+size_t BackgroundTrainer::getSampleIndex() const {
+    return sampleIndex.load(std::memory_order_relaxed);
+}
+
+// Getter: Returns the average loss of the epoch so far
+double BackgroundTrainer::getEpochLoss() const {
+    return epochLoss.load(std::memory_order_relaxed);
+}
+
+// Getter: Returns the average loss of the last completed epoch
+double BackgroundTrainer::getLastEpochLoss() const {
+    return lastEpochLoss.load(std::memory_order_relaxed);
+}
+
+// Returns a printable name for a state
+const char* BackgroundTrainer::getStateName(State state) {
+    switch (state) {
+        case State::Idle:
+            return "Idle";
+        case State::Running:
+            return "Running";
+        case State::Paused:
+            return "Paused";
+        case State::Finished:
+            return "Finished";
+        case State::Cancelled:
+            return "Cancelled";
+        case State::Failed:
+            return "Failed";
+    }
+    return "Unknown";
+}
@@ -0,0 +1,119 @@
+//
+//  BackgroundTrainer.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef BackgroundTrainer_hpp
+#define BackgroundTrainer_hpp
+
+#include "Network.hpp"
+#include "Dataset.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// Trains a network sample by sample on a worker thread so a GUI thread can keep rendering.
+// The network belongs to the worker from start() until the trainer has finished (or been cancelled)
+// and joined; in between, the GUI thread reads progress through atomics and copies of the weights
+// through getSnapshot(), and never waits on the worker.
+class BackgroundTrainer {
+public:
+    // Life cycle of a training run
+    enum class State : uint8_t {
+        Idle,       // Not started
+        Running,    // Training
+        Paused,     // Waiting for resume() or cancel() between two samples
+        Finished,   // Ran all epochs
+        Cancelled,  // Stopped by cancel(); the network keeps the weights trained so far
+        Failed      // Stopped by an exception, rethrown by join()
+    };
+
+    // Parameters of every layer at some point of training, in layer order
+    struct Snapshot {
+        std::vector<std::vector<Scalar>> weights;
+        std::vector<std::vector<Scalar>> biases;
+        size_t samplesTrained = 0;  // Training steps taken when the copy was made
+    };
+
+private:
+    Network& network;               // Trained in place by the worker
+    const Dataset& data;            // Training samples
+    int epochs;                     // Passes over the data
+    size_t snapshotInterval;        // Samples between two published snapshots
+
+    std::atomic<State> state;               // Current state; pause() and resume() flip it
+    std::atomic<bool> cancelRequested;      // Set by cancel(), checked before every sample
+    std::atomic<int> epoch;                 // Epoch in progress (0-based)
+    std::atomic<size_t> sampleIndex;        // Sample in progress within the epoch
+    std::atomic<double> epochLoss;          // Average loss of the epoch so far
+    std::atomic<double> lastEpochLoss;      // Average loss of the last completed epoch
+
+    // Snapshot triple buffer: the worker fills `back`, then swaps it with the shared middle slot and
+    // marks it fresh; the reader swaps its `front` slot with the middle one only when it is fresh.
+    // Neither side ever waits, and the reader always sees a complete snapshot
+    std::array<Snapshot, 3> snapshots;
+    std::atomic<uint8_t> middle;            // Index of the shared slot, plus FRESH when it is newer than front
+    uint8_t back;                           // Slot the worker writes (worker only)
+    uint8_t front;                          // Slot the reader holds (reader only)
+    static constexpr uint8_t FRESH = 4;
+
+    std::exception_ptr error;               // Exception that stopped the worker
+    std::thread worker;                     // Training thread
+
+    // Worker main loop
+    void run();
+
+    // Copies the network's parameters into the back slot and publishes it (worker only)
+    void publishSnapshot(size_t samplesTrained);
+
+public:
+    // Constructor: Prepares a run of `epochs` epochs over data; nothing happens until start().
+    // Throws std::invalid_argument if the data does not match the network's input size
+    BackgroundTrainer(Network& network, const Dataset& data, int epochs, size_t snapshotInterval = 1000);
+
+    // Destructor: Cancels and joins a run still in progress
+    ~BackgroundTrainer();
+
+    BackgroundTrainer(const BackgroundTrainer&) = delete;
+    BackgroundTrainer& operator=(const BackgroundTrainer&) = delete;
+
+    // Starts the worker. Throws std::logic_error if it was already started
+    void start();
+
+    // Pauses after the current sample; has no effect unless running
+    void pause();
+
+    // Resumes a paused run
+    void resume();
+
+    // Stops after the current sample (also wakes a paused worker)
+    void cancel();
+
+    // Waits for the worker to exit; rethrows the exception that stopped it, if any
+    void join();
+
+    // True once the worker has stopped (finished, cancelled or failed) and join() will not block
+    bool isDone() const;
+
+    // Progress getters, safe to call from any thread while the worker runs
+    State getState() const;
+    int getEpoch() const;
+    int getEpochs() const;
+    size_t getSampleIndex() const;
+    double getEpochLoss() const;
+    double getLastEpochLoss() const;
+
+    // Returns the newest snapshot and whether it changed since the previous call (reader thread only).
+    // The reference stays valid and unchanged until the next call
+    const Snapshot& getSnapshot(bool& changed);
+
+    // Returns a printable name for a state
+    static const char* getStateName(State state);
+};
+
+#endif /* BackgroundTrainer_hpp */
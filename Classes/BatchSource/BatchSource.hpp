@@ -0,0 +1,36 @@
+//
+//  BatchSource.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef BatchSource_hpp
+#define BatchSource_hpp
+
+#include "Scalar.hpp"
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// Interface for anything that can feed training batches to a Network,
+// implemented by the in-memory DatasetSource and the out-of-core StreamingLoader
+class BatchSource {
+public:
+    virtual ~BatchSource() = default;
+
+    // Get number of samples delivered per epoch
+    virtual size_t getNumSamples() const = 0;
+
+    // Get number of input values per sample
+    virtual size_t getSampleSize() const = 0;
+
+    // Starts a new epoch that delivers batches of up to batchSize samples (reshuffling if enabled)
+    virtual void startEpoch(int epoch, size_t batchSize) = 0;
+
+    // Writes the next batch: normalized inputs stacked row by row (room for batchSize samples)
+    // and their labels. Returns the number of samples in the batch, or 0 at the end of the epoch
+    virtual size_t nextBatch(std::span<Scalar> inputs, std::vector<int>& labels) = 0;
+};
+
+#endif /* BatchSource_hpp */
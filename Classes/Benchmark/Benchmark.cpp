@@ -0,0 +1,711 @@
+//
+//  Benchmark.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "Benchmark.hpp"
+#include "AllocationCounter.hpp"
+#include "Conv2DLayer.hpp"
+#include "Dataset.hpp"
+#include "DenseLayer.hpp"
+#include "FlattenLayer.hpp"
+#include "Kernels.hpp"
+#include "Layer.hpp"
+#include "MaxPoolLayer.hpp"
+#include "Network.hpp"
+#include "Neuron.hpp"
+#include "Optimizer.hpp"
+#include "QuantizedNetwork.hpp"
+#include "SparseInputs.hpp"
+#include "DatasetSource.hpp"
+#include "Tracer.hpp"
+#include "TrainingController.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+
+namespace {
+
+// Results are accumulated here so the compiler cannot drop the benchmarked work
+volatile double sink = 0.0;
+
+// Returns n random values in [-1, 1]
+std::vector<Scalar> randomValues(size_t n, unsigned seed) {
+    std::default_random_engine generator(seed);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    std::vector<Scalar> values(n);
+    for (auto& v : values) {
+        v = static_cast<Scalar>(distribution(generator));
+    }
+    return values;
+}
+
+// Returns n values in [0, 1], of which about a fraction `density` are nonzero (like image pixels)
+std::vector<Scalar> sparseRandomValues(size_t n, double density, unsigned seed) {
+    std::default_random_engine generator(seed);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    std::vector<Scalar> values(n);
+    for (auto& v : values) {
+        v = distribution(generator) < density ? static_cast<Scalar>(distribution(generator)) : Scalar(0);
+    }
+    return values;
+}
+
+// Input densities of the sparse first-layer sweep (about 0.19 for MNIST)
+const std::vector<double> DENSITIES = { 0.1, 0.2, 0.35, 0.5, 0.75 };
+
+// Widths of the swept layers and batch sizes of the batched paths
+const std::vector<int> WIDTHS = { 16, 64, 256, 1024 };
+const std::vector<size_t> BATCH_SIZES = { 1, 8, 32, 128 };
+const int INPUT_SIZE = 784;
+
+} // namespace
+
+// Runs the benchmark selected by the arguments; returns the process exit code
+int Benchmark::run(const std::vector<std::string>& args) {
+    if (args.size() >= 2 && args[0] == "csv") {
+        int repetitions = args.size() >= 3 ? std::stoi(args[2]) : 5;
+        benchmarkCSVParser(args[1], repetitions);
+        return 0;
+    }
+    if (args.size() >= 3 && args[0] == "int8") {
+        int epochs = args.size() >= 4 ? std::stoi(args[3]) : 5;
+        benchmarkQuantization(args[1], args[2], epochs);
+        return 0;
+    }
+    if (args.size() >= 3 && args[0] == "optimizers") {
+        int epochs = args.size() >= 4 ? std::stoi(args[3]) : 5;
+        size_t batchSize = args.size() >= 5 ? std::stoul(args[4]) : 32;
+        double targetAccuracy = args.size() >= 6 ? std::stod(args[5]) : 0.95;
+        benchmarkOptimizers(args[1], args[2], epochs, batchSize, targetAccuracy);
+        return 0;
+    }
+    if (args.size() >= 3 && args[0] == "controller") {
+        int maxEpochs = args.size() >= 4 ? std::stoi(args[3]) : 20;
+        size_t batchSize = args.size() >= 5 ? std::stoul(args[4]) : 32;
+        benchmarkTrainingController(args[1], args[2], maxEpochs, batchSize);
+        return 0;
+    }
+    if (args.size() >= 3 && args[0] == "conv") {
+        int epochs = args.size() >= 4 ? std::stoi(args[3]) : 5;
+        size_t batchSize = args.size() >= 5 ? std::stoul(args[4]) : 32;
+        benchmarkConvolution(args[1], args[2], epochs, batchSize);
+        return 0;
+    }
+    if (!args.empty() && args[0] == "test") {
+        return runTests(args.size() >= 2 ? args[1] : "") ? 0 : 1;
+    }
+    if (!args.empty() && args[0] == "allocations") {
+        return checkAllocations(args.size() >= 2 ? args[1] : "") ? 0 : 1;
+    }
+    if (args.size() >= 3 && args[0] == "trace") {
+        int epochs = args.size() >= 4 ? std::stoi(args[3]) : 1;
+        size_t batchSize = args.size() >= 5 ? std::stoul(args[4]) : 1;
+        return traceTraining(args[1], args[2], epochs, batchSize) ? 0 : 1;
+    }
+    if (!args.empty() && args[0] == "hotpaths") {
+        // Optional kernel level, to compare instruction sets on the same machine
+        std::string datasetFile;
+        for (size_t i = 1; i < args.size(); ++i) {
+            if (args[i] == "--level" && i + 1 < args.size()) {
+                const std::string& name = args[++i];
+                Kernels::setLevel(name == "scalar" ? Kernels::Level::Scalar
+                                  : name == "avx2" ? Kernels::Level::AVX2 : Kernels::Level::AVX512);
+            } else {
+                datasetFile = args[i];
+            }
+        }
+        std::cout << "Kernels: " << Kernels::getLevelName(Kernels::getLevel()) << ", scalar type: "
+                  << sizeof(Scalar) * 8 << "-bit" << std::endl;
+        std::cout << std::left << std::setw(28) << "benchmark" << std::setw(18) << "shape" << std::right
+                  << std::setw(12) << "ns/op" << std::setw(14) << "samples/s" << std::setw(10) << "GFLOP/s"
+                  << std::setw(10) << "GB/s" << std::endl;
+        benchmarkNeuronForward();
+        benchmarkLayerForward();
+        benchmarkLayerGradients();
+        benchmarkSparseFirstLayer();
+        benchmarkNetworkForward();
+        benchmarkNetworkTraining();
+        if (!datasetFile.empty()) {
+            benchmarkDatasetLoading(datasetFile);
+        }
+        return 0;
+    }
+    std::cerr << "Usage: neuralNetworks bench csv <file.csv> [repetitions]" << std::endl;
+    std::cerr << "       neuralNetworks bench int8 <train.csv> <test.csv> [epochs]" << std::endl;
+    std::cerr << "       neuralNetworks bench hotpaths [--level scalar|avx2|avx512] [data.csv]" << std::endl;
+    std::cerr << "       neuralNetworks bench optimizers <train.csv> <test.csv> [epochs] [batchSize] [targetAccuracy]"
+              << std::endl;
+    std::cerr << "       neuralNetworks bench controller <train.csv> <test.csv> [maxEpochs] [batchSize]" << std::endl;
+    std::cerr << "       neuralNetworks bench conv <train.csv> <test.csv> [epochs] [batchSize]" << std::endl;
+    std::cerr << "       neuralNetworks bench test [train.csv]           (needs -DNN_COUNT_ALLOCATIONS)" << std::endl;
+    std::cerr << "       neuralNetworks bench allocations [train.csv]    (needs -DNN_COUNT_ALLOCATIONS)" << std::endl;
+    std::cerr << "       neuralNetworks bench trace <train.csv> <trace.json> [epochs] [batchSize]" << std::endl;
+    return 1;
+}
+
+// Measures CSV parsing throughput of the Dataset loader (best of several runs)
+void Benchmark::benchmarkCSVParser(const std::string& filename, int repetitions) {
+    double megabytes = static_cast<double>(std::filesystem::file_size(filename)) / (1024.0 * 1024.0);
+    double best = 0.0;
+    size_t numSamples = 0;
+    for (int r = 0; r < repetitions; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        Dataset dataset(filename);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        numSamples = dataset.getNumSamples();
+        best = r == 0 ? seconds : std::min(best, seconds);
+    }
+    std::cout << "CSV parse: " << filename << ", " << numSamples << " samples, " << megabytes << " MB" << std::endl;
+    std::cout << "  best " << best * 1e3 << " ms, " << megabytes / best << " MB/s, "
+              << numSamples / best << " samples/s" << std::endl;
+}
+
+// Trains a network, quantizes it to int8 and reports accuracy and latency of both models
+void Benchmark::benchmarkQuantization(const std::string& trainFile, const std::string& testFile, int epochs) {
+    Dataset trainData = Dataset::openCached(trainFile);
+    Dataset testData = Dataset::openCached(testFile);
+    Network network({ static_cast<int>(trainData.getSampleSize()), 128, 10 }, 0.01);
+    network.train(trainData, epochs);
+    // Calibrate on training samples so the test set stays unseen
+    QuantizedNetwork quantized(network, trainData);
+    quantized.report(network, testData);
+}
+
+// Trains copies of one 784-128-10 network, one epoch at a time, with each optimizer at its usual learning rate
+void Benchmark::benchmarkOptimizers(const std::string& trainFile, const std::string& testFile, int epochs,
+                                    size_t batchSize, double targetAccuracy) {
+    Dataset trainData = Dataset::openCached(trainFile);
+    Dataset testData = Dataset::openCached(testFile);
+    Network initial({ static_cast<int>(trainData.getSampleSize()), 128, 10 }, 0.01);
+
+    std::vector<Optimizer::Settings> candidates(5);
+    candidates[0].type = Optimizer::Type::SGD;
+    candidates[1].type = Optimizer::Type::Momentum;
+    candidates[2].type = Optimizer::Type::Nesterov;
+    candidates[3].type = Optimizer::Type::Adam;
+    candidates[3].learningRate = 0.001;
+    candidates[4].type = Optimizer::Type::AdamW;
+    candidates[4].learningRate = 0.001;
+    candidates[4].weightDecay = 0.01;
+
+    struct Result {
+        int epochsToTarget = 0;         // 0 if the target was not reached
+        double secondsToTarget = 0.0;   // Training time until the target was reached
+        double accuracy = 0.0;          // Test accuracy after the last epoch
+    };
+    std::vector<Result> results(candidates.size());
+    for (size_t c = 0; c < candidates.size(); ++c) {
+        std::cout << "== " << Optimizer::getTypeName(candidates[c].type) << " ==" << std::endl;
+        Network network = initial;
+        network.setOptimizer(candidates[c]);
+        double seconds = 0.0;
+        for (int epoch = 1; epoch <= epochs; ++epoch) {
+            auto start = std::chrono::steady_clock::now();
+            network.train(trainData, 1, batchSize);
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            results[c].accuracy = network.evaluate(testData).accuracy;
+            std::cout << "  accuracy " << results[c].accuracy << std::endl;
+            if (results[c].epochsToTarget == 0 && results[c].accuracy >= targetAccuracy) {
+                results[c].epochsToTarget = epoch;
+                results[c].secondsToTarget = seconds;
+            }
+        }
+    }
+
+    std::cout << "Batch size " << batchSize << ", target accuracy " << targetAccuracy << std::endl;
+    std::cout << std::left << std::setw(10) << "optimizer" << std::right << std::setw(8) << "lr" << std::setw(18)
+              << "epochs to target" << std::setw(14) << "s to target" << std::setw(16) << "final accuracy" << std::endl;
+    for (size_t c = 0; c < candidates.size(); ++c) {
+        const Result& result = results[c];
+        std::cout << std::left << std::setw(10) << Optimizer::getTypeName(candidates[c].type) << std::right
+                  << std::setw(8) << candidates[c].learningRate << std::setw(18)
+                  << (result.epochsToTarget > 0 ? std::to_string(result.epochsToTarget) : "-") << std::fixed
+                  << std::setprecision(2) << std::setw(14);
+        if (result.epochsToTarget > 0) {
+            std::cout << result.secondsToTarget;
+        } else {
+            std::cout << "-";
+        }
+        std::cout << std::setprecision(4) << std::setw(16) << result.accuracy << std::defaultfloat
+                  << std::setprecision(6) << std::endl;
+    }
+}
+
+// Fixed-epoch training against controlled training from the same initial weights
+void Benchmark::benchmarkTrainingController(const std::string& trainFile, const std::string& testFile, int maxEpochs,
+                                            size_t batchSize) {
+    Dataset trainData = Dataset::openCached(trainFile);
+    Dataset testData = Dataset::openCached(testFile);
+    Network initial({ static_cast<int>(trainData.getSampleSize()), 128, 10 }, 0.01);
+
+    std::cout << "== Fixed " << maxEpochs << " epochs ==" << std::endl;
+    Network fixed = initial;
+    auto start = std::chrono::steady_clock::now();
+    fixed.train(trainData, maxEpochs, batchSize);
+    double fixedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double fixedAccuracy = fixed.evaluate(testData).accuracy;
+
+    std::cout << "== Controller ==" << std::endl;
+    TrainingController::Settings settings;
+    settings.maxEpochs = maxEpochs;
+    settings.batchSize = batchSize;
+    settings.evaluationsPerEpoch = 2;
+    settings.patience = 4;
+    settings.schedule = TrainingController::Schedule::Cosine;
+    settings.warmupEpochs = 0.5;
+    Network controlled = initial;
+    TrainingController::Result result = TrainingController(settings).train(controlled, trainData);
+    double controlledAccuracy = controlled.evaluate(testData).accuracy;
+
+    std::cout << std::left << std::setw(12) << "run" << std::right << std::setw(10) << "epochs" << std::setw(12)
+              << "seconds" << std::setw(16) << "test accuracy" << std::endl;
+    std::cout << std::fixed << std::setprecision(2) << std::left << std::setw(12) << "fixed" << std::right
+              << std::setw(10) << static_cast<double>(maxEpochs) << std::setw(12) << fixedSeconds << std::setprecision(4)
+              << std::setw(16) << fixedAccuracy << std::endl;
+    std::cout << std::setprecision(2) << std::left << std::setw(12) << "controller" << std::right << std::setw(10)
+              << result.epochs << std::setw(12) << result.seconds << std::setprecision(4) << std::setw(16)
+              << controlledAccuracy << std::defaultfloat << std::setprecision(6) << std::endl;
+    std::cout << "Controller stopped: " << TrainingController::getStopReasonName(result.stopReason)
+              << " (the fixed run also trains on the samples the controller holds out)" << std::endl;
+}
+
+// Trains dense and convolutional networks with the same optimizer and compares test accuracy against
+// inference time. The images are assumed square with one channel (28x28 for MNIST)
+void Benchmark::benchmarkConvolution(const std::string& trainFile, const std::string& testFile, int epochs,
+                                     size_t batchSize) {
+    Dataset trainData = Dataset::openCached(trainFile);
+    Dataset testData = Dataset::openCached(testFile);
+    int sampleSize = static_cast<int>(trainData.getSampleSize());
+    int side = static_cast<int>(std::lround(std::sqrt(sampleSize)));
+    if (side * side != sampleSize) {
+        throw std::invalid_argument("Convolution benchmark needs square images");
+    }
+    Layer::Shape image = { side, side, 1 };
+
+    // Builds conv (filters, 5x5) -> max-pool 2x2 -> flatten -> dense 10
+    auto convolutional = [&](int filters) {
+        Network network(sampleSize, 0.001);
+        network.addLayer(std::make_unique<Conv2DLayer>(image, filters, 5));
+        Layer::Shape convolved = network.getLayers().back()->getOutputShape();
+        network.addLayer(std::make_unique<MaxPoolLayer>(convolved, 2));
+        Layer::Shape pooled = network.getLayers().back()->getOutputShape();
+        network.addLayer(std::make_unique<FlattenLayer>(pooled));
+        network.addLayer(std::make_unique<DenseLayer>(10, static_cast<int>(pooled.size()), false));
+        return network;
+    };
+    std::vector<std::pair<std::string, Network>> candidates;
+    candidates.emplace_back("dense 32", Network({ sampleSize, 32, 10 }, 0.001));
+    candidates.emplace_back("dense 128", Network({ sampleSize, 128, 10 }, 0.001));
+    candidates.emplace_back("conv 4", convolutional(4));
+    candidates.emplace_back("conv 8", convolutional(8));
+
+    struct Result {
+        size_t parameters = 0;          // Weights and biases
+        double trainSeconds = 0.0;      // Training time over all epochs
+        double accuracy = 0.0;          // Test accuracy after the last epoch
+        double batchMicroseconds = 0.0; // Inference time per sample in batches of 64
+        double singleMicroseconds = 0.0;// Inference time of one sample on its own
+    };
+    std::vector<Result> results(candidates.size());
+    std::vector<Scalar> inputs(64 * sampleSize);
+    testData.getBatch(0, std::min<size_t>(64, testData.getNumSamples()), inputs);
+    for (size_t c = 0; c < candidates.size(); ++c) {
+        Network& network = candidates[c].second;
+        std::cout << "== " << candidates[c].first << " ==" << std::endl;
+        for (const auto& layer : network.getLayers()) {
+            std::cout << "  " << layer->describe() << std::endl;
+            results[c].parameters += layer->getWeights().size() + layer->getBiases().size();
+        }
+        Optimizer::Settings adam;
+        adam.type = Optimizer::Type::Adam;
+        adam.learningRate = 0.001;
+        network.setOptimizer(adam);
+        auto start = std::chrono::steady_clock::now();
+        network.train(trainData, epochs, batchSize);
+        results[c].trainSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        results[c].accuracy = network.evaluate(testData, 1).accuracy;
+
+        size_t inferenceBatch = std::min<size_t>(64, testData.getNumSamples());
+        std::vector<Scalar> probabilities(inferenceBatch * network.getOutputSize());
+        Workspace workspace = network.makeWorkspace(inferenceBatch);
+        Measurement batched = measure([&] {
+            network.predictBatch(inputs, probabilities, inferenceBatch, workspace);
+            sink = sink + probabilities[0];
+        });
+        results[c].batchMicroseconds = batched.nanoseconds * 1e-3 / inferenceBatch;
+        std::span<const Scalar> sample(inputs.data(), sampleSize);
+        std::span<Scalar> output(probabilities.data(), network.getOutputSize());
+        Measurement single = measure([&] {
+            network.forward(sample, output);
+            sink = sink + output[0];
+        });
+        results[c].singleMicroseconds = single.nanoseconds * 1e-3;
+    }
+
+    std::cout << epochs << " epochs of Adam, batch size " << batchSize << std::endl;
+    std::cout << std::left << std::setw(12) << "network" << std::right << std::setw(12) << "parameters" << std::setw(12)
+              << "train s" << std::setw(12) << "accuracy" << std::setw(14) << "us/sample b64" << std::setw(12)
+              << "us/sample" << std::endl;
+    for (size_t c = 0; c < candidates.size(); ++c) {
+        const Result& result = results[c];
+        std::cout << std::left << std::setw(12) << candidates[c].first << std::right << std::setw(12)
+                  << result.parameters << std::fixed << std::setprecision(2) << std::setw(12) << result.trainSeconds
+                  << std::setprecision(4) << std::setw(12) << result.accuracy << std::setprecision(2) << std::setw(14)
+                  << result.batchMicroseconds << std::setw(12) << result.singleMicroseconds << std::defaultfloat
+                  << std::setprecision(6) << std::endl;
+    }
+}
+
+// Runs the kernel self-test (in every build type, unlike the startup check of debug builds), then the
+// allocation check
+bool Benchmark::runTests(const std::string& dataFile) {
+    bool kernelsPassed = Kernels::selfTest();
+    std::cout << (kernelsPassed ? "Kernel self-test passed" : "Kernel self-test FAILED") << std::endl;
+    bool allocationsPassed = checkAllocations(dataFile);
+    return kernelsPassed && allocationsPassed;
+}
+
+// Runs each steady-state path once to size its buffers, then counts the allocations of further calls
+bool Benchmark::checkAllocations(const std::string& dataFile) {
+    if (!AllocationCounter::isCompiledIn()) {
+        std::cerr << "Allocation counting is not compiled in; rebuild with -DNN_COUNT_ALLOCATIONS" << std::endl;
+        return false;
+    }
+    const int calls = 100;
+    const size_t batchSize = 32;
+    Network network({ INPUT_SIZE, 64, 10 }, 0.001);
+    std::vector<Scalar> inputs = randomValues(batchSize * INPUT_SIZE, 13);
+    std::vector<int> labels(batchSize);
+    for (size_t b = 0; b < batchSize; ++b) {
+        labels[b] = static_cast<int>(b % 10);
+    }
+    std::span<const Scalar> sample(inputs.data(), INPUT_SIZE);
+    std::vector<Scalar> probabilities(batchSize * 10);
+    Workspace workspace = network.makeWorkspace(batchSize);
+
+    bool passed = true;
+    // Prints the allocations of `repetitions` calls of op made after one warm-up call
+    auto check = [&](const std::string& name, const std::function<void()>& op, int repetitions) {
+        op();
+        size_t before = AllocationCounter::getCount();
+        for (int i = 0; i < repetitions; ++i) {
+            op();
+        }
+        size_t allocations = AllocationCounter::getCount() - before;
+        passed = passed && allocations == 0;
+        std::cout << std::left << std::setw(34) << name << std::right << std::setw(8) << allocations
+                  << " allocations in " << repetitions << " calls" << (allocations == 0 ? "" : "  FAILED") << std::endl;
+    };
+    check("Network::trainStep", [&] { network.trainStep(sample, 3); }, calls);
+    check("Network::trainBatch (32)", [&] { network.trainBatch(inputs, labels); }, calls);
+    // Stateful optimizers keep their state in buffers sized when the optimizer is set
+    Network adamNetwork = network;
+    Optimizer::Settings adam;
+    adam.type = Optimizer::Type::Adam;
+    adam.learningRate = 0.001;
+    adamNetwork.setOptimizer(adam);
+    check("Network::trainStep (Adam)", [&] { adamNetwork.trainStep(sample, 3); }, calls);
+    check("Network::trainBatch (32, Adam)", [&] { adamNetwork.trainBatch(inputs, labels); }, calls);
+    check("Network::forward (into buffer)",
+          [&] { network.forward(sample, std::span<Scalar>(probabilities.data(), 10)); }, calls);
+    check("Network::predictBatch (workspace)",
+          [&] { network.predictBatch(inputs, probabilities, batchSize, workspace); }, calls);
+    // Convolutional networks run every path batched, with the im2col columns in the workspace
+    Network convNetwork(INPUT_SIZE, 0.001);
+    convNetwork.addLayer(std::make_unique<Conv2DLayer>(Layer::Shape{ 28, 28, 1 }, 4, 5));
+    convNetwork.addLayer(std::make_unique<MaxPoolLayer>(Layer::Shape{ 24, 24, 4 }, 2));
+    convNetwork.addLayer(std::make_unique<FlattenLayer>(Layer::Shape{ 12, 12, 4 }));
+    convNetwork.addLayer(std::make_unique<DenseLayer>(10, 12 * 12 * 4, false));
+    Workspace convWorkspace = convNetwork.makeWorkspace(batchSize);
+    check("Network::trainStep (conv)", [&] { convNetwork.trainStep(sample, 3); }, calls);
+    check("Network::trainBatch (32, conv)", [&] { convNetwork.trainBatch(inputs, labels); }, calls);
+    check("Network::predictBatch (conv)",
+          [&] { convNetwork.predictBatch(inputs, probabilities, batchSize, convWorkspace); }, calls);
+    if (!dataFile.empty()) {
+        // Whole epochs through the training loop, including the batch source
+        Dataset data = Dataset::openCached(dataFile);
+        DatasetSource source(data, true);
+        check("Network::train epoch (batch 1)", [&] { network.train(source, 1, 1); }, 1);
+        check("Network::train epoch (batch 32)", [&] { network.train(source, 1, batchSize); }, 1);
+        // Int8 inference into caller-owned buffers
+        QuantizedNetwork quantized(network, data);
+        std::vector<float> quantizedOutput(quantized.getOutputSize());
+        std::vector<uint8_t> quantizedScratch(quantized.getScratchSize());
+        check("QuantizedNetwork::predict",
+              [&] { quantized.predict(data.getPixels(0), quantizedOutput, quantizedScratch); }, calls);
+        check("QuantizedNetwork::classify",
+              [&] { quantized.classify(data.getPixels(1), quantizedOutput, quantizedScratch); }, calls);
+    }
+    std::cout << (passed ? "No steady-state allocations" : "Steady-state allocations found") << std::endl;
+    return passed;
+}
+
+// Trains a 784-128-10 network with the tracer recording, then writes the trace and prints the summary
+bool Benchmark::traceTraining(const std::string& trainFile, const std::string& traceFile, int epochs, size_t batchSize) {
+    if (!Tracer::isCompiledIn()) {
+        std::cerr << "Tracing is not compiled in; rebuild with -DNN_ENABLE_TRACING" << std::endl;
+        return false;
+    }
+    Dataset trainData = Dataset::openCached(trainFile);
+    Network network({ static_cast<int>(trainData.getSampleSize()), 128, 10 }, 0.01);
+    Tracer::start();
+    network.train(trainData, epochs, batchSize);
+    Tracer::stop();
+    Tracer::writeChromeTrace(traceFile);
+    std::cout << "Wrote " << Tracer::getEvents().size() << " events to " << traceFile << std::endl;
+    Tracer::printSummary();
+    return true;
+}
+
+// Times op: calibrates the iteration count to about 50 ms per repetition, then keeps the best of 5
+Benchmark::Measurement Benchmark::measure(const std::function<void()>& op) {
+    using Clock = std::chrono::steady_clock;
+    const double targetSeconds = 0.05;
+    op(); // Warm up caches and lazily allocated buffers
+    Measurement result;
+    result.iterations = 1;
+    while (true) {
+        auto start = Clock::now();
+        for (size_t i = 0; i < result.iterations; ++i) {
+            op();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (seconds >= targetSeconds || result.iterations >= (size_t(1) << 30)) {
+            break;
+        }
+        result.iterations = std::max(result.iterations * 2,
+                                     static_cast<size_t>(result.iterations * targetSeconds / std::max(seconds, 1e-9)));
+    }
+    double best = 0.0;
+    for (int r = 0; r < 5; ++r) {
+        auto start = Clock::now();
+        for (size_t i = 0; i < result.iterations; ++i) {
+            op();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        best = r == 0 ? seconds : std::min(best, seconds);
+    }
+    result.nanoseconds = best * 1e9 / result.iterations;
+    return result;
+}
+
+// Prints one result row
+void Benchmark::printRow(const std::string& name, const std::string& shape, const Measurement& measurement,
+                         double samples, double flops, double bytes) {
+    double seconds = measurement.nanoseconds * 1e-9;
+    std::cout << std::left << std::setw(28) << name << std::setw(18) << shape << std::right << std::fixed
+              << std::setprecision(1) << std::setw(12) << measurement.nanoseconds << std::setprecision(0)
+              << std::setw(14) << samples / seconds << std::setprecision(2) << std::setw(10) << flops / seconds * 1e-9
+              << std::setw(10) << bytes / seconds * 1e-9 << std::defaultfloat << std::setprecision(6) << std::endl;
+}
+
+// Neuron::forward: one dot product over the neuron's weight row
+void Benchmark::benchmarkNeuronForward() {
+    for (int width : { 16, 64, 256, 784, 4096 }) {
+        std::vector<Scalar> weights = randomValues(width, 1);
+        std::vector<Scalar> inputs = randomValues(width, 2);
+        Neuron neuron(weights, 0.1, 0.0, 0.0);
+        Measurement m = measure([&] { sink = sink + neuron.forward(inputs); });
+        printRow("Neuron::forward", std::to_string(width), m, 1, 2.0 * width, 2.0 * width * sizeof(Scalar));
+    }
+}
+
+// Layer::forward (one sample) and Layer::forwardBatch over widths and batch sizes
+void Benchmark::benchmarkLayerForward() {
+    for (int width : WIDTHS) {
+        DenseLayer layer(width, INPUT_SIZE);
+        double parameters = static_cast<double>(width) * (INPUT_SIZE + 1);
+        std::vector<Scalar> inputs = randomValues(INPUT_SIZE, 3);
+        Measurement m = measure([&] { sink = sink + layer.forward(inputs)[0]; });
+        printRow("Layer::forward", std::to_string(INPUT_SIZE) + "x" + std::to_string(width), m, 1, 2.0 * parameters,
+                 (parameters + INPUT_SIZE + width) * sizeof(Scalar));
+
+        for (size_t batchSize : BATCH_SIZES) {
+            std::vector<Scalar> batchInputs = randomValues(batchSize * INPUT_SIZE, 4);
+            std::vector<Scalar> outputs(batchSize * width);
+            Measurement mb = measure([&] {
+                layer.forwardBatch(batchInputs, outputs, batchSize, {});
+                sink = sink + outputs[0];
+            });
+            printRow("Layer::forwardBatch", std::to_string(INPUT_SIZE) + "x" + std::to_string(width) + " b" +
+                     std::to_string(batchSize), mb, batchSize, 2.0 * parameters * batchSize,
+                     (parameters + batchSize * (INPUT_SIZE + width)) * sizeof(Scalar));
+        }
+    }
+}
+
+// Layer::computeGradients for a hidden layer followed by a 10-neuron output layer, and Layer::backwardBatch
+void Benchmark::benchmarkLayerGradients() {
+    const int nextWidth = 10;
+    for (int width : WIDTHS) {
+        DenseLayer layer(width, INPUT_SIZE);
+        DenseLayer next(nextWidth, width, false);
+        std::vector<Scalar> inputs = randomValues(INPUT_SIZE, 5);
+        layer.forward(inputs); // Sets the activations used by the ReLU mask
+        std::vector<Scalar> nextGradients = randomValues(nextWidth, 6);
+        Measurement m = measure([&] {
+            layer.computeGradients(nextGradients, next.getWeights(), false);
+            sink = sink + layer.getGradients()[0];
+        });
+        double nextParameters = static_cast<double>(nextWidth) * width;
+        printRow("Layer::computeGradients", std::to_string(width) + "<-" + std::to_string(nextWidth), m, 1,
+                 2.0 * nextParameters, (nextParameters + 2.0 * width + nextWidth) * sizeof(Scalar));
+
+        for (size_t batchSize : BATCH_SIZES) {
+            std::vector<Scalar> batchInputs = randomValues(batchSize * INPUT_SIZE, 7);
+            std::vector<Scalar> outputs(batchSize * width);
+            layer.forwardBatch(batchInputs, outputs, batchSize, {});
+            std::vector<Scalar> upstream = randomValues(batchSize * width, 8);
+            std::vector<Scalar> deltas(batchSize * width);
+            std::vector<Scalar> weightGradients(static_cast<size_t>(width) * INPUT_SIZE);
+            std::vector<Scalar> biasGradients(width);
+            Measurement mb = measure([&] {
+                std::copy(upstream.begin(), upstream.end(), deltas.begin());
+                layer.backwardBatch(batchInputs, outputs, deltas, {}, weightGradients, biasGradients, batchSize, {});
+                sink = sink + biasGradients[0];
+            });
+            // Active units only: about half are masked by ReLU, which backwardBatch skips
+            double parameters = static_cast<double>(width) * INPUT_SIZE;
+            printRow("Layer::backwardBatch", std::to_string(INPUT_SIZE) + "x" + std::to_string(width) + " b" +
+                     std::to_string(batchSize), mb, batchSize, 2.0 * parameters * batchSize,
+                     (2.0 * parameters + batchSize * (INPUT_SIZE + 2.0 * width)) * sizeof(Scalar));
+        }
+    }
+}
+
+// Dense against sparse first-layer kernels (compression included) over input densities, for a 784x256 layer.
+// Work is counted as for the dense kernels, so GFLOP/s of the sparse rows are dense-equivalent
+void Benchmark::benchmarkSparseFirstLayer() {
+    const int width = 256;
+    const size_t batchSize = 32;
+    double parameters = static_cast<double>(width) * INPUT_SIZE;
+    for (double density : DENSITIES) {
+        std::ostringstream shape;
+        shape << INPUT_SIZE << "x" << width << " d" << std::fixed << std::setprecision(2) << density;
+        DenseLayer layer(width, INPUT_SIZE);
+        SparseInputs sparse;
+        std::vector<Scalar> inputs = sparseRandomValues(INPUT_SIZE, density, 21);
+        Measurement dense = measure([&] { sink = sink + layer.forward(inputs)[0]; });
+        Measurement compressed = measure([&] {
+            sparse.compress(inputs, 1, INPUT_SIZE);
+            sink = sink + layer.forward(sparse)[0];
+        });
+        printRow("forward dense", shape.str(), dense, 1, 2.0 * parameters, parameters * sizeof(Scalar));
+        printRow("forward sparse", shape.str(), compressed, 1, 2.0 * parameters, parameters * sizeof(Scalar));
+
+        // Tiny learning rate so repeated updates leave the weights essentially unchanged
+        Measurement denseUpdate = measure([&] { layer.updateWeights(inputs, 1e-12); });
+        Measurement sparseUpdate = measure([&] {
+            sparse.compress(inputs, 1, INPUT_SIZE);
+            layer.updateWeights(sparse, 1e-12);
+        });
+        printRow("updateWeights dense", shape.str(), denseUpdate, 1, 2.0 * parameters, 2.0 * parameters * sizeof(Scalar));
+        printRow("updateWeights sparse", shape.str(), sparseUpdate, 1, 2.0 * parameters, 2.0 * parameters * sizeof(Scalar));
+
+        std::vector<Scalar> batchInputs = sparseRandomValues(batchSize * INPUT_SIZE, density, 22);
+        std::vector<Scalar> outputs(batchSize * width);
+        std::vector<Scalar> upstream = randomValues(batchSize * width, 23);
+        std::vector<Scalar> deltas(batchSize * width);
+        std::vector<Scalar> weightGradients(static_cast<size_t>(width) * INPUT_SIZE);
+        std::vector<Scalar> biasGradients(width);
+        std::string batchShape = shape.str() + " b" + std::to_string(batchSize);
+        Measurement denseBatch = measure([&] {
+            layer.forwardBatch(batchInputs, outputs, batchSize, {});
+            std::copy(upstream.begin(), upstream.end(), deltas.begin());
+            layer.backwardBatch(batchInputs, outputs, deltas, {}, weightGradients, biasGradients, batchSize, {});
+            sink = sink + biasGradients[0];
+        });
+        Measurement sparseBatch = measure([&] {
+            sparse.compress(batchInputs, batchSize, INPUT_SIZE);
+            layer.forwardBatch(sparse, outputs, batchSize);
+            std::copy(upstream.begin(), upstream.end(), deltas.begin());
+            layer.backwardBatch(sparse, outputs, deltas, weightGradients, biasGradients, batchSize);
+            sink = sink + biasGradients[0];
+        });
+        printRow("fwd+bwd batch dense", batchShape, denseBatch, batchSize, 4.0 * parameters * batchSize,
+                 2.0 * parameters * sizeof(Scalar));
+        printRow("fwd+bwd batch sparse", batchShape, sparseBatch, batchSize, 4.0 * parameters * batchSize,
+                 2.0 * parameters * sizeof(Scalar));
+    }
+}
+
+// Network::forward and Network::predictBatch on 784-width-10 networks
+void Benchmark::benchmarkNetworkForward() {
+    for (int width : WIDTHS) {
+        Network network({ INPUT_SIZE, width, 10 }, 0.01);
+        double parameters = static_cast<double>(width) * (INPUT_SIZE + 1) + 10.0 * (width + 1);
+        std::string shape = std::to_string(INPUT_SIZE) + "-" + std::to_string(width) + "-10";
+        std::vector<Scalar> inputs = randomValues(INPUT_SIZE, 9);
+        Measurement m = measure([&] { sink = sink + network.forward(inputs)[0]; });
+        printRow("Network::forward", shape, m, 1, 2.0 * parameters, (parameters + INPUT_SIZE) * sizeof(Scalar));
+
+        for (size_t batchSize : BATCH_SIZES) {
+            std::vector<Scalar> batchInputs = randomValues(batchSize * INPUT_SIZE, 10);
+            std::vector<Scalar> probabilities(batchSize * 10);
+            Measurement mb = measure([&] {
+                network.predictBatch(batchInputs, probabilities, batchSize);
+                sink = sink + probabilities[0];
+            });
+            printRow("Network::predictBatch", shape + " b" + std::to_string(batchSize), mb, batchSize,
+                     2.0 * parameters * batchSize, (parameters + batchSize * INPUT_SIZE) * sizeof(Scalar));
+        }
+    }
+}
+
+// Network::backpropagate (per-sample SGD) and Network::trainBatch on 784-width-10 networks.
+// A training step costs about 6 flops per parameter (forward, backward and update) and reads and writes every parameter
+void Benchmark::benchmarkNetworkTraining() {
+    for (int width : WIDTHS) {
+        Network network({ INPUT_SIZE, width, 10 }, 0.001);
+        double parameters = static_cast<double>(width) * (INPUT_SIZE + 1) + 10.0 * (width + 1);
+        std::string shape = std::to_string(INPUT_SIZE) + "-" + std::to_string(width) + "-10";
+        std::vector<Scalar> inputs = randomValues(INPUT_SIZE, 11);
+        Measurement m = measure([&] { network.backpropagate(inputs, 3); });
+        printRow("Network::backpropagate", shape, m, 1, 6.0 * parameters, 3.0 * parameters * sizeof(Scalar));
+
+        for (size_t batchSize : BATCH_SIZES) {
+            std::vector<Scalar> batchInputs = randomValues(batchSize * INPUT_SIZE, 12);
+            std::vector<int> labels(batchSize);
+            for (size_t b = 0; b < batchSize; ++b) {
+                labels[b] = static_cast<int>(b % 10);
+            }
+            Measurement mb = measure([&] { sink = sink + network.trainBatch(batchInputs, labels); });
+            printRow("Network::trainBatch", shape + " b" + std::to_string(batchSize), mb, batchSize,
+                     6.0 * parameters * batchSize, (5.0 * parameters + batchSize * INPUT_SIZE) * sizeof(Scalar));
+        }
+    }
+}
+
+// Measures CSV parsing, binary cache loading and normalization of a dataset file
+void Benchmark::benchmarkDatasetLoading(const std::string& filename) {
+    double csvBytes = static_cast<double>(std::filesystem::file_size(filename));
+    size_t numSamples = 0;
+    Measurement parse = measure([&] { numSamples = Dataset(filename).getNumSamples(); });
+    printRow("Dataset CSV parse", std::to_string(numSamples), parse, numSamples, 0.0, csvBytes);
+
+    // Binary cache: mapping it is nearly free, so also time a full pass over the pixels
+    std::string cacheFile = filename + ".bench.nnds";
+    Dataset(filename).save(cacheFile);
+    double cacheBytes = static_cast<double>(std::filesystem::file_size(cacheFile));
+    Measurement open = measure([&] { sink = sink + Dataset(cacheFile).getLabel(0); });
+    printRow("Dataset binary open", std::to_string(numSamples), open, numSamples, 0.0, cacheBytes);
+
+    Dataset cached(cacheFile);
+    std::vector<Scalar> batch(numSamples * cached.getSampleSize());
+    Measurement normalize = measure([&] {
+        cached.getBatch(0, numSamples, batch);
+        sink = sink + batch[0];
+    });
+    printRow("Dataset::getBatch (all)", std::to_string(numSamples), normalize, numSamples, 0.0,
+             numSamples * cached.getSampleSize() * (1.0 + sizeof(Scalar)));
+    std::filesystem::remove(cacheFile);
+}
@@ -0,0 +1,81 @@
+//
+//  Benchmark.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef Benchmark_hpp
+#define Benchmark_hpp
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Headless benchmarks, run from the command line with "neuralNetworks bench ..."
+class Benchmark {
+public:
+    // Runs the benchmark selected by the arguments (after "bench"); returns the process exit code
+    static int run(const std::vector<std::string>& args);
+
+private:
+    // Timing of one operation (best of several repetitions)
+    struct Measurement {
+        double nanoseconds = 0.0;   // Time per operation
+        size_t iterations = 0;      // Operations per repetition
+    };
+
+    // Times op, repeating it until each repetition lasts long enough to be measured reliably
+    static Measurement measure(const std::function<void()>& op);
+
+    // Prints one result row. Work per operation is given as samples, floating-point operations
+    // and the minimum number of bytes moved (parameters and activations read or written once)
+    static void printRow(const std::string& name, const std::string& shape, const Measurement& measurement,
+                         double samples, double flops, double bytes);
+
+    // Sweeps of the numeric hot paths over layer widths and batch sizes
+    static void benchmarkNeuronForward();
+    static void benchmarkLayerForward();
+    static void benchmarkLayerGradients();
+    static void benchmarkSparseFirstLayer();
+    static void benchmarkNetworkForward();
+    static void benchmarkNetworkTraining();
+
+    // Measures CSV parsing and binary cache loading of a dataset file
+    static void benchmarkDatasetLoading(const std::string& filename);
+
+    // Measures CSV parsing throughput of the Dataset loader in MB/s
+    static void benchmarkCSVParser(const std::string& filename, int repetitions);
+
+    // Trains a network, quantizes it to int8 and reports accuracy and latency of both models
+    static void benchmarkQuantization(const std::string& trainFile, const std::string& testFile, int epochs);
+
+    // Trains the same initial network with every optimizer and reports the epochs and time each one needs
+    // to reach targetAccuracy on the test set, plus its final accuracy
+    static void benchmarkOptimizers(const std::string& trainFile, const std::string& testFile, int epochs,
+                                    size_t batchSize, double targetAccuracy);
+
+    // Trains the same initial network for a fixed number of epochs and with the TrainingController
+    // (validation split, cosine schedule with warmup, early stopping), and compares time and test accuracy
+    static void benchmarkTrainingController(const std::string& trainFile, const std::string& testFile, int maxEpochs,
+                                            size_t batchSize);
+
+    // Trains dense and convolutional networks on the same data and compares test accuracy, parameter count
+    // and inference time per sample, batched and one sample at a time
+    static void benchmarkConvolution(const std::string& trainFile, const std::string& testFile, int epochs,
+                                     size_t batchSize);
+
+    // Runs the checks of the test build: the SIMD kernel self-test, then checkAllocations.
+    // Returns false if either fails
+    static bool runTests(const std::string& dataFile);
+
+    // Counts heap allocations made by the calling thread during steady-state training and inference steps.
+    // Returns false if any step allocates or the build does not count allocations (-DNN_COUNT_ALLOCATIONS)
+    static bool checkAllocations(const std::string& dataFile);
+
+    // Trains with the tracer recording, writes a Chrome trace and prints the per-layer summary.
+    // Returns false if the build does not include tracing (-DNN_ENABLE_TRACING)
+    static bool traceTraining(const std::string& trainFile, const std::string& traceFile, int epochs, size_t batchSize);
+};
+
+#endif /* Benchmark_hpp */
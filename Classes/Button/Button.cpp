@@ -16,14 +16,12 @@ Button::Button(float x, float y, float width, float height, const std::string& l
     shape.setOutlineThickness(1.0f);
 
     text.setFont(font);
-    text.setString(label);
     text.setCharacterSize(16);
     text.setFillColor(sf::Color::Black);
 
     // Center the text within the button
-    sf::FloatRect textBounds = text.getLocalBounds();
-    text.setOrigin(textBounds.left + textBounds.width / 2.0f, textBounds.top + textBounds.height / 2.0f);
     text.setPosition(x + width / 2.0f, y + height / 2.0f);
+    setLabel(label);
 }
 
 // Checks if the button is clicked based on mouse position
@@ -36,6 +34,13 @@ void Button::setFillColor(const sf::Color& color) {
     shape.setFillColor(color);
 }
 
+// Replaces the label, keeping it centered on the button
+void Button::setLabel(const std::string& label) {
+    text.setString(label);
+    sf::FloatRect textBounds = text.getLocalBounds();
+    text.setOrigin(textBounds.left + textBounds.width / 2.0f, textBounds.top + textBounds.height / 2.0f);
+}
+
 // Draws the button and its text to the render target
 void Button::draw(sf::RenderTarget& target, sf::RenderStates states) const {
     target.draw(shape, states);
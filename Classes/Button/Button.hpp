@@ -23,6 +23,9 @@ public:
     // Sets the fill color of the button's shape
     void setFillColor(const sf::Color& color);
 
+    // Replaces the label, keeping it centered
+    void setLabel(const std::string& label);
+
 private:
     // Draws the button and its text to the render target
     void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
@@ -0,0 +1,86 @@
+//
+//  ConnectionView.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "ConnectionView.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+// Color of a weight: blue when positive, red when negative, with opacity growing with |weight| / maxAbs
+sf::Color weightColor(Scalar weight, float maxAbs) {
+    float amount = std::min(std::abs(static_cast<float>(weight)) / maxAbs, 1.0f);
+    sf::Uint8 alpha = static_cast<sf::Uint8>(20.0f + 235.0f * amount);
+    return weight >= 0 ? sf::Color(30, 90, 220, alpha) : sf::Color(220, 40, 40, alpha);
+}
+
+} // namespace
+
+// Constructor: Lays out the edges; with few enough edges their positions never change again
+ConnectionView::ConnectionView(std::vector<sf::Vector2f> sources, std::vector<sf::Vector2f> targets, size_t maxEdges)
+    : sources(std::move(sources)), targets(std::move(targets)), maxEdges(maxEdges), lines(sf::Lines) {
+    size_t numEdges = this->sources.size() * this->targets.size();
+    lines.resize(2 * std::min(numEdges, maxEdges));
+    if (numEdges > maxEdges) {
+        order.resize(numEdges);
+    }
+    for (size_t slot = 0; slot < getNumDrawnEdges(); ++slot) {
+        setEdge(slot, slot, sf::Color(0, 0, 0, 60));
+    }
+}
+
+// Recolors the edges, or reselects the strongest ones when they do not all fit
+void ConnectionView::setWeights(std::span<const Scalar> weights) {
+    if (weights.size() != sources.size() * targets.size()) {
+        throw std::invalid_argument("Weight count does not match the connections");
+    }
+    float maxAbs = 0.0f;
+    for (Scalar weight : weights) {
+        maxAbs = std::max(maxAbs, std::abs(static_cast<float>(weight)));
+    }
+    if (maxAbs == 0.0f) {
+        maxAbs = 1.0f;
+    }
+
+    if (order.empty()) {
+        // Every edge is drawn in slot = edge index: only the colors change
+        for (size_t i = 0; i < weights.size(); ++i) {
+            sf::Color color = weightColor(weights[i], maxAbs);
+            lines[2 * i].color = color;
+            lines[2 * i + 1].color = color;
+        }
+        return;
+    }
+
+    // Too many edges: draw the maxEdges largest weights, which carry most of the signal
+    std::iota(order.begin(), order.end(), uint32_t(0));
+    std::nth_element(order.begin(), order.begin() + maxEdges, order.end(), [&](uint32_t a, uint32_t b) {
+        return std::abs(weights[a]) > std::abs(weights[b]);
+    });
+    for (size_t slot = 0; slot < maxEdges; ++slot) {
+        setEdge(slot, order[slot], weightColor(weights[order[slot]], maxAbs));
+    }
+}
+
+// Getter: Returns the number of edges drawn
+size_t ConnectionView::getNumDrawnEdges() const {
+    return lines.getVertexCount() / 2;
+}
+
+// Draws the line list to the render target
+void ConnectionView::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    target.draw(lines, states);
+}
+
+// Writes edge `index` (target * sources + source) into line slot `slot`
+void ConnectionView::setEdge(size_t slot, size_t index, sf::Color color) {
+    lines[2 * slot] = sf::Vertex(sources[index % sources.size()], color);
+    lines[2 * slot + 1] = sf::Vertex(targets[index / sources.size()], color);
+}
@@ -0,0 +1,47 @@
+//
+//  ConnectionView.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef ConnectionView_hpp
+#define ConnectionView_hpp
+
+#include "Scalar.hpp"
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Connections between two neuron columns, drawn as one line list colored by the weights:
+// blue for positive, red for negative, more opaque the larger the weight relative to the largest one.
+// Up to maxEdges edges are all drawn; above that only the maxEdges strongest are, so the cost of a frame
+// and of a weight update stays bounded however wide the layers are. Vertices are only touched by setWeights()
+class ConnectionView : public sf::Drawable {
+public:
+    // Constructor: Edges from every source point to every target point, all drawn in gray until setWeights()
+    ConnectionView(std::vector<sf::Vector2f> sources, std::vector<sf::Vector2f> targets, size_t maxEdges = 4096);
+
+    // Recolors (and, above maxEdges, reselects) the edges for a row-major targets x sources weight matrix.
+    // Throws: std::invalid_argument if the matrix size does not match
+    void setWeights(std::span<const Scalar> weights);
+
+    // Getter: Returns the number of edges drawn
+    size_t getNumDrawnEdges() const;
+
+private:
+    // Draws the line list to the render target
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+    // Writes edge `index` (target * sources + source) into line slot `slot`
+    void setEdge(size_t slot, size_t index, sf::Color color);
+
+    std::vector<sf::Vector2f> sources;  // Right-hand anchor of each source neuron
+    std::vector<sf::Vector2f> targets;  // Left-hand anchor of each target neuron
+    size_t maxEdges;                    // Edges drawn at most
+    sf::VertexArray lines;              // Two vertices per drawn edge
+    std::vector<uint32_t> order;        // Edge indices, partially sorted by weight size (sampled mode only)
+};
+
+#endif /* ConnectionView_hpp */
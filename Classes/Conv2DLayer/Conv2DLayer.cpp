@@ -0,0 +1,343 @@
+//
+//  Conv2DLayer.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "Conv2DLayer.hpp"
+#include "Kernels.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace {
+
+// Scratch budget of one tile of output positions: column matrix, products and column deltas stay in L2
+const size_t TILE_BYTES = 64 * 1024;
+
+// Output shape of a convolution; throws std::invalid_argument if the settings are out of range
+Layer::Shape convolvedShape(const Layer::Shape& input, int numFilters, int kernelSize, int stride, int padding) {
+    if (input.height <= 0 || input.width <= 0 || input.channels <= 0 || numFilters <= 0 || kernelSize <= 0 ||
+        stride <= 0 || padding < 0) {
+        throw std::invalid_argument("Convolution dimensions must be positive");
+    }
+    if (kernelSize > input.height + 2 * padding || kernelSize > input.width + 2 * padding) {
+        throw std::invalid_argument("Convolution kernel is larger than the padded input");
+    }
+    return { (input.height + 2 * padding - kernelSize) / stride + 1,
+             (input.width + 2 * padding - kernelSize) / stride + 1, numFilters };
+}
+
+// Floor of a / b for b > 0
+int floorDiv(int a, int b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// Range [begin, end) of t in [0, count) for which x = (first + t) * stride + offset lies in [0, limit),
+// so the copy loops run without per-element bounds checks
+void validRange(size_t first, size_t count, int stride, int offset, int limit, size_t& begin, size_t& end) {
+    int base = static_cast<int>(first) * stride + offset;
+    int lo = std::max(0, floorDiv(-base + stride - 1, stride));
+    int hi = std::min(static_cast<int>(count), floorDiv(limit - 1 - base, stride) + 1);
+    begin = static_cast<size_t>(std::min(lo, static_cast<int>(count)));
+    end = std::max(begin, static_cast<size_t>(std::max(hi, 0)));
+}
+
+} // namespace
+
+// Constructor: Weights are drawn uniformly from +-sqrt(6 / patch size) (He initialization) and biases start at 0,
+// so the outputs keep the scale of the inputs whatever the kernel size
+Conv2DLayer::Conv2DLayer(const Shape& inputShape, int numFilters, int kernelSize, int stride, int padding,
+                         bool useReLU)
+    : inputShape(inputShape), outputShape(convolvedShape(inputShape, numFilters, kernelSize, stride, padding)),
+      kernelSize(kernelSize), stride(stride), padding(padding), layerUseReLU(useReLU) {
+    double limit = std::sqrt(6.0 / getPatchSize());
+    ownedWeights.resize(numFilters * getPatchSize());
+    for (Scalar& weight : ownedWeights) {
+        weight = static_cast<Scalar>(distribution(generator) * limit);
+    }
+    ownedBiases.assign(numFilters, Scalar(0));
+    bindOwned();
+}
+
+// Constructor: Uses external parameters in place
+Conv2DLayer::Conv2DLayer(const Shape& inputShape, int numFilters, int kernelSize, int stride, int padding,
+                         bool useReLU, std::span<Scalar> weights, std::span<Scalar> biases,
+                         std::shared_ptr<void> storage)
+    : Layer(weights, biases, std::move(storage)),
+      inputShape(inputShape), outputShape(convolvedShape(inputShape, numFilters, kernelSize, stride, padding)),
+      kernelSize(kernelSize), stride(stride), padding(padding), layerUseReLU(useReLU) {
+    if (weights.size() != numFilters * getPatchSize() || biases.size() != static_cast<size_t>(numFilters)) {
+        throw std::invalid_argument("Parameter sizes do not match layer dimensions");
+    }
+}
+
+// Returns a copy that owns its parameters
+std::unique_ptr<Layer> Conv2DLayer::clone() const {
+    return std::make_unique<Conv2DLayer>(*this);
+}
+
+// Getter: Returns the layer type
+Layer::Type Conv2DLayer::getType() const {
+    return Type::Conv2D;
+}
+
+// Getter: Returns the input image shape
+Layer::Shape Conv2DLayer::getInputShape() const {
+    return inputShape;
+}
+
+// Getter: Returns the output image shape
+Layer::Shape Conv2DLayer::getOutputShape() const {
+    return outputShape;
+}
+
+// Getter: Returns whether the layer applies ReLU
+bool Conv2DLayer::usesReLU() const {
+    return layerUseReLU;
+}
+
+// One-line description of the layer
+std::string Conv2DLayer::describe() const {
+    return "Conv2D " + inputShape.toString() + " -> " + outputShape.toString() + ", " + std::to_string(kernelSize) +
+           "x" + std::to_string(kernelSize) + " stride " + std::to_string(stride) + " padding " +
+           std::to_string(padding) + (layerUseReLU ? ", ReLU" : "");
+}
+
+// Number of values in one receptive field
+size_t Conv2DLayer::getPatchSize() const {
+    return static_cast<size_t>(kernelSize) * kernelSize * inputShape.channels;
+}
+
+// Number of output positions per image
+size_t Conv2DLayer::getNumPositions() const {
+    return static_cast<size_t>(outputShape.height) * outputShape.width;
+}
+
+// Rows (output positions) per tile: as many as fit the tile budget, at least 16
+size_t Conv2DLayer::getTileRows(size_t rows) const {
+    size_t bytesPerRow = (2 * getPatchSize() + outputShape.channels) * sizeof(Scalar);
+    return std::min(rows, std::max<size_t>(TILE_BYTES / bytesPerRow, 16));
+}
+
+// Scratch for one tile: the column matrix and the filter-major outputs; the backward pass adds the column deltas
+// and the transposed weights
+size_t Conv2DLayer::getScratchSize(size_t batchSize) const {
+    return getTileRows(batchSize * getNumPositions()) * (2 * getPatchSize() + outputShape.channels) +
+           getPatchSize() * outputShape.channels;
+}
+
+// Fills the column matrix of rows [firstRow, firstRow + numRows) of the batch (row = sample x positions + position):
+// row k of columns holds, for each of those output positions, the input value under kernel element
+// k = (kernel row, kernel column, channel), or 0 where the kernel covers the padding
+void Conv2DLayer::im2col(const Scalar* inputs, Scalar* columns, size_t firstRow, size_t numRows) const {
+    size_t positions = getNumPositions();
+    size_t channels = inputShape.channels;
+    size_t outputWidth = outputShape.width;
+    for (int ky = 0; ky < kernelSize; ++ky) {
+        for (int kx = 0; kx < kernelSize; ++kx) {
+            for (size_t c = 0; c < channels; ++c, columns += numRows) {
+                size_t b = firstRow / positions;
+                size_t oy = firstRow % positions / outputWidth;
+                size_t ox = firstRow % outputWidth;
+                // One run of output positions on the same output row at a time
+                for (size_t n = 0; n < numRows;) {
+                    size_t count = std::min(outputWidth - ox, numRows - n);
+                    int iy = static_cast<int>(oy) * stride - padding + ky;
+                    Scalar* out = columns + n;
+                    if (iy < 0 || iy >= inputShape.height) {
+                        std::fill_n(out, count, Scalar(0));
+                    }
+                    else {
+                        size_t begin, end;
+                        validRange(ox, count, stride, kx - padding, inputShape.width, begin, end);
+                        const Scalar* line = inputs + b * inputShape.size() +
+                                             static_cast<size_t>(iy) * inputShape.width * channels + c;
+                        std::ptrdiff_t offset = (static_cast<std::ptrdiff_t>(ox) * stride + kx - padding) *
+                                                static_cast<std::ptrdiff_t>(channels);
+                        std::ptrdiff_t step = static_cast<std::ptrdiff_t>(stride) * channels;
+                        std::fill_n(out, begin, Scalar(0));
+                        for (size_t t = begin; t < end; ++t) {
+                            out[t] = line[offset + static_cast<std::ptrdiff_t>(t) * step];
+                        }
+                        std::fill_n(out + end, count - end, Scalar(0));
+                    }
+                    n += count;
+                    ox += count;
+                    if (ox == outputWidth) {
+                        ox = 0;
+                        if (++oy == static_cast<size_t>(outputShape.height)) {
+                            oy = 0;
+                            ++b;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Adds every entry of the column matrix of rows [firstRow, firstRow + numRows) back onto the pixel it was
+// copied from; padding is dropped
+void Conv2DLayer::col2im(const Scalar* columns, Scalar* inputs, size_t firstRow, size_t numRows) const {
+    size_t positions = getNumPositions();
+    size_t channels = inputShape.channels;
+    size_t outputWidth = outputShape.width;
+    for (int ky = 0; ky < kernelSize; ++ky) {
+        for (int kx = 0; kx < kernelSize; ++kx) {
+            for (size_t c = 0; c < channels; ++c, columns += numRows) {
+                size_t b = firstRow / positions;
+                size_t oy = firstRow % positions / outputWidth;
+                size_t ox = firstRow % outputWidth;
+                for (size_t n = 0; n < numRows;) {
+                    size_t count = std::min(outputWidth - ox, numRows - n);
+                    int iy = static_cast<int>(oy) * stride - padding + ky;
+                    if (iy >= 0 && iy < inputShape.height) {
+                        size_t begin, end;
+                        validRange(ox, count, stride, kx - padding, inputShape.width, begin, end);
+                        const Scalar* in = columns + n;
+                        Scalar* line = inputs + b * inputShape.size() +
+                                       static_cast<size_t>(iy) * inputShape.width * channels + c;
+                        std::ptrdiff_t offset = (static_cast<std::ptrdiff_t>(ox) * stride + kx - padding) *
+                                                static_cast<std::ptrdiff_t>(channels);
+                        std::ptrdiff_t step = static_cast<std::ptrdiff_t>(stride) * channels;
+                        for (size_t t = begin; t < end; ++t) {
+                            line[offset + static_cast<std::ptrdiff_t>(t) * step] += in[t];
+                        }
+                    }
+                    n += count;
+                    ox += count;
+                    if (ox == outputWidth) {
+                        ox = 0;
+                        if (++oy == static_cast<size_t>(outputShape.height)) {
+                            oy = 0;
+                            ++b;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Batched forward pass, one tile of output positions at a time. Filters are few and positions many, so within
+// a tile each filter's row of the product is one fused multi-axpy over the column matrix (the weights of the
+// filter times its rows), then the product is transposed to channels-last
+void Conv2DLayer::forwardBatch(std::span<const Scalar> inputs, std::span<Scalar> outputs, size_t batchSize,
+                               std::span<Scalar> scratch) const {
+    size_t rows = batchSize * getNumPositions();
+    size_t tileRows = getTileRows(rows);
+    size_t patchSize = getPatchSize();
+    size_t numFilters = outputShape.channels;
+    if (inputs.size() < batchSize * inputShape.size() || outputs.size() < batchSize * outputShape.size() ||
+        scratch.size() < tileRows * (patchSize + numFilters)) {
+        throw std::invalid_argument("Batch buffers are too small for layer");
+    }
+    Scalar* columns = scratch.data();
+    Scalar* products = columns + tileRows * patchSize;
+    for (size_t first = 0; first < rows; first += tileRows) {
+        size_t count = std::min(tileRows, rows - first);
+        im2col(inputs.data(), columns, first, count);
+        // products (filters x positions) = W * columns + b
+        for (size_t f = 0; f < numFilters; ++f) {
+            Scalar* product = products + f * count;
+            std::fill_n(product, count, biases[f]);
+            Kernels::multiAxpy(weights.data() + f * patchSize, columns, count, patchSize, product, count);
+        }
+        // Transpose to one row of filter outputs per position, applying the activation
+        Scalar* out = outputs.data() + first * numFilters;
+        for (size_t r = 0; r < count; ++r) {
+            for (size_t f = 0; f < numFilters; ++f) {
+                Scalar z = products[f * count + r];
+                out[r * numFilters + f] = layerUseReLU && z < 0 ? Scalar(0) : z;
+            }
+        }
+    }
+}
+
+// Batched backward pass, one tile of output positions at a time over the column matrix (rebuilt rather than kept
+// from the forward pass, so backward only depends on its arguments):
+// dW += delta * columns^T, db += sum(delta), dcolumns = W^T * delta
+void Conv2DLayer::backwardBatch(std::span<const Scalar> inputs, std::span<const Scalar> outputs,
+                                std::span<Scalar> deltas, std::span<Scalar> inputDeltas,
+                                std::span<Scalar> weightGradients, std::span<Scalar> biasGradients, size_t batchSize,
+                                std::span<Scalar> scratch) const {
+    size_t rows = batchSize * getNumPositions();
+    size_t tileRows = getTileRows(rows);
+    size_t patchSize = getPatchSize();
+    size_t numFilters = outputShape.channels;
+    bool propagate = !inputDeltas.empty();
+    if (scratch.size() < getScratchSize(batchSize) || (propagate && inputDeltas.size() < batchSize * inputShape.size())) {
+        throw std::invalid_argument("Batch buffers are too small for layer");
+    }
+    Scalar* columns = scratch.data();
+    Scalar* filterDeltas = columns + tileRows * patchSize;
+    Scalar* columnDeltas = filterDeltas + tileRows * numFilters;
+    Scalar* transposedWeights = columnDeltas + tileRows * patchSize;
+    if (propagate) {
+        // W^T, so the weights of one kernel element across all filters are contiguous
+        for (size_t f = 0; f < numFilters; ++f) {
+            for (size_t k = 0; k < patchSize; ++k) {
+                transposedWeights[k * numFilters + f] = weights[f * patchSize + k];
+            }
+        }
+    }
+    // dL/dz = dL/da * ReLU'(z); since a = ReLU(z), the derivative is 1 where a > 0
+    if (layerUseReLU) {
+        Kernels::reluMask(deltas.data(), outputs.data(), rows * numFilters);
+    }
+    if (propagate) {
+        std::fill_n(inputDeltas.data(), batchSize * inputShape.size(), Scalar(0));
+    }
+    for (size_t first = 0; first < rows; first += tileRows) {
+        size_t count = std::min(tileRows, rows - first);
+        // Filter-major deltas, so every filter's deltas over the tile are one contiguous row
+        const Scalar* delta = deltas.data() + first * numFilters;
+        for (size_t r = 0; r < count; ++r) {
+            for (size_t f = 0; f < numFilters; ++f) {
+                filterDeltas[f * count + r] = delta[r * numFilters + f];
+            }
+        }
+        im2col(inputs.data(), columns, first, count);
+        for (size_t f = 0; f < numFilters; ++f) {
+            const Scalar* filterDelta = filterDeltas + f * count;
+            Accumulator sum = 0.0;
+            for (size_t r = 0; r < count; ++r) {
+                sum += filterDelta[r];
+            }
+            biasGradients[f] += static_cast<Scalar>(sum);
+            for (size_t k = 0; k < patchSize; ++k) {
+                weightGradients[f * patchSize + k] += Kernels::dot(filterDelta, columns + k * count, count);
+            }
+        }
+        if (propagate) {
+            std::fill_n(columnDeltas, count * patchSize, Scalar(0));
+            for (size_t k = 0; k < patchSize; ++k) {
+                Kernels::multiAxpy(transposedWeights + k * numFilters, filterDeltas, count, numFilters,
+                                   columnDeltas + k * count, count);
+            }
+            col2im(columnDeltas, inputDeltas.data(), first, count);
+        }
+    }
+}
+
+// Getter: Returns the number of filters (output channels)
+int Conv2DLayer::getNumFilters() const {
+    return outputShape.channels;
+}
+
+// Getter: Returns the side of the square kernel
+int Conv2DLayer::getKernelSize() const {
+    return kernelSize;
+}
+
+// Getter: Returns the step between output positions
+int Conv2DLayer::getStride() const {
+    return stride;
+}
+
+// Getter: Returns the zero padding on every side
+int Conv2DLayer::getPadding() const {
+    return padding;
+}
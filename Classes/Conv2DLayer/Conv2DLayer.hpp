@@ -0,0 +1,85 @@
+//
+//  Conv2DLayer.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef Conv2DLayer_hpp
+#define Conv2DLayer_hpp
+
+#include "Layer.hpp"
+
+// 2D convolution over channels-last images, computed as im2col plus a matrix product on the same
+// dot and axpy kernels as the dense layers. The receptive fields (kernelSize x kernelSize pixels, all channels)
+// of a tile of output positions (a few hundred, across the samples of the batch) are copied into a column matrix
+// with one row per kernel element, so the product with the numFilters x patchSize weight matrix runs as fused
+// multi-axpys over long rows while the tile stays in cache. The tile buffers live in the caller's scratch.
+class Conv2DLayer : public Layer {
+private:
+    Shape inputShape;   // Input image: height x width x channels
+    Shape outputShape;  // Output image: one channel per filter
+    int kernelSize;     // Side of the square kernel
+    int stride;         // Step between neighboring output positions
+    int padding;        // Zero pixels added on every side of the input
+    bool layerUseReLU;  // Flag to determine if the outputs go through ReLU
+
+    // Number of values in one receptive field (one row of the column matrix and of the weight matrix)
+    size_t getPatchSize() const;
+
+    // Number of output positions per image
+    size_t getNumPositions() const;
+
+    // Number of output positions processed together for a batch of `rows` positions
+    size_t getTileRows(size_t rows) const;
+
+    // Copies the receptive fields of output positions [firstRow, firstRow + numRows) of the batch into columns
+    // (patchSize rows of numRows values)
+    void im2col(const Scalar* inputs, Scalar* columns, size_t firstRow, size_t numRows) const;
+
+    // Adds every row of columns back onto the pixels it was copied from (the adjoint of im2col)
+    void col2im(const Scalar* columns, Scalar* inputs, size_t firstRow, size_t numRows) const;
+
+public:
+    // Constructor: numFilters filters of kernelSize x kernelSize over inputShape images, initialized randomly.
+    // Throws std::invalid_argument if the kernel does not fit the padded input
+    Conv2DLayer(const Shape& inputShape, int numFilters, int kernelSize, int stride = 1, int padding = 0,
+                bool useReLU = true);
+
+    // Constructor: Uses parameters held elsewhere in place (numFilters x patch weights, numFilters biases);
+    // storage keeps that memory alive for the lifetime of the layer
+    Conv2DLayer(const Shape& inputShape, int numFilters, int kernelSize, int stride, int padding, bool useReLU,
+                std::span<Scalar> weights, std::span<Scalar> biases, std::shared_ptr<void> storage);
+
+    // Copies always own their parameters
+    Conv2DLayer(const Conv2DLayer& other) = default;
+
+    // Layer interface
+    std::unique_ptr<Layer> clone() const override;
+    Type getType() const override;
+    Shape getInputShape() const override;
+    Shape getOutputShape() const override;
+    bool usesReLU() const override;
+    std::string describe() const override;
+
+    // Scratch: the column matrix and filter-major outputs of one tile, plus the column deltas and transposed
+    // weights of the backward pass
+    size_t getScratchSize(size_t batchSize) const override;
+
+    // Batched forward pass: im2col, then the weight matrix times the column matrix
+    void forwardBatch(std::span<const Scalar> inputs, std::span<Scalar> outputs, size_t batchSize,
+                      std::span<Scalar> scratch) const override;
+
+    // Batched backward pass: weight gradients from the column matrix, then col2im of the column deltas
+    void backwardBatch(std::span<const Scalar> inputs, std::span<const Scalar> outputs, std::span<Scalar> deltas,
+                       std::span<Scalar> inputDeltas, std::span<Scalar> weightGradients,
+                       std::span<Scalar> biasGradients, size_t batchSize, std::span<Scalar> scratch) const override;
+
+    // Getters
+    int getNumFilters() const;
+    int getKernelSize() const;
+    int getStride() const;
+    int getPadding() const;
+};
+
+#endif /* Conv2DLayer_hpp */
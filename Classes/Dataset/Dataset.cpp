@@ -6,64 +6,408 @@
 //
 
 #include "Dataset.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
-#include <sstream>
+#include <iostream>
 #include <stdexcept>
+#include <vector>
 
-// Constructor: Initialize dataset from CSV file
-Dataset::Dataset(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        throw std::runtime_error("Could not open file: " + filename);
+namespace {
+
+// Sample storage owned by the process (CSV input)
+struct OwnedSamples {
+    std::vector<uint8_t> labels;
+    std::vector<uint8_t> pixels;
+};
+
+// Memory-mapped IDX image and label files
+struct MappedIDX {
+    MappedFile images;
+    MappedFile labels;
+
+    MappedIDX(const std::string& imagesFilename, const std::string& labelsFilename)
+        : images(imagesFilename), labels(labelsFilename) {}
+};
+
+// Normalized value of every possible pixel: v / 255
+const std::array<Scalar, 256> NORMALIZED = [] {
+    std::array<Scalar, 256> table;
+    for (int v = 0; v < 256; ++v) {
+        table[v] = static_cast<Scalar>(v / 255.0); // Normalize to [0,1]
+    }
+    return table;
+}();
+
+// Smallest CSV chunk worth handing to a separate thread
+constexpr size_t MIN_CHUNK_BYTES = 1 << 20;
+
+// Line-aligned slice of a CSV file parsed by one task
+struct CSVChunk {
+    const char* begin = nullptr;    // First byte of the chunk (start of a line)
+    const char* end = nullptr;      // One past the last byte (after a newline, or end of file)
+    size_t numLines = 0;            // Number of lines in the chunk
+    size_t firstLine = 0;           // Zero-based index of the chunk's first line in the file
+    size_t errorLine = 0;           // One-based line number of the first error
+    std::string error;              // First parse error in the chunk (empty if none)
+};
+
+// Parses one CSV line (label followed by 784 integer pixels) into label and pixels.
+// Returns an error message, or an empty string on success
+std::string parseCSVLine(const char* cursor, const char* end, uint8_t& label, uint8_t* pixels) {
+    if (end > cursor && end[-1] == '\r') {
+        --end; // Tolerate Windows line endings
+    }
+    if (cursor == end) {
+        return "Invalid line in file: empty line";
+    }
+    // Parse the label (first value in the row)
+    int value = 0;
+    auto result = std::from_chars(cursor, end, value);
+    if (result.ec != std::errc() || (result.ptr != end && *result.ptr != ',')) {
+        return "Invalid line in file: could not parse label";
+    }
+    if (value < 0 || value > 9) {
+        return "Invalid label: " + std::to_string(value);
+    }
+    label = static_cast<uint8_t>(value);
+    cursor = result.ptr;
+
+    // Parse the 784 pixel values
+    size_t count = 0;
+    while (cursor != end) {
+        ++cursor; // Skip the separating comma
+        result = std::from_chars(cursor, end, value);
+        if (result.ec != std::errc() || (result.ptr != end && *result.ptr != ',')) {
+            return "Invalid pixel value in column " + std::to_string(count + 2);
+        }
+        if (value < 0 || value > 255) {
+            return "Pixel value out of range in column " + std::to_string(count + 2) + ": " + std::to_string(value);
+        }
+        if (count < 784) {
+            pixels[count] = static_cast<uint8_t>(value);
+        }
+        count++;
+        cursor = result.ptr;
+    }
+
+    // Verify that each sample has exactly 784 pixels
+    if (count != 784) {
+        return "Expected 784 pixels, got " + std::to_string(count);
+    }
+    return std::string();
+}
+
+// Alignment of the pixel matrix inside a binary cache file
+constexpr uint64_t DATA_ALIGNMENT = 64;
+
+// Rounds offset up to the next multiple of DATA_ALIGNMENT
+uint64_t alignOffset(uint64_t offset) {
+    return (offset + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+}
+
+// True if count records of recordSize bytes starting at offset fit in fileSize bytes. Divides instead of
+// multiplying so that header values from a corrupt file cannot wrap around and pass the check
+bool fitsInFile(uint64_t offset, uint64_t count, uint64_t recordSize, uint64_t fileSize) {
+    return offset <= fileSize && (recordSize == 0 || count <= (fileSize - offset) / recordSize);
+}
+
+// Reads a big-endian 32-bit integer (IDX headers are big-endian)
+uint32_t readBigEndian(const uint8_t* bytes) {
+    return (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | uint32_t(bytes[3]);
+}
+
+// Returns true if the file starts with the binary cache magic
+bool hasBinaryMagic(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    char magic[4] = {};
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, "NNDS", sizeof(magic)) == 0;
+}
+
+} // namespace
+
+// Constructor: Empty dataset, filled in by the loaders
+Dataset::Dataset() : labels(nullptr), data(nullptr), numSamples(0), rows(0), cols(0) {}
+
+// Constructor: Initialize dataset from a CSV file or a binary cache file
+Dataset::Dataset(const std::string& filename) : Dataset() {
+    if (hasBinaryMagic(filename)) {
+        loadBinary(filename);
+    } else {
+        loadCSV(filename);
+    }
+}
+
+// Parses a CSV file with one sample per line: label followed by 784 pixel values (0-255).
+// The file is mapped, split into line-aligned chunks and the chunks are parsed in parallel
+// straight into preallocated storage
+void Dataset::loadCSV(const std::string& filename) {
+    MappedFile file(filename);
+    const char* begin = reinterpret_cast<const char*>(file.data());
+    const char* end = begin + file.size();
+
+    // Split the file into chunks of roughly equal size that start at the beginning of a line
+    ThreadPool pool;
+    size_t numChunks = std::max<size_t>(1, std::min<size_t>(pool.getNumThreads() * 4, file.size() / MIN_CHUNK_BYTES));
+    std::vector<CSVChunk> chunks(numChunks);
+    const char* chunkBegin = begin;
+    for (size_t c = 0; c < numChunks; ++c) {
+        const char* chunkEnd = c + 1 == numChunks ? end : std::max(chunkBegin, begin + file.size() * (c + 1) / numChunks);
+        chunkEnd = chunkEnd == end ? end : std::find(chunkEnd, end, '\n');
+        chunks[c].begin = chunkBegin;
+        chunks[c].end = chunkEnd == end ? end : chunkEnd + 1;
+        chunkBegin = chunks[c].end;
+    }
+
+    // First pass: count the lines of every chunk to size the storage and number the lines
+    pool.parallelFor(numChunks, [&](size_t c) {
+        CSVChunk& chunk = chunks[c];
+        chunk.numLines = std::count(chunk.begin, chunk.end, '\n');
+        if (chunk.end > chunk.begin && chunk.end[-1] != '\n') {
+            chunk.numLines++; // Last line without a trailing newline
+        }
+    });
+    size_t totalLines = 0;
+    for (auto& chunk : chunks) {
+        chunk.firstLine = totalLines;
+        totalLines += chunk.numLines;
+    }
+
+    auto samples = std::make_shared<OwnedSamples>();
+    samples->labels.resize(totalLines);
+    samples->pixels.resize(totalLines * 784);
+
+    // Second pass: parse every chunk into its slice of the storage
+    pool.parallelFor(numChunks, [&](size_t c) {
+        CSVChunk& chunk = chunks[c];
+        const char* cursor = chunk.begin;
+        for (size_t line = chunk.firstLine; line < chunk.firstLine + chunk.numLines; ++line) {
+            const char* lineEnd = std::find(cursor, chunk.end, '\n');
+            chunk.error = parseCSVLine(cursor, lineEnd, samples->labels[line], samples->pixels.data() + line * 784);
+            if (!chunk.error.empty()) {
+                chunk.errorLine = line + 1;
+                return;
+            }
+            cursor = lineEnd == chunk.end ? lineEnd : lineEnd + 1;
+        }
+    });
+    // Report the error with the lowest line number
+    for (const auto& chunk : chunks) {
+        if (!chunk.error.empty()) {
+            throw std::runtime_error(filename + ":" + std::to_string(chunk.errorLine) + ": " + chunk.error);
+        }
     }
 
-    std::string line;
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string token;
+    numSamples = totalLines;
+    rows = 28;
+    cols = 28;
+    labels = samples->labels.data();
+    data = samples->pixels.data();
+    storage = samples;
+}
 
-        // Parse the label (first value in the row)
-        if (!std::getline(ss, token, ',')) {
-            throw std::runtime_error("Invalid line in file: " + line);
+// Maps a binary cache file written by save(); the pixel matrix is used in place without copying
+void Dataset::loadBinary(const std::string& filename) {
+    auto file = std::make_shared<MappedFile>(filename);
+    FileHeader header = readFileHeader(file->data(), file->size(), filename);
+    // Check the labels once here, as the CSV and IDX readers do, rather than partway through training
+    const uint8_t* fileLabels = file->data() + header.labelOffset;
+    for (uint64_t i = 0; i < header.numSamples; ++i) {
+        if (fileLabels[i] > 9) {
+            throw std::runtime_error("Invalid label in dataset file: " + std::to_string(fileLabels[i]));
         }
-        int label = std::stoi(token);
+    }
+
+    numSamples = header.numSamples;
+    rows = header.rows;
+    cols = header.cols;
+    labels = file->data() + header.labelOffset;
+    data = file->data() + header.dataOffset;
+    storage = file;
+}
+
+// Reads and validates the header of a binary cache file of fileSize bytes
+Dataset::FileHeader Dataset::readFileHeader(const uint8_t* bytes, size_t fileSize, const std::string& filename) {
+    FileHeader header;
+    if (fileSize < sizeof(header)) {
+        throw std::runtime_error("Truncated dataset file: " + filename);
+    }
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic, "NNDS", sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Not a dataset file: " + filename);
+    }
+    if (header.version != FILE_VERSION) {
+        throw std::runtime_error("Unsupported dataset file version " + std::to_string(header.version) + ": " + filename);
+    }
+    if (header.dtype != DType::UInt8) {
+        throw std::runtime_error("Unsupported dataset element type (stale cache?): " + filename);
+    }
+    uint64_t sampleBytes = uint64_t(header.rows) * header.cols; // Cannot overflow: both are 32-bit
+    if (!fitsInFile(header.labelOffset, header.numSamples, 1, fileSize) ||
+        !fitsInFile(header.dataOffset, header.numSamples, sampleBytes, fileSize)) {
+        throw std::runtime_error("Corrupt dataset file: " + filename);
+    }
+    return header;
+}
+
+// Converts raw pixels to normalized values
+void Dataset::normalizePixels(std::span<const uint8_t> pixels, std::span<Scalar> out) {
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        out[i] = NORMALIZED[pixels[i]];
+    }
+}
+
+// Loads a CSV file through its binary cache, creating the cache on first use
+Dataset Dataset::openCached(const std::string& csvFilename) {
+    std::string cacheFilename = csvFilename + ".nnds";
+    std::error_code error;
+    auto csvTime = std::filesystem::last_write_time(csvFilename, error);
+    auto cacheTime = std::filesystem::last_write_time(cacheFilename, error);
+    // Use the cache only if it exists and is at least as new as the CSV
+    if (!error && cacheTime >= csvTime && hasBinaryMagic(cacheFilename)) {
+        try {
+            Dataset dataset;
+            dataset.loadBinary(cacheFilename);
+            return dataset;
+        } catch (const std::exception& e) {
+            // Unreadable or outdated cache: rebuild it from the CSV
+            std::cerr << "Warning: ignoring dataset cache: " << e.what() << std::endl;
+        }
+    }
+    Dataset dataset;
+    dataset.loadCSV(csvFilename);
+    try {
+        dataset.save(cacheFilename);
+    } catch (const std::exception& e) {
+        std::cerr << "Warning: could not write dataset cache: " << e.what() << std::endl;
+    }
+    return dataset;
+}
 
-        // Parse the 784 pixel values
-        std::vector<double> pixels;
-        while (std::getline(ss, token, ',')) {
-            double pixel = std::stod(token) / 255.0; // Normalize to [0,1]
-            pixels.push_back(pixel);
+// Maps the original MNIST IDX image and label files; their pixels are used in place without copying
+Dataset Dataset::fromIDX(const std::string& imagesFilename, const std::string& labelsFilename) {
+    auto files = std::make_shared<MappedIDX>(imagesFilename, labelsFilename);
+    const MappedFile& images = files->images;
+    const MappedFile& labelFile = files->labels;
+    if (images.size() < 16 || readBigEndian(images.data()) != 0x00000803) {
+        throw std::runtime_error("Not an IDX image file: " + imagesFilename);
+    }
+    if (labelFile.size() < 8 || readBigEndian(labelFile.data()) != 0x00000801) {
+        throw std::runtime_error("Not an IDX label file: " + labelsFilename);
+    }
+    size_t count = readBigEndian(images.data() + 4);
+    size_t height = readBigEndian(images.data() + 8);
+    size_t width = readBigEndian(images.data() + 12);
+    if (readBigEndian(labelFile.data() + 4) != count) {
+        throw std::runtime_error("IDX image and label counts do not match");
+    }
+    if (!fitsInFile(16, count, height * width, images.size()) || !fitsInFile(8, count, 1, labelFile.size())) {
+        throw std::runtime_error("Truncated IDX file");
+    }
+    const uint8_t* labelData = labelFile.data() + 8;
+    for (size_t i = 0; i < count; ++i) {
+        if (labelData[i] > 9) {
+            throw std::runtime_error("Invalid label in IDX file: " + std::to_string(labelData[i]));
         }
+    }
 
-        // Verify that each sample has exactly 784 pixels
-        if (pixels.size() != 784) {
-            throw std::runtime_error("Expected 784 pixels, got " + std::to_string(pixels.size()));
+    Dataset dataset;
+    dataset.numSamples = count;
+    dataset.rows = height;
+    dataset.cols = width;
+    dataset.labels = labelData;
+    dataset.data = images.data() + 16;
+    dataset.storage = files;
+    return dataset;
+}
+
+// Writes the dataset as a binary cache file (written to a temporary name, then renamed into place)
+void Dataset::save(const std::string& filename) const {
+    FileHeader header = {};
+    std::memcpy(header.magic, "NNDS", sizeof(header.magic));
+    header.version = FILE_VERSION;
+    header.numSamples = numSamples;
+    header.rows = static_cast<uint32_t>(rows);
+    header.cols = static_cast<uint32_t>(cols);
+    header.dtype = DType::UInt8;
+    header.labelOffset = sizeof(FileHeader);
+    header.dataOffset = alignOffset(header.labelOffset + numSamples);
+
+    std::string temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not create file: " + temporary);
+        }
+        std::vector<char> padding(header.dataOffset - header.labelOffset - numSamples, 0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(labels), numSamples);
+        file.write(padding.data(), padding.size());
+        file.write(reinterpret_cast<const char*>(data), numSamples * getSampleSize());
+        if (!file) {
+            throw std::runtime_error("Could not write file: " + temporary);
         }
+    }
+    std::filesystem::rename(temporary, filename);
+}
 
-        // Store the parsed label and pixel values
-        labels.push_back(label);
-        data.push_back(pixels);
+// Returns a view of count consecutive samples sharing the same storage
+Dataset Dataset::slice(size_t first, size_t count) const {
+    if (first + count > numSamples || first + count < first) {
+        throw std::out_of_range("Index out of range");
     }
-    file.close();
+    Dataset view = *this;
+    view.labels = labels + first;
+    view.data = data + first * getSampleSize();
+    view.numSamples = count;
+    return view;
 }
 
 // Get total number of samples
 size_t Dataset::getNumSamples() const {
-    return labels.size();
+    return numSamples;
+}
+
+// Get number of pixel values per sample
+size_t Dataset::getSampleSize() const {
+    return rows * cols;
 }
 
 // Get label of sample at index
 int Dataset::getLabel(size_t index) const {
-    if (index >= labels.size()) {
+    if (index >= numSamples) {
         throw std::out_of_range("Index out of range");
     }
     return labels[index];
 }
 
-// Get pixel values of sample at index
-const std::vector<double>& Dataset::getSample(size_t index) const {
-    if (index >= data.size()) {
+// Get raw 0-255 pixel values of sample at index
+std::span<const uint8_t> Dataset::getPixels(size_t index) const {
+    if (index >= numSamples) {
+        throw std::out_of_range("Index out of range");
+    }
+    return std::span<const uint8_t>(data + index * getSampleSize(), getSampleSize());
+}
+
+// Write the normalized pixel values of sample at index into out
+void Dataset::getSample(size_t index, std::span<Scalar> out) const {
+    getBatch(index, 1, out);
+}
+
+// Write the normalized pixel values of count consecutive samples into out, one row per sample
+void Dataset::getBatch(size_t first, size_t count, std::span<Scalar> out) const {
+    if (first + count > numSamples || first + count < first) {
         throw std::out_of_range("Index out of range");
     }
-    return data[index];
+    size_t total = count * getSampleSize();
+    if (out.size() < total) {
+        throw std::invalid_argument("Output buffer is too small for the requested samples");
+    }
+    // The samples are contiguous, so the whole batch converts in one pass
+    normalizePixels(std::span<const uint8_t>(data + first * getSampleSize(), total), out);
 }
@@ -8,27 +8,97 @@
 #ifndef Dataset_hpp
 #define Dataset_hpp
 
-#include <vector>
+#include "Scalar.hpp"
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <string>
 
-// Class representing a dataset of MNIST samples
+// Class representing a dataset of MNIST samples.
+// Samples live in one contiguous matrix of raw 0-255 pixels (one byte each) that is either owned or
+// memory-mapped from a binary cache or IDX file; copies of a Dataset share the same storage.
+// Normalized values are produced on demand by getSample()/getBatch().
 class Dataset {
+public:
+    // Element type of the pixel matrix in a binary cache file
+    enum class DType : uint32_t {
+        Float64 = 1,    // Normalized doubles (written by older versions, no longer loaded)
+        UInt8 = 2       // Raw 0-255 pixels
+    };
+
+    // Header of a binary cache file (native byte order); the pixel matrix starts 64-byte aligned
+    struct FileHeader {
+        char magic[4];          // "NNDS"
+        uint32_t version;       // Format version (FILE_VERSION)
+        uint64_t numSamples;    // Number of samples
+        uint32_t rows;          // Image height
+        uint32_t cols;          // Image width
+        DType dtype;            // Element type of the pixel matrix
+        uint32_t reserved;      // Padding, always 0
+        uint64_t labelOffset;   // Byte offset of the labels (one uint8 per sample)
+        uint64_t dataOffset;    // Byte offset of the pixel matrix (numSamples x rows * cols)
+    };
+
+    static constexpr uint32_t FILE_VERSION = 1;
+
 private:
-    std::vector<int> labels;                // Vector storing the label of each sample (0-9)
-    std::vector<std::vector<double>> data;  // Vector storing the pixel values for each sample
+    std::shared_ptr<const void> storage;    // Keeps the sample memory alive (owned buffers or mapped file)
+    const uint8_t* labels;                  // Label of each sample (0-9)
+    const uint8_t* data;                    // Pixel matrix: numSamples rows of rows * cols raw 0-255 values
+    size_t numSamples;                      // Number of samples
+    size_t rows;                            // Image height
+    size_t cols;                            // Image width
+
+    // Constructor: Empty dataset, filled in by the loaders below
+    Dataset();
+
+    // Loaders for each supported format
+    void loadCSV(const std::string& filename);
+    void loadBinary(const std::string& filename);
 
 public:
-    // Constructor: Initialize dataset from CSV file
+    // Constructor: Initialize dataset from a CSV file or a binary cache file (detected from the file contents)
     Dataset(const std::string& filename);
 
+    // Loads a CSV file through its binary cache (filename + ".nnds"): the CSV is parsed once, written
+    // to the cache, and later runs map the cache instead. Falls back to plain CSV parsing if the
+    // cache cannot be written
+    static Dataset openCached(const std::string& csvFilename);
+
+    // Reads the original MNIST IDX files (e.g. train-images-idx3-ubyte and train-labels-idx1-ubyte)
+    static Dataset fromIDX(const std::string& imagesFilename, const std::string& labelsFilename);
+
+    // Reads and validates the header of a binary cache file whose first fileSize bytes are at bytes
+    // (at least sizeof(FileHeader) must be readable); throws std::runtime_error if it is invalid
+    static FileHeader readFileHeader(const uint8_t* bytes, size_t fileSize, const std::string& filename);
+
+    // Converts raw 0-255 pixels to normalized [0,1] values (out must hold pixels.size() values)
+    static void normalizePixels(std::span<const uint8_t> pixels, std::span<Scalar> out);
+
+    // Writes the dataset as a binary cache file that can be memory-mapped by the constructor
+    void save(const std::string& filename) const;
+
+    // Returns the count samples starting at first as a dataset sharing this one's storage (nothing is copied)
+    Dataset slice(size_t first, size_t count) const;
+
     // Get total number of samples
     size_t getNumSamples() const;
 
+    // Get number of pixel values per sample
+    size_t getSampleSize() const;
+
     // Get label of sample at index
     int getLabel(size_t index) const;
 
-    // Get pixel values of sample at index
-    const std::vector<double>& getSample(size_t index) const;
+    // Get raw 0-255 pixel values of sample at index (a view into the dataset's storage)
+    std::span<const uint8_t> getPixels(size_t index) const;
+
+    // Write the normalized ([0,1]) pixel values of sample at index into out (getSampleSize() values)
+    void getSample(size_t index, std::span<Scalar> out) const;
+
+    // Write the normalized pixel values of count consecutive samples starting at first into out,
+    // stacked row by row (count x getSampleSize() values)
+    void getBatch(size_t first, size_t count, std::span<Scalar> out) const;
 };
 
 #endif /* Dataset_hpp */
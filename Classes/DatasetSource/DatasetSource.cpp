@@ -0,0 +1,58 @@
+//
+//  DatasetSource.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "DatasetSource.hpp"
+#include <algorithm>
+#include <numeric>
+
+// Constructor: Wraps a dataset
+DatasetSource::DatasetSource(const Dataset& dataset, bool shuffle, unsigned seed)
+    : dataset(dataset), shuffle(shuffle), seed(seed), cursor(0), batchSize(1) {}
+
+// Get number of samples delivered per epoch
+size_t DatasetSource::getNumSamples() const {
+    return dataset.getNumSamples();
+}
+
+// Get number of input values per sample
+size_t DatasetSource::getSampleSize() const {
+    return dataset.getSampleSize();
+}
+
+// Starts a new epoch, drawing a fresh permutation when shuffling
+void DatasetSource::startEpoch(int epoch, size_t size) {
+    cursor = 0;
+    batchSize = std::max<size_t>(1, size);
+    if (shuffle) {
+        order.resize(dataset.getNumSamples());
+        std::iota(order.begin(), order.end(), 0);
+        std::mt19937 generator(seed + static_cast<unsigned>(epoch));
+        std::shuffle(order.begin(), order.end(), generator);
+    }
+}
+
+// Writes the next batch of samples and labels; returns the batch size, 0 at the end of the epoch
+size_t DatasetSource::nextBatch(std::span<Scalar> inputs, std::vector<int>& labels) {
+    size_t count = std::min(batchSize, dataset.getNumSamples() - cursor);
+    size_t sampleSize = dataset.getSampleSize();
+    labels.clear();
+    if (shuffle) {
+        for (size_t b = 0; b < count; ++b) {
+            size_t index = order[cursor + b];
+            dataset.getSample(index, inputs.subspan(b * sampleSize, sampleSize));
+            labels.push_back(dataset.getLabel(index));
+        }
+    } else {
+        // Consecutive samples convert in one pass
+        dataset.getBatch(cursor, count, inputs);
+        for (size_t b = 0; b < count; ++b) {
+            labels.push_back(dataset.getLabel(cursor + b));
+        }
+    }
+    cursor += count;
+    return count;
+}
@@ -0,0 +1,35 @@
+//
+//  DatasetSource.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef DatasetSource_hpp
+#define DatasetSource_hpp
+
+#include "BatchSource.hpp"
+#include "Dataset.hpp"
+#include <random>
+
+// Batch source over an in-memory Dataset, in file order or reshuffled every epoch
+class DatasetSource : public BatchSource {
+private:
+    const Dataset& dataset;         // Dataset the batches are drawn from
+    bool shuffle;                   // Reshuffle the sample order every epoch
+    unsigned seed;                  // Base seed; epoch e uses seed + e
+    std::vector<size_t> order;      // Sample order of the current epoch (empty when not shuffling)
+    size_t cursor;                  // Next position in the epoch
+    size_t batchSize;               // Batch size of the current epoch
+
+public:
+    // Constructor: Wraps a dataset (which must outlive the source)
+    DatasetSource(const Dataset& dataset, bool shuffle = false, unsigned seed = 0);
+
+    size_t getNumSamples() const override;
+    size_t getSampleSize() const override;
+    void startEpoch(int epoch, size_t batchSize) override;
+    size_t nextBatch(std::span<Scalar> inputs, std::vector<int>& labels) override;
+};
+
+#endif /* DatasetSource_hpp */
@@ -0,0 +1,309 @@
+//
+//  DenseLayer.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "DenseLayer.hpp"
+#include "Kernels.hpp"
+#include <algorithm>
+
+// Constructor: Initializes a layer with a specified number of neurons, each taking inputSize inputs
+DenseLayer::DenseLayer(int numNeurons, int inputSize, bool useReLU)
+    : numNeurons(0), inputSize(inputSize), layerUseReLU(useReLU) {
+    // Reserve the whole weight matrix up front so it lives in a single allocation
+    ownedWeights.reserve(static_cast<size_t>(numNeurons) * inputSize);
+    ownedBiases.reserve(numNeurons);
+    for (int i = 0; i < numNeurons; ++i) {
+        addNeuron();
+    }
+}
+
+// Constructor: Uses external parameters in place
+DenseLayer::DenseLayer(std::span<Scalar> weights, std::span<Scalar> biases, int numNeurons, int inputSize,
+                       bool useReLU, std::shared_ptr<void> storage)
+    : Layer(weights, biases, std::move(storage)), outputs(numNeurons, 0), gradients(numNeurons, 0),
+      numNeurons(numNeurons), inputSize(inputSize), layerUseReLU(useReLU) {
+    if (weights.size() != static_cast<size_t>(numNeurons) * inputSize || biases.size() != static_cast<size_t>(numNeurons)) {
+        throw std::invalid_argument("Parameter sizes do not match layer dimensions");
+    }
+}
+
+// Copy constructor: Copies the parameters into owned storage
+DenseLayer::DenseLayer(const DenseLayer& other)
+    : Layer(other), outputs(other.outputs), gradients(other.gradients), numNeurons(other.numNeurons),
+      inputSize(other.inputSize), layerUseReLU(other.layerUseReLU) {}
+
+// Returns a copy that owns its parameters
+std::unique_ptr<Layer> DenseLayer::clone() const {
+    return std::make_unique<DenseLayer>(*this);
+}
+
+// Getter: Returns the layer type
+Layer::Type DenseLayer::getType() const {
+    return Type::Dense;
+}
+
+// Getter: Returns the input shape (a vector of inputSize values)
+Layer::Shape DenseLayer::getInputShape() const {
+    return { 1, 1, inputSize };
+}
+
+// Getter: Returns the output shape (one value per neuron)
+Layer::Shape DenseLayer::getOutputShape() const {
+    return { 1, 1, numNeurons };
+}
+
+// Getter: Returns whether the layer applies ReLU
+bool DenseLayer::usesReLU() const {
+    return layerUseReLU;
+}
+
+// One-line description of the layer
+std::string DenseLayer::describe() const {
+    return "Dense " + std::to_string(inputSize) + " -> " + std::to_string(numNeurons) + (layerUseReLU ? ", ReLU" : "");
+}
+
+// Appends a new row of weights and a bias, both initialized with random values between -1 and 1
+void DenseLayer::initializeNeuron() {
+    for (int i = 0; i < inputSize; ++i) {
+        ownedWeights.push_back(static_cast<Scalar>(distribution(generator)));
+    }
+    ownedBiases.push_back(static_cast<Scalar>(distribution(generator)));
+    bindOwned();
+}
+
+// Adds a new neuron to the layer
+void DenseLayer::addNeuron() {
+    // Append a new row to the weight matrix
+    makeOwned();
+    initializeNeuron();
+    // Keep the per-neuron state in sync with the number of neurons
+    outputs.push_back(0);
+    gradients.push_back(0);
+    // Increment the count of neurons in the layer
+    numNeurons++;
+}
+
+// Forward pass: Computes the output of each neuron in the layer given the inputs
+std::span<const Scalar> DenseLayer::forward(std::span<const Scalar> inputs) {
+    // Validate that the input size matches the expected input size for the layer
+    if (inputs.size() != static_cast<size_t>(inputSize)) {
+        throw std::invalid_argument("Input size does not match layer's input size");
+    }
+    // Matrix-vector product: each row of the weight matrix is dotted with the inputs
+    const Scalar* row = weights.data();
+    for (int i = 0; i < numNeurons; ++i, row += inputSize) {
+        outputs[i] = Kernels::dot(row, inputs.data(), inputSize);
+    }
+    // Add biases and apply activation: ReLU if enabled, otherwise linear
+    Kernels::addBias(outputs.data(), biases.data(), numNeurons, layerUseReLU);
+    // Return a view of the neuron outputs
+    return outputs;
+}
+
+// Forward pass on sparse inputs: each row of the weight matrix is dotted with the nonzero inputs only
+std::span<const Scalar> DenseLayer::forward(const SparseInputs& inputs) {
+    if (inputs.getNumColumns() != static_cast<size_t>(inputSize) || inputs.getNumRows() == 0) {
+        throw std::invalid_argument("Input size does not match layer's input size");
+    }
+    std::span<const uint32_t> indices = inputs.getIndices(0);
+    std::span<const Scalar> values = inputs.getValues(0);
+    const Scalar* row = weights.data();
+    for (int i = 0; i < numNeurons; ++i, row += inputSize) {
+        outputs[i] = Kernels::sparseDot(row, indices.data(), values.data(), indices.size());
+    }
+    Kernels::addBias(outputs.data(), biases.data(), numNeurons, layerUseReLU);
+    return outputs;
+}
+
+// Computes gradients for all neurons in the layer during backpropagation
+void DenseLayer::computeGradients(std::span<const Scalar> nextLayerGradients, std::span<const Scalar> nextLayerWeights,
+                                  bool isOutputLayer) {
+    if (isOutputLayer) {
+        for (int i = 0; i < numNeurons; ++i) {
+            // dL/da_i is provided by nextLayerGradients (p_i - y_i)
+            Scalar dL_da = nextLayerGradients[i];
+            // da_i/dz_i = 1 since output layer is linear (no ReLU)
+            Scalar da_dz = 1;
+            // dL/dz_i = dL/da_i * da_i/dz_i
+            gradients[i] = dL_da * da_dz;
+        }
+    } else {
+        // Hidden layer computation: gradients = W_next^T * nextLayerGradients,
+        // accumulated row by row so the next layer's weights are read contiguously
+        if (nextLayerWeights.size() != nextLayerGradients.size() * numNeurons) {
+            throw std::invalid_argument("Next layer weights do not match layer size");
+        }
+        std::fill(gradients.begin(), gradients.end(), Scalar(0));
+        const Scalar* row = nextLayerWeights.data();
+        for (size_t j = 0; j < nextLayerGradients.size(); ++j, row += numNeurons) {
+            Kernels::axpy(nextLayerGradients[j], row, gradients.data(), numNeurons);
+        }
+        // da_i/dz_i = 1 if ReLU input z_i > 0, else 0; since a_i = ReLU(z_i), check a_i > 0
+        Kernels::reluMask(gradients.data(), outputs.data(), numNeurons);
+    }
+}
+
+// Updates weights and biases of all neurons in the layer using gradient descent
+void DenseLayer::updateWeights(std::span<const Scalar> inputs, double learningRate) {
+    if (inputs.size() != static_cast<size_t>(inputSize)) {
+        throw std::invalid_argument("Input size does not match layer's input size");
+    }
+    // Rank-1 update of the weight matrix: w_ij -= learningRate * gradient_i * input_j
+    Scalar* row = weights.data();
+    for (int i = 0; i < numNeurons; ++i, row += inputSize) {
+        Scalar step = static_cast<Scalar>(learningRate * gradients[i]);
+        Kernels::axpy(-step, inputs.data(), row, inputSize);
+        // Update bias: b_new = b_old - learningRate * gradient
+        biases[i] -= step;
+    }
+}
+
+// Weight update with sparse inputs: w_ij changes only where input_j is nonzero
+void DenseLayer::updateWeights(const SparseInputs& inputs, double learningRate) {
+    if (inputs.getNumColumns() != static_cast<size_t>(inputSize) || inputs.getNumRows() == 0) {
+        throw std::invalid_argument("Input size does not match layer's input size");
+    }
+    std::span<const uint32_t> indices = inputs.getIndices(0);
+    std::span<const Scalar> values = inputs.getValues(0);
+    Scalar* row = weights.data();
+    for (int i = 0; i < numNeurons; ++i, row += inputSize) {
+        Scalar step = static_cast<Scalar>(learningRate * gradients[i]);
+        Kernels::sparseAxpy(-step, indices.data(), values.data(), row, indices.size());
+        biases[i] -= step;
+    }
+}
+
+// Batched forward pass: one matrix-matrix product over the whole batch.
+// Each row of the weight matrix is loaded once and reused for every sample in the batch.
+void DenseLayer::forwardBatch(std::span<const Scalar> inputs, std::span<Scalar> outputs, size_t batchSize,
+                              std::span<Scalar>) const {
+    if (inputs.size() < batchSize * inputSize || outputs.size() < batchSize * numNeurons) {
+        throw std::invalid_argument("Batch buffers are too small for layer");
+    }
+    const Scalar* row = weights.data();
+    for (int i = 0; i < numNeurons; ++i, row += inputSize) {
+        const Scalar* x = inputs.data();
+        for (size_t b = 0; b < batchSize; ++b, x += inputSize) {
+            outputs[b * numNeurons + i] = Kernels::dot(row, x, inputSize);
+        }
+    }
+    // Add biases and apply activation to each sample's outputs
+    for (size_t b = 0; b < batchSize; ++b) {
+        Kernels::addBias(outputs.data() + b * numNeurons, biases.data(), numNeurons, layerUseReLU);
+    }
+}
+
+// Batched forward pass on sparse inputs, row by row of the weight matrix like the dense version
+void DenseLayer::forwardBatch(const SparseInputs& inputs, std::span<Scalar> outputs, size_t batchSize) const {
+    if (inputs.getNumColumns() != static_cast<size_t>(inputSize) || inputs.getNumRows() < batchSize ||
+        outputs.size() < batchSize * numNeurons) {
+        throw std::invalid_argument("Batch buffers are too small for layer");
+    }
+    const Scalar* row = weights.data();
+    for (int i = 0; i < numNeurons; ++i, row += inputSize) {
+        for (size_t b = 0; b < batchSize; ++b) {
+            std::span<const uint32_t> indices = inputs.getIndices(b);
+            outputs[b * numNeurons + i] =
+                Kernels::sparseDot(row, indices.data(), inputs.getValues(b).data(), indices.size());
+        }
+    }
+    for (size_t b = 0; b < batchSize; ++b) {
+        Kernels::addBias(outputs.data() + b * numNeurons, biases.data(), numNeurons, layerUseReLU);
+    }
+}
+
+// Batched backward pass: dW += delta^T * X, db += sum(delta), dX = delta * W
+void DenseLayer::backwardBatch(std::span<const Scalar> inputs, std::span<const Scalar> outputs,
+                               std::span<Scalar> deltas, std::span<Scalar> inputDeltas,
+                               std::span<Scalar> weightGradients, std::span<Scalar> biasGradients, size_t batchSize,
+                               std::span<Scalar>) const {
+    bool propagate = !inputDeltas.empty();
+    if (inputs.size() < batchSize * inputSize || outputs.size() < batchSize * numNeurons ||
+        deltas.size() < batchSize * numNeurons || (propagate && inputDeltas.size() < batchSize * inputSize) ||
+        weightGradients.size() < weights.size() || biasGradients.size() < biases.size()) {
+        throw std::invalid_argument("Batch buffers are too small for layer");
+    }
+    // dL/dz = dL/da * ReLU'(z); since a = ReLU(z), the derivative is 1 where a > 0
+    if (layerUseReLU) {
+        Kernels::reluMask(deltas.data(), outputs.data(), batchSize * numNeurons);
+    }
+    if (propagate) {
+        std::fill(inputDeltas.begin(), inputDeltas.begin() + batchSize * inputSize, Scalar(0));
+    }
+    // Walk the weight matrix once: each row and its gradient row are reused for the whole batch
+    const Scalar* row = weights.data();
+    Scalar* gradRow = weightGradients.data();
+    for (int i = 0; i < numNeurons; ++i, row += inputSize, gradRow += inputSize) {
+        for (size_t b = 0; b < batchSize; ++b) {
+            Scalar delta = deltas[b * numNeurons + i];
+            if (delta == 0) {
+                continue; // Inactive ReLU units contribute nothing
+            }
+            biasGradients[i] += delta;
+            Kernels::axpy(delta, inputs.data() + b * inputSize, gradRow, inputSize);
+            if (propagate) {
+                Kernels::axpy(delta, row, inputDeltas.data() + b * inputSize, inputSize);
+            }
+        }
+    }
+}
+
+// Batched backward pass of a first layer on sparse inputs: dW += delta^T * X over the nonzeros of X, db += sum(delta)
+void DenseLayer::backwardBatch(const SparseInputs& inputs, std::span<const Scalar> outputs, std::span<Scalar> deltas,
+                               std::span<Scalar> weightGradients, std::span<Scalar> biasGradients,
+                               size_t batchSize) const {
+    if (inputs.getNumColumns() != static_cast<size_t>(inputSize) || inputs.getNumRows() < batchSize ||
+        outputs.size() < batchSize * numNeurons || deltas.size() < batchSize * numNeurons ||
+        weightGradients.size() < weights.size() || biasGradients.size() < biases.size()) {
+        throw std::invalid_argument("Batch buffers are too small for layer");
+    }
+    if (layerUseReLU) {
+        Kernels::reluMask(deltas.data(), outputs.data(), batchSize * numNeurons);
+    }
+    Scalar* gradRow = weightGradients.data();
+    for (int i = 0; i < numNeurons; ++i, gradRow += inputSize) {
+        for (size_t b = 0; b < batchSize; ++b) {
+            Scalar delta = deltas[b * numNeurons + i];
+            if (delta == 0) {
+                continue;
+            }
+            biasGradients[i] += delta;
+            std::span<const uint32_t> indices = inputs.getIndices(b);
+            Kernels::sparseAxpy(delta, indices.data(), inputs.getValues(b).data(), gradRow, indices.size());
+        }
+    }
+}
+
+// Getter: Returns lightweight views of the neurons, each pointing at its row of the weight matrix
+std::vector<Neuron> DenseLayer::getNeurons() const {
+    std::vector<Neuron> views;
+    views.reserve(numNeurons);
+    for (int i = 0; i < numNeurons; ++i) {
+        std::span<const Scalar> row(weights.data() + static_cast<size_t>(i) * inputSize, inputSize);
+        views.emplace_back(row, biases[i], outputs[i], gradients[i], layerUseReLU);
+    }
+    return views;
+}
+
+// Getter: Returns the outputs of the last forward pass
+std::span<const Scalar> DenseLayer::getOutputs() const {
+    return outputs;
+}
+
+// Getter: Returns the gradients of the last backward pass
+std::span<const Scalar> DenseLayer::getGradients() const {
+    return gradients;
+}
+
+// Getter: Returns the number of neurons in the layer
+int DenseLayer::getNumNeurons() const {
+    return numNeurons;
+}
+
+// Getter: Returns the number of inputs each neuron expects
+int DenseLayer::getInputSize() const {
+    return inputSize;
+}
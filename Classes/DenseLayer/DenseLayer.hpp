@@ -0,0 +1,101 @@
+//
+//  DenseLayer.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef DenseLayer_hpp
+#define DenseLayer_hpp
+
+#include "Layer.hpp"
+#include "Neuron.hpp"
+#include "SparseInputs.hpp"
+
+// Fully connected layer of neurons.
+// Parameters are stored as one contiguous row-major weight matrix (numNeurons x inputSize)
+// plus a bias vector, so forward and backward passes run as matrix-vector kernels.
+// Besides the batched passes of every layer, a dense layer keeps per-sample output and gradient buffers
+// for the fused single-sample training step, and can read its inputs as sparse rows.
+class DenseLayer : public Layer {
+private:
+    std::vector<Scalar> outputs;    // Output of each neuron after activation (the next layer's input buffer)
+    std::vector<Scalar> gradients;  // Gradient of each neuron for backpropagation
+    int numNeurons;                 // Number of neurons in the layer
+    int inputSize;                  // Number of inputs each neuron expects (size of previous layer)
+    bool layerUseReLU;              // Flag to determine if neurons in this layer use ReLU
+
+    // Appends a randomly initialized row of weights and a bias
+    void initializeNeuron();
+
+public:
+    // Constructor: Initializes a layer with a specified number of neurons, input size, and ReLU flag
+    DenseLayer(int numNeurons, int inputSize, bool useReLU = true);
+
+    // Constructor: Uses parameters held elsewhere in place (numNeurons x inputSize weights, numNeurons biases);
+    // storage keeps that memory alive for the lifetime of the layer
+    DenseLayer(std::span<Scalar> weights, std::span<Scalar> biases, int numNeurons, int inputSize, bool useReLU,
+               std::shared_ptr<void> storage);
+
+    // Copies always own their parameters
+    DenseLayer(const DenseLayer& other);
+
+    // Layer interface
+    std::unique_ptr<Layer> clone() const override;
+    Type getType() const override;
+    Shape getInputShape() const override;
+    Shape getOutputShape() const override;
+    bool usesReLU() const override;
+    std::string describe() const override;
+
+    // Adds a new neuron to the layer
+    void addNeuron();
+
+    // Forward pass: Computes outputs for all neurons given the input vector. Returns a view of the
+    // layer's output buffer (valid until the next forward pass), which the next layer reads in place
+    std::span<const Scalar> forward(std::span<const Scalar> inputs);
+
+    // Forward pass on the first row of sparse inputs: only the nonzero inputs are multiplied
+    std::span<const Scalar> forward(const SparseInputs& inputs);
+
+    // Computes gradients for neurons, handling output and hidden layers differently. For the output layer
+    // nextLayerGradients holds dL/da directly; for a hidden layer it holds the next layer's gradients and
+    // nextLayerWeights is the next layer's row-major weight matrix, read in place
+    void computeGradients(std::span<const Scalar> nextLayerGradients, std::span<const Scalar> nextLayerWeights,
+                          bool isOutputLayer);
+
+    // Updates weights and biases of all neurons using gradient descent; inputs are the
+    // activations the layer saw in its last forward pass (the previous layer's outputs)
+    void updateWeights(std::span<const Scalar> inputs, double learningRate);
+
+    // Weight update for inputs given as the first row of sparse inputs: weights of zero inputs are left untouched
+    void updateWeights(const SparseInputs& inputs, double learningRate);
+
+    // Batched forward pass: outputs (batchSize x numNeurons) = activation(inputs (batchSize x inputSize) * W^T + b)
+    void forwardBatch(std::span<const Scalar> inputs, std::span<Scalar> outputs, size_t batchSize,
+                      std::span<Scalar> scratch) const override;
+
+    // Batched forward pass on sparse inputs (one row per sample)
+    void forwardBatch(const SparseInputs& inputs, std::span<Scalar> outputs, size_t batchSize) const;
+
+    // Batched backward pass: dW += delta^T * X, db += sum(delta), dX = delta * W
+    void backwardBatch(std::span<const Scalar> inputs, std::span<const Scalar> outputs, std::span<Scalar> deltas,
+                       std::span<Scalar> inputDeltas, std::span<Scalar> weightGradients,
+                       std::span<Scalar> biasGradients, size_t batchSize, std::span<Scalar> scratch) const override;
+
+    // Batched backward pass of a first layer on sparse inputs: weight gradients are only accumulated for the
+    // nonzero inputs, and no input deltas are produced
+    void backwardBatch(const SparseInputs& inputs, std::span<const Scalar> outputs, std::span<Scalar> deltas,
+                       std::span<Scalar> weightGradients, std::span<Scalar> biasGradients, size_t batchSize) const;
+
+    // Getter: Returns lightweight views of the neurons (for inspection and display)
+    std::vector<Neuron> getNeurons() const;
+
+    // Getters for the per-sample buffers and dimensions
+    std::span<const Scalar> getOutputs() const;
+    std::span<const Scalar> getGradients() const;
+    int getNumNeurons() const;
+    int getInputSize() const;
+};
+
+#endif /* DenseLayer_hpp */
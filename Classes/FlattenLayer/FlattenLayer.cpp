@@ -0,0 +1,65 @@
+//
+//  FlattenLayer.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "FlattenLayer.hpp"
+#include <algorithm>
+
+// Constructor: Flattens inputShape images
+FlattenLayer::FlattenLayer(const Shape& inputShape) : inputShape(inputShape) {
+    if (inputShape.height <= 0 || inputShape.width <= 0 || inputShape.channels <= 0) {
+        throw std::invalid_argument("Flatten dimensions must be positive");
+    }
+}
+
+// Returns a copy of the layer
+std::unique_ptr<Layer> FlattenLayer::clone() const {
+    return std::make_unique<FlattenLayer>(*this);
+}
+
+// Getter: Returns the layer type
+Layer::Type FlattenLayer::getType() const {
+    return Type::Flatten;
+}
+
+// Getter: Returns the input image shape
+Layer::Shape FlattenLayer::getInputShape() const {
+    return inputShape;
+}
+
+// Getter: Returns the output shape (a vector of all input values)
+Layer::Shape FlattenLayer::getOutputShape() const {
+    return { 1, 1, static_cast<int>(inputShape.size()) };
+}
+
+// One-line description of the layer
+std::string FlattenLayer::describe() const {
+    return "Flatten " + inputShape.toString() + " -> " + std::to_string(inputShape.size());
+}
+
+// Batched forward pass: copies the inputs
+void FlattenLayer::forwardBatch(std::span<const Scalar> inputs, std::span<Scalar> outputs, size_t batchSize,
+                                std::span<Scalar>) const {
+    size_t count = batchSize * inputShape.size();
+    if (inputs.size() < count || outputs.size() < count) {
+        throw std::invalid_argument("Batch buffers are too small for layer");
+    }
+    std::copy_n(inputs.begin(), count, outputs.begin());
+}
+
+// Batched backward pass: copies the deltas
+void FlattenLayer::backwardBatch(std::span<const Scalar>, std::span<const Scalar>, std::span<Scalar> deltas,
+                                 std::span<Scalar> inputDeltas, std::span<Scalar>, std::span<Scalar>,
+                                 size_t batchSize, std::span<Scalar>) const {
+    if (inputDeltas.empty()) {
+        return;
+    }
+    size_t count = batchSize * inputShape.size();
+    if (deltas.size() < count || inputDeltas.size() < count) {
+        throw std::invalid_argument("Batch buffers are too small for layer");
+    }
+    std::copy_n(deltas.begin(), count, inputDeltas.begin());
+}
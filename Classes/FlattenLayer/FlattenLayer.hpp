@@ -0,0 +1,40 @@
+//
+//  FlattenLayer.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef FlattenLayer_hpp
+#define FlattenLayer_hpp
+
+#include "Layer.hpp"
+
+// Reinterprets an image as a vector of height * width * channels values, e.g. between the convolution
+// and the dense layers. Images are stored channels-last, so the values themselves are passed on unchanged.
+class FlattenLayer : public Layer {
+private:
+    Shape inputShape;   // Input image: height x width x channels
+
+public:
+    // Constructor: Flattens inputShape images
+    explicit FlattenLayer(const Shape& inputShape);
+
+    // Layer interface
+    std::unique_ptr<Layer> clone() const override;
+    Type getType() const override;
+    Shape getInputShape() const override;
+    Shape getOutputShape() const override;
+    std::string describe() const override;
+
+    // Batched forward pass: copies the inputs
+    void forwardBatch(std::span<const Scalar> inputs, std::span<Scalar> outputs, size_t batchSize,
+                      std::span<Scalar> scratch) const override;
+
+    // Batched backward pass: copies the deltas
+    void backwardBatch(std::span<const Scalar> inputs, std::span<const Scalar> outputs, std::span<Scalar> deltas,
+                       std::span<Scalar> inputDeltas, std::span<Scalar> weightGradients,
+                       std::span<Scalar> biasGradients, size_t batchSize, std::span<Scalar> scratch) const override;
+};
+
+#endif /* FlattenLayer_hpp */
@@ -6,29 +6,47 @@
 //
 
 #include "GUI.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
 #include <iostream>
 
 // Constructor: Initializes the GUI with window, input display, datasets, and training parameters
 GUI::GUI(sf::RenderWindow& window, Input& inputDisplay, Dataset& trainData, Dataset& testData,
-         double learningRate, int epochs)
-    : window(window), inputDisplay(inputDisplay), trainData(trainData), testData(testData),
-      learningRate(learningRate), epochs(epochs), selectedLayer(-1), network(nullptr), isBuilt(false) {
+         double learningRate, int epochs, const std::string& modelPath)
+    : window(window), inputDisplay(inputDisplay), neuronVertices(sf::Triangles), trainData(trainData),
+      testData(testData), network(nullptr),
+      displayedSample(static_cast<size_t>(-1)), modelPath(modelPath), learningRate(learningRate), epochs(epochs),
+      selectedLayer(-1), isBuilt(false) {
     // Load font for button labels and neuron counts
     if (!font.loadFromFile("/System/Library/Fonts/Supplemental/Arial.ttf")) {
         throw std::runtime_error("Failed to load font");
     }
 
-    // Initialize buttons (Add Layer, Add Neuron, Build, Train, Test)
+    // Initialize buttons (Add Layer, Add Neuron, Build, Train, Test, Cancel)
     buttons.emplace_back(300.0f, 520.0f, 100.0f, 40.0f, "Add Layer", font);
     buttons.emplace_back(410.0f, 520.0f, 100.0f, 40.0f, "Add Neuron", font);
     buttons.emplace_back(520.0f, 520.0f, 100.0f, 40.0f, "Build", font);
     buttons.emplace_back(630.0f, 520.0f, 100.0f, 40.0f, "Train", font);
     buttons.emplace_back(740.0f, 520.0f, 100.0f, 40.0f, "Test", font);
+    buttons.emplace_back(850.0f, 520.0f, 100.0f, 40.0f, "Cancel", font);
 
     // Set button colors
     for (auto& button : buttons) {
         button.setFillColor(sf::Color::Green);
     }
+
+    // Training progress, shown below the input display
+    trainingStatus.setFont(font);
+    trainingStatus.setCharacterSize(14);
+    trainingStatus.setFillColor(sf::Color::Black);
+    trainingStatus.setPosition(10.0f, 345.0f);
+}
+
+// Destructor: Cancels a training run in progress (joining the worker) before freeing the network
+GUI::~GUI() {
+    trainer.reset();
+    delete network;
 }
 
 // Handles user input events (mouse clicks, window close)
@@ -42,6 +60,21 @@ void GUI::handleEvents() {
             sf::Vector2f mousePos = window.mapPixelToCoords(
                 sf::Vector2i(event.mouseButton.x, event.mouseButton.y));
 
+            // While training, the worker owns the network: only Train (pause/resume) and Cancel apply
+            if (trainer) {
+                if (buttons[3].isClicked(mousePos)) {
+                    trainNetwork();
+                }
+                else if (buttons[5].isClicked(mousePos)) {
+                    cancelTraining();
+                }
+                else if (buttons[0].isClicked(mousePos) || buttons[1].isClicked(mousePos) ||
+                         buttons[2].isClicked(mousePos) || buttons[4].isClicked(mousePos)) {
+                    std::cout << "Training in progress: pause with Train or stop it with Cancel" << std::endl;
+                }
+                continue;
+            }
+
             // Check for button clicks
             if (buttons[0].isClicked(mousePos)) { // Add Layer
                 addLayer();
@@ -73,6 +106,9 @@ void GUI::handleEvents() {
                     std::cout << "Please build the network first!" << std::endl;
                 }
             }
+            else if (buttons[5].isClicked(mousePos)) { // Cancel
+                std::cout << "No training to cancel" << std::endl;
+            }
             else {
                 // Check if a layer is clicked for selection
                 selectLayer(mousePos);
@@ -83,6 +119,10 @@ void GUI::handleEvents() {
 
 // Draws the GUI elements to the window
 void GUI::draw() {
+    if (trainer) {
+        updateTraining();
+    }
+
     window.clear(sf::Color::White);
 
     // Draw input display
@@ -103,11 +143,7 @@ void GUI::draw() {
     }
 
     // Draw neurons
-    for (const auto& layerNeurons : neurons) {
-        for (const auto& neuron : layerNeurons) {
-            window.draw(neuron);
-        }
-    }
+    window.draw(neuronVertices);
 
     // Draw connections if network is built
     if (isBuilt) {
@@ -124,6 +160,9 @@ void GUI::draw() {
         window.draw(button);
     }
 
+    // Draw training progress
+    window.draw(trainingStatus);
+
     window.display();
 }
 
@@ -143,7 +182,8 @@ void GUI::addLayer() {
     layerRects.push_back(layerRect);
 
     // Initialize an empty vector for neurons in this layer
-    neurons.push_back(std::vector<sf::CircleShape>());
+    neurons.push_back(std::vector<sf::Vector2f>());
+    neuronColors.push_back(std::vector<sf::Color>());
 
     // Update layer sizes (initially 0 neurons)
     layerSizes.push_back(0);
@@ -173,9 +213,8 @@ void GUI::addNeuron() {
     }
 
     // Add a new neuron to the selected layer
-    sf::CircleShape neuron(NEURON_RADIUS);
-    neuron.setFillColor(sf::Color::Green);
-    neurons[selectedLayer].push_back(neuron);
+    neurons[selectedLayer].emplace_back();
+    neuronColors[selectedLayer].push_back(sf::Color::Green);
 
     // Update the number of neurons in this layer
     layerSizes[selectedLayer]++;
@@ -193,7 +232,7 @@ void GUI::addNeuron() {
     if (totalNeurons == 1) {
         // Place a single neuron in the center of the layer
         float yPos = LAYER_Y + LAYER_HEIGHT / 2 - NEURON_RADIUS;
-        neurons[selectedLayer][0].setPosition(layerX, yPos);
+        neurons[selectedLayer][0] = sf::Vector2f(layerX, yPos);
     } else {
         // Define padding to ensure equal distances above top neuron and below bottom neuron
         float padding = 20.0f;
@@ -203,9 +242,10 @@ void GUI::addNeuron() {
         float spacing = distanceBetweenCenters / (totalNeurons - 1);
         for (size_t i = 0; i < totalNeurons; ++i) {
             float yPos = LAYER_Y + padding + i * spacing;
-            neurons[selectedLayer][i].setPosition(layerX, yPos);
+            neurons[selectedLayer][i] = sf::Vector2f(layerX, yPos);
         }
     }
+    updateNeuronVertices();
 }
 
 // Builds the network by creating connections between neurons and initializing the Network object
@@ -215,36 +255,65 @@ void GUI::buildNetwork() {
         return;
     }
 
-    // Clear previous connections
+    // Clear previous connections and bias colors
     connections.clear();
-
-    // Create connections between neurons in adjacent layers
-    for (size_t i = 0; i < neurons.size() - 1; ++i) {
-        std::vector<sf::Vertex> layerConnections;
-        for (size_t j = 0; j < neurons[i].size(); ++j) {
-            for (size_t k = 0; k < neurons[i + 1].size(); ++k) {
-                sf::Vertex line[] = {
-                    sf::Vertex(sf::Vector2f(neurons[i][j].getPosition().x + NEURON_RADIUS * 2,
-                                            neurons[i][j].getPosition().y + NEURON_RADIUS)),
-                    sf::Vertex(sf::Vector2f(neurons[i + 1][k].getPosition().x,
-                                            neurons[i + 1][k].getPosition().y + NEURON_RADIUS))
-                };
-                line[0].color = sf::Color::Black;
-                line[1].color = sf::Color::Black;
-                layerConnections.push_back(line[0]);
-                layerConnections.push_back(line[1]);
-            }
+    for (auto& layerColors : neuronColors) {
+        std::fill(layerColors.begin(), layerColors.end(), sf::Color::Green);
+    }
+    updateNeuronVertices();
+    trainingStatus.setString("");
+
+    // Create connections between neurons in adjacent layers, from the right edge of each neuron
+    // to the left edge of the neurons of the next layer
+    for (size_t i = 0; i + 1 < neurons.size(); ++i) {
+        std::vector<sf::Vector2f> sources;
+        std::vector<sf::Vector2f> targets;
+        for (const sf::Vector2f& neuron : neurons[i]) {
+            sources.emplace_back(neuron.x + NEURON_RADIUS * 2, neuron.y + NEURON_RADIUS);
+        }
+        for (const sf::Vector2f& neuron : neurons[i + 1]) {
+            targets.emplace_back(neuron.x, neuron.y + NEURON_RADIUS);
         }
-        connections.push_back(layerConnections);
+        connections.emplace_back(std::move(sources), std::move(targets), MAX_DRAWN_CONNECTIONS);
     }
 
     // Initialize the Network with the current architecture
     std::vector<int> networkSizes = {784}; // Input layer (784 pixels)
     networkSizes.insert(networkSizes.end(), layerSizes.begin(), layerSizes.end()); // Hidden and output layers
     delete network; // Delete previous network if exists
-    network = new Network(networkSizes, learningRate);
+    network = nullptr;
+    // Reuse the weights of a previously trained network with the same architecture
+    if (std::filesystem::exists(modelPath)) {
+        try {
+            Network saved = Network::load(modelPath);
+            std::vector<int> savedSizes = {saved.getInputSize()};
+            for (const auto& layer : saved.getLayers()) {
+                if (layer->getType() != Layer::Type::Dense) {
+                    savedSizes.clear(); // The builder only makes dense networks
+                    break;
+                }
+                savedSizes.push_back(static_cast<int>(layer->getNumOutputs()));
+            }
+            if (savedSizes == networkSizes) {
+                network = new Network(std::move(saved));
+                std::cout << "Loaded trained weights from " << modelPath << std::endl;
+            }
+        } catch (const std::exception& e) {
+            std::cout << "Ignoring saved model: " << e.what() << std::endl;
+        }
+    }
+    if (!network) {
+        network = new Network(networkSizes, learningRate);
+    }
     isBuilt = true;
 
+    // Color the connections by the initial (or loaded) weights; connections[i] shows layer i + 1,
+    // since the input layer is shown by the input display
+    const auto& layers = network->getLayers();
+    for (size_t i = 0; i < connections.size(); ++i) {
+        connections[i].setWeights(layers[i + 1]->getWeights());
+    }
+
     std::cout << "Network built with architecture: ";
     for (int size : networkSizes) {
         std::cout << size << " ";
@@ -252,49 +321,82 @@ void GUI::buildNetwork() {
     std::cout << std::endl;
 }
 
-// Trains the network using the training dataset, prints loss per epoch
+// Starts training on a worker thread, or pauses/resumes the run in progress
 void GUI::trainNetwork() {
-    std::cout << "Starting training..." << std::endl;
+    if (trainer) {
+        if (trainer->getState() == BackgroundTrainer::State::Paused) {
+            trainer->resume();
+            buttons[3].setLabel("Pause");
+            std::cout << "Training resumed" << std::endl;
+        }
+        else {
+            trainer->pause();
+            buttons[3].setLabel("Resume");
+            std::cout << "Training paused" << std::endl;
+        }
+        return;
+    }
 
-    const size_t DISPLAY_UPDATE_INTERVAL = 100; // Update display every 100 samples
-
-    for (int epoch = 0; epoch < epochs; ++epoch) {
-        double totalLoss = 0.0;
-        for (size_t i = 0; i < trainData.getNumSamples(); ++i) {
-            // Handle SFML window events periodically to reduce overhead
-            if (i % DISPLAY_UPDATE_INTERVAL == 0) {
-                sf::Event event;
-                while (window.pollEvent(event)) {
-                    if (event.type == sf::Event::Closed) {
-                        window.close();
-                        return;
-                    }
-                }
-            }
+    std::cout << "Starting training..." << std::endl;
+    const size_t SNAPSHOT_INTERVAL = 1000; // Samples between two weight snapshots for the display
+    trainer = std::make_unique<BackgroundTrainer>(*network, trainData, epochs, SNAPSHOT_INTERVAL);
+    trainer->start();
+    buttons[3].setLabel("Pause");
+}
 
-            // Get current sample and label
-            const auto& sample = trainData.getSample(i);
-            int label = trainData.getLabel(i);
+// Stops the training run in progress; the network keeps the weights trained so far
+void GUI::cancelTraining() {
+    trainer->cancel();
+    std::cout << "Cancelling training..." << std::endl;
+}
 
-            // Update input display and render periodically
-            if (i % DISPLAY_UPDATE_INTERVAL == 0) {
-                inputDisplay.setSample(sample);
-                draw();
-            }
+// Reads the progress of the training run without waiting on the worker, and finishes the run once it is done
+void GUI::updateTraining() {
+    // Show the sample being trained on
+    size_t sampleIndex = trainer->getSampleIndex();
+    if (sampleIndex != displayedSample) {
+        inputDisplay.setSample(trainData.getPixels(sampleIndex));
+        displayedSample = sampleIndex;
+    }
 
-            // Train the network
-            auto output = network->forward(sample);
-            totalLoss += network->computeLoss(output, label);
-            network->backpropagate(sample, label);
+    // Color the neurons and connections by the newest weights, only when the worker published new ones
+    bool changed = false;
+    const BackgroundTrainer::Snapshot& snapshot = trainer->getSnapshot(changed);
+    if (changed) {
+        colorNeurons(snapshot.biases);
+        for (size_t i = 0; i < connections.size(); ++i) {
+            connections[i].setWeights(snapshot.weights[i + 1]);
         }
-        // Print average loss for the epoch
-        std::cout << "Epoch " << epoch + 1 << ", Loss: " << totalLoss / trainData.getNumSamples() << std::endl;
+    }
 
-        // Ensure the last sample of the epoch is displayed
-        const auto& lastSample = trainData.getSample(trainData.getNumSamples() - 1);
-        inputDisplay.setSample(lastSample);
-        draw();
+    BackgroundTrainer::State state = trainer->getState();
+    trainingStatus.setString("Epoch " + std::to_string(trainer->getEpoch() + 1) + "/" +
+                             std::to_string(trainer->getEpochs()) + "  sample " + std::to_string(sampleIndex + 1) +
+                             "/" + std::to_string(trainData.getNumSamples()) + "\nLoss " +
+                             std::to_string(trainer->getEpochLoss()) + "  " +
+                             BackgroundTrainer::getStateName(state));
+    // Decide from the state read above: the worker may have finished since
+    if (state != BackgroundTrainer::State::Finished && state != BackgroundTrainer::State::Cancelled &&
+        state != BackgroundTrainer::State::Failed) {
+        return;
     }
+
+    // The worker has stopped: the network belongs to the GUI again
+    try {
+        trainer->join();
+        if (state == BackgroundTrainer::State::Finished) {
+            // Keep the trained weights for the next run
+            network->save(modelPath);
+            std::cout << "Saved trained network to " << modelPath << std::endl;
+        }
+        else {
+            std::cout << "Training cancelled; the network keeps the weights trained so far" << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cout << "Training failed: " << e.what() << std::endl;
+    }
+    trainer.reset();
+    buttons[3].setLabel("Train");
 }
 
 // Tests the network using the test dataset, prints accuracy
@@ -315,9 +417,46 @@ void GUI::selectLayer(sf::Vector2f mousePos) {
     }
 }
 
+// Helper: Rebuilds the neuron triangle list (a fan of NEURON_SEGMENTS triangles per neuron)
+void GUI::updateNeuronVertices() {
+    // Unit circle points, shared by every neuron
+    std::vector<sf::Vector2f> rim(NEURON_SEGMENTS + 1);
+    for (size_t s = 0; s <= NEURON_SEGMENTS; ++s) {
+        float angle = 2.0f * 3.14159265f * static_cast<float>(s) / static_cast<float>(NEURON_SEGMENTS);
+        rim[s] = sf::Vector2f(NEURON_RADIUS * std::cos(angle), NEURON_RADIUS * std::sin(angle));
+    }
+
+    neuronVertices.clear();
+    for (size_t l = 0; l < neurons.size(); ++l) {
+        for (size_t j = 0; j < neurons[l].size(); ++j) {
+            sf::Vector2f center(neurons[l][j].x + NEURON_RADIUS, neurons[l][j].y + NEURON_RADIUS);
+            for (size_t s = 0; s < NEURON_SEGMENTS; ++s) {
+                neuronVertices.append(sf::Vertex(center, neuronColors[l][j]));
+                neuronVertices.append(sf::Vertex(center + rim[s], neuronColors[l][j]));
+                neuronVertices.append(sf::Vertex(center + rim[s + 1], neuronColors[l][j]));
+            }
+        }
+    }
+}
+
+// Helper: Colors each neuron by its bias, from gray (0) to green (>= 1) or red (<= -1)
+void GUI::colorNeurons(const std::vector<std::vector<Scalar>>& biases) {
+    for (size_t l = 0; l < neurons.size() && l < biases.size(); ++l) {
+        for (size_t j = 0; j < neurons[l].size() && j < biases[l].size(); ++j) {
+            float amount = std::min(std::abs(static_cast<float>(biases[l][j])), 1.0f);
+            sf::Color target = biases[l][j] >= 0 ? sf::Color(0, 200, 0) : sf::Color(220, 0, 0);
+            auto mix = [amount](sf::Uint8 from, sf::Uint8 to) {
+                return static_cast<sf::Uint8>(from + (to - from) * amount);
+            };
+            neuronColors[l][j] = sf::Color(mix(160, target.r), mix(160, target.g), mix(160, target.b));
+        }
+    }
+    updateNeuronVertices();
+}
+
 // Helper: Draws connections between neurons in adjacent layers
 void GUI::drawConnections() {
     for (const auto& layerConnections : connections) {
-        window.draw(layerConnections.data(), layerConnections.size(), sf::Lines);
+        window.draw(layerConnections);
     }
 }
@@ -8,11 +8,14 @@
 #ifndef GUI_hpp
 #define GUI_hpp
 
+#include "BackgroundTrainer.hpp"
 #include "Button.hpp"
+#include "ConnectionView.hpp"
 #include "Input.hpp"
 #include "Network.hpp"
 #include "Dataset.hpp"
 #include <SFML/Graphics.hpp>
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -22,15 +25,21 @@ private:
     sf::RenderWindow& window;              // Reference to the SFML window for rendering
     Input& inputDisplay;                   // Reference to the input display for MNIST samples
     sf::Font font;                         // Font for button labels and neuron count labels
-    std::vector<Button> buttons;           // List of interactive buttons (Add Layer, Add Neuron, Build, Train, Test)
+    std::vector<Button> buttons;           // List of interactive buttons (Add Layer, Add Neuron, Build, Train, Test, Cancel)
     std::vector<sf::RectangleShape> layerRects; // Rectangles representing each layer
-    std::vector<std::vector<sf::CircleShape>> neurons; // 2D vector of neuron circles (per layer)
-    std::vector<std::vector<sf::Vertex>> connections; // Lines connecting neurons between layers
+    std::vector<std::vector<sf::Vector2f>> neurons; // Top-left corner of each neuron circle (per layer)
+    std::vector<std::vector<sf::Color>> neuronColors; // Fill color of each neuron (per layer)
+    sf::VertexArray neuronVertices;        // All neuron circles as one triangle list, drawn in a single call
+    std::vector<ConnectionView> connections; // Weight-colored lines connecting neurons of adjacent layers
     std::vector<sf::Text> neuronCounts;    // Text labels showing the number of neurons in each layer
     std::vector<int> layerSizes;           // Number of neurons in each layer (for Network construction)
     Dataset& trainData;                    // Reference to the training dataset
     Dataset& testData;                     // Reference to the test dataset
     Network* network;                      // Pointer to the neural network (initialized after Build)
+    std::unique_ptr<BackgroundTrainer> trainer; // Training run in progress; owns the network until it is done
+    sf::Text trainingStatus;               // Epoch, sample and loss of the training run
+    size_t displayedSample;                // Training sample shown in the input display
+    std::string modelPath;                 // Model file: saved after training, reused by Build when the architecture matches
     double learningRate;                   // Learning rate for the network
     int epochs;                            // Number of epochs for training
     size_t selectedLayer;                  // Index of the currently selected layer (size_t to match vector sizes)
@@ -40,6 +49,8 @@ private:
     const float LAYER_WIDTH = 60.0f;       // Width of each layer rectangle
     const float LAYER_HEIGHT = 400.0f;     // Height of each layer rectangle
     const float NEURON_RADIUS = 6.0f;      // Radius of neuron circles
+    const size_t NEURON_SEGMENTS = 12;     // Triangles per neuron circle
+    const size_t MAX_DRAWN_CONNECTIONS = 4096; // Connections drawn per layer pair; above this the strongest are kept
     const float LAYER_X_START = 350.0f;    // Starting x-position for the first layer
     const float LAYER_Y = 50.0f;           // Y-position for layers
     const float LAYER_SPACING = 120.0f;    // Spacing between layers
@@ -47,12 +58,16 @@ private:
 public:
     // Constructor: Initializes the GUI with window, input display, datasets, and training parameters
     GUI(sf::RenderWindow& window, Input& inputDisplay, Dataset& trainData, Dataset& testData,
-        double learningRate, int epochs);
+        double learningRate, int epochs, const std::string& modelPath);
+
+    // Destructor: Cancels a training run in progress and frees the network
+    ~GUI();
 
     // Handles user input events (mouse clicks, window close)
     void handleEvents();
 
-    // Draws the GUI elements to the window (layers, neurons, connections, buttons, input display)
+    // Draws the GUI elements to the window (layers, neurons, connections, buttons, input display),
+    // picking up the progress of a training run first
     void draw();
 
     // Getter: Returns the network architecture (layer sizes)
@@ -65,18 +80,32 @@ private:
     // Adds a neuron to the selected layer (circle in GUI, updates layerSizes)
     void addNeuron();
 
-    // Builds the network by creating connections between neurons and initializing the Network object
+    // Builds the network by creating connections between neurons (colored by their weights) and initializing
+    // the Network object (loading the saved model instead when it has the same architecture)
     void buildNetwork();
 
-    // Trains the network using the training dataset, prints loss per epoch
+    // Starts training the network on a worker thread (prints loss per epoch, saves the model when done),
+    // or pauses/resumes the run in progress
     void trainNetwork();
 
+    // Stops the training run in progress; the network keeps the weights trained so far
+    void cancelTraining();
+
+    // Reads the progress and newest weights of the training run, and finishes it once the worker is done
+    void updateTraining();
+
     // Tests the network using the test dataset, prints accuracy
     void testNetwork();
 
     // Helper: Checks if a layer is clicked based on mouse position, updates selectedLayer
     void selectLayer(sf::Vector2f mousePos);
 
+    // Helper: Rebuilds the neuron triangle list from the neuron positions and colors
+    void updateNeuronVertices();
+
+    // Helper: Colors each neuron by the sign and size of its bias
+    void colorNeurons(const std::vector<std::vector<Scalar>>& biases);
+
     // Helper: Draws connections between neurons in adjacent layers
     void drawConnections();
 };
@@ -0,0 +1,246 @@
+//
+//  InferenceServer.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "InferenceServer.hpp"
+#include "Dataset.hpp"
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+// Set by the SIGINT/SIGTERM handler installed by run()
+volatile std::sig_atomic_t signalReceived = 0;
+
+void handleTerminationSignal(int) {
+    signalReceived = 1;
+}
+
+// How long one response write may block before the client is considered stalled and dropped. Responses are
+// written by the single batcher thread, so this bounds how long one client that stops reading can hold up
+// everyone else
+const int SEND_TIMEOUT_MILLISECONDS = 100;
+
+} // namespace
+
+// Constructor: Listens on socketPath
+InferenceServer::InferenceServer(const Network& network, const std::string& socketPath, size_t maxBatchSize,
+                                 unsigned batchWindowMicroseconds)
+    : network(network), socketPath(socketPath), maxBatchSize(maxBatchSize),
+      batchWindow(batchWindowMicroseconds), stopping(false), openConnections(0), activeReaders(0), totalRequests(0), totalBatches(0) {
+    if (maxBatchSize == 0) {
+        throw std::invalid_argument("Batch size must be positive");
+    }
+    listener = UnixSocket::listen(socketPath);
+}
+
+// Destructor: Removes the socket file
+InferenceServer::~InferenceServer() {
+    ::unlink(socketPath.c_str());
+}
+
+// Serves requests until stop() or a termination signal
+void InferenceServer::run(unsigned reportIntervalSeconds) {
+    // A client that disconnects early must not kill the server with SIGPIPE
+    std::signal(SIGPIPE, SIG_IGN);
+    signalReceived = 0;
+    std::signal(SIGINT, handleTerminationSignal);
+    std::signal(SIGTERM, handleTerminationSignal);
+
+    std::cout << "Serving on " << socketPath << " (batches of up to " << maxBatchSize << ", window "
+              << batchWindow.count() << " us)" << std::endl;
+    std::thread acceptor(&InferenceServer::acceptLoop, this);
+    batchLoop(reportIntervalSeconds);
+
+    // Shut down: stop accepting, wake up every reader and wait for them to exit
+    acceptor.join();
+    std::unique_lock<std::mutex> lock(connectionsMutex);
+    for (auto& weak : connections) {
+        if (auto connection = weak.lock()) {
+            connection->shutdown();
+        }
+    }
+    readersDone.wait(lock, [&] { return activeReaders == 0; });
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    std::cout << "Server stopped after " << totalRequests << " requests in " << totalBatches << " batches" << std::endl;
+}
+
+// Asks run() to return
+void InferenceServer::stop() {
+    stopping = true;
+    queueChanged.notify_all();
+}
+
+// Accepts connections until the server stops
+void InferenceServer::acceptLoop() {
+    Hello hello = {};
+    std::memcpy(hello.magic, "NNIS", sizeof(hello.magic));
+    hello.version = PROTOCOL_VERSION;
+    hello.inputSize = static_cast<uint32_t>(network.getInputSize());
+    hello.outputSize = static_cast<uint32_t>(network.getOutputSize());
+
+    while (!stopping) {
+        // Wake up regularly to notice stop requests
+        UnixSocket accepted = listener.accept(100);
+        if (!accepted.isOpen() || !accepted.setSendTimeout(SEND_TIMEOUT_MILLISECONDS) ||
+            !accepted.writeFully(&hello, sizeof(hello))) {
+            continue;
+        }
+        auto connection = std::make_shared<UnixSocket>(std::move(accepted));
+        {
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            // Forget connections that have already closed
+            connections.erase(std::remove_if(connections.begin(), connections.end(),
+                                             [](const std::weak_ptr<UnixSocket>& weak) { return weak.expired(); }),
+                              connections.end());
+            connections.push_back(connection);
+            activeReaders++;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            openConnections++;
+        }
+        std::thread(&InferenceServer::readLoop, this, std::move(connection)).detach();
+    }
+}
+
+// Reads the requests of one connection into the queue
+void InferenceServer::readLoop(std::shared_ptr<UnixSocket> connection) {
+    size_t inputSize = network.getInputSize();
+    try {
+        while (!stopping) {
+            Request request;
+            request.pixels.resize(inputSize);
+            if (!connection->readFully(&request.id, sizeof(request.id)) ||
+                !connection->readFully(request.pixels.data(), inputSize)) {
+                break; // Client closed the connection
+            }
+            request.received = std::chrono::steady_clock::now();
+            request.connection = connection;
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                queue.push_back(std::move(request));
+                queuedPerConnection[connection.get()]++;
+            }
+            queueChanged.notify_one();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Connection error: " << e.what() << std::endl;
+    }
+    {
+        // A closed connection sends nothing more, so the pending batch may no longer need to wait for it
+        std::lock_guard<std::mutex> lock(queueMutex);
+        openConnections--;
+        queuedPerConnection.erase(connection.get());
+        queueChanged.notify_one();
+    }
+    // Last access to the server: run() may return and destroy it as soon as activeReaders reaches zero
+    std::lock_guard<std::mutex> lock(connectionsMutex);
+    activeReaders--;
+    readersDone.notify_all();
+}
+
+// Forms micro-batches, runs them and reports statistics
+void InferenceServer::batchLoop(unsigned reportIntervalSeconds) {
+    std::vector<Request> batch;
+    batch.reserve(maxBatchSize);
+    std::vector<Scalar> inputs(maxBatchSize * network.getInputSize());
+    std::vector<Scalar> probabilities(maxBatchSize * network.getOutputSize());
+    Workspace workspace = network.makeWorkspace(maxBatchSize);
+    std::vector<char> response(sizeof(uint32_t) + network.getOutputSize() * sizeof(float));
+    std::vector<double> latencies;
+    latencies.reserve(maxBatchSize);
+
+    auto reportStart = std::chrono::steady_clock::now();
+    uint64_t reportRequests = 0;
+    uint64_t reportBatches = 0;
+    while (!stopping) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueChanged.wait_for(lock, std::chrono::milliseconds(100), [&] { return !queue.empty() || stopping; });
+            if (!queue.empty()) {
+                // Let more requests join until the batch is full, every open connection has a request waiting
+                // (closed-loop clients send nothing more before their responses), or the oldest one has used up
+                // the window
+                auto deadline = queue.front().received + batchWindow;
+                queueChanged.wait_until(lock, deadline, [&] {
+                    return queue.size() >= maxBatchSize || queuedPerConnection.size() >= openConnections || stopping;
+                });
+                size_t count = std::min(maxBatchSize, queue.size());
+                for (size_t i = 0; i < count; ++i) {
+                    // Connections of exited readers were already removed from the counts
+                    auto queued = queuedPerConnection.find(queue.front().connection.get());
+                    if (queued != queuedPerConnection.end() && --queued->second == 0) {
+                        queuedPerConnection.erase(queued);
+                    }
+                    batch.push_back(std::move(queue.front()));
+                    queue.pop_front();
+                }
+            }
+        }
+        if (!batch.empty()) {
+            processBatch(batch, inputs, probabilities, workspace, response, latencies);
+            totalRequests += batch.size();
+            totalBatches++;
+            reportRequests += batch.size();
+            reportBatches++;
+            batch.clear();
+        }
+        if (signalReceived) {
+            stop();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - reportStart).count();
+        if (reportIntervalSeconds > 0 && elapsed >= reportIntervalSeconds) {
+            printReport(elapsed, reportRequests, reportBatches);
+            reportStart = std::chrono::steady_clock::now();
+            reportRequests = 0;
+            reportBatches = 0;
+        }
+    }
+}
+
+// Runs one micro-batch and writes the responses
+void InferenceServer::processBatch(std::vector<Request>& batch, std::vector<Scalar>& inputs,
+                                   std::vector<Scalar>& probabilities, Workspace& workspace,
+                                   std::vector<char>& response, std::vector<double>& latencies) {
+    size_t inputSize = network.getInputSize();
+    size_t outputSize = network.getOutputSize();
+    for (size_t b = 0; b < batch.size(); ++b) {
+        Dataset::normalizePixels(batch[b].pixels, std::span<Scalar>(inputs.data() + b * inputSize, inputSize));
+    }
+    network.predictBatch(inputs, probabilities, batch.size(), workspace);
+
+    // Only this thread writes after the greeting, so responses need no extra locking
+    for (size_t b = 0; b < batch.size(); ++b) {
+        std::memcpy(response.data(), &batch[b].id, sizeof(uint32_t));
+        for (size_t k = 0; k < outputSize; ++k) {
+            float probability = static_cast<float>(probabilities[b * outputSize + k]);
+            std::memcpy(response.data() + sizeof(uint32_t) + k * sizeof(float), &probability, sizeof(float));
+        }
+        if (!batch[b].connection->writeFully(response.data(), response.size())) {
+            // Gone or stalled (the stream may end in a partial response): drop the connection, which also stops
+            // its reader; its remaining responses fail at once. A vanished client is not an error
+            batch[b].connection->shutdown();
+        }
+        auto latencyTime = std::chrono::steady_clock::now() - batch[b].received;
+        latencies.push_back(std::chrono::duration<double, std::micro>(latencyTime).count());
+    }
+    latency.record(latencies);
+    latencies.clear();
+}
+
+// Prints throughput, batch size and latency percentiles for the last reporting window
+void InferenceServer::printReport(double seconds, uint64_t requests, uint64_t batches) {
+    LatencyStats::Summary summary = latency.summarizeAndReset();
+    std::cout << requests / seconds << " req/s, average batch "
+              << (batches > 0 ? static_cast<double>(requests) / batches : 0.0) << ", latency p50 " << summary.p50
+              << " us, p99 " << summary.p99 << " us, max " << summary.max << " us" << std::endl;
+}
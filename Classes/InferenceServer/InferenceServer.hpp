@@ -0,0 +1,112 @@
+//
+//  InferenceServer.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef InferenceServer_hpp
+#define InferenceServer_hpp
+
+#include "Network.hpp"
+#include "LatencyStats.hpp"
+#include "UnixSocket.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Headless inference server on a Unix domain socket.
+// Requests from all connections are queued and grouped into micro-batches: a batch is run as soon as it
+// is full, every open connection has a request queued, or the oldest request has waited for the batching
+// window, so many small concurrent requests become one matrix-matrix product per layer instead of one
+// matrix-vector product each.
+//
+// Protocol (native byte order): on connect the server sends a Hello. The client then sends requests made
+// of a uint32 id followed by inputSize raw 0-255 pixels; each response is the same id followed by
+// outputSize float probabilities. Requests may be pipelined; a connection's responses keep request order.
+class InferenceServer {
+public:
+    // Greeting sent to every new connection
+    struct Hello {
+        char magic[4];          // "NNIS"
+        uint32_t version;       // Protocol version (PROTOCOL_VERSION)
+        uint32_t inputSize;     // Pixels per request
+        uint32_t outputSize;    // Probabilities per response
+    };
+
+    static constexpr uint32_t PROTOCOL_VERSION = 1;
+
+private:
+    // A request waiting to be batched
+    struct Request {
+        std::shared_ptr<UnixSocket> connection;             // Where the response goes
+        uint32_t id;                                        // Client-chosen request id
+        std::vector<uint8_t> pixels;                        // Raw input pixels
+        std::chrono::steady_clock::time_point received;     // When the request was fully read
+    };
+
+    const Network& network;                 // Model being served (only const, reentrant calls are used)
+    std::string socketPath;                 // Path of the listening socket
+    size_t maxBatchSize;                    // Largest micro-batch
+    std::chrono::microseconds batchWindow;  // How long the oldest queued request may wait for others to join
+    UnixSocket listener;                    // Listening socket
+
+    std::atomic<bool> stopping;             // Set by stop() or a termination signal
+    std::mutex queueMutex;                  // Guards queue, queuedPerConnection and openConnections
+    std::condition_variable queueChanged;   // Signalled when requests arrive, a reader exits or the server stops
+    std::deque<Request> queue;              // Requests waiting for the batcher
+    std::map<const UnixSocket*, size_t> queuedPerConnection; // Queued requests of each open connection that has any
+    size_t openConnections;                 // Connections whose reader is still running
+
+    std::mutex connectionsMutex;                        // Guards connections and activeReaders
+    std::condition_variable readersDone;                // Signalled when a reader thread exits
+    std::vector<std::weak_ptr<UnixSocket>> connections; // Open connections (shut down on stop)
+    size_t activeReaders;                               // Number of running reader threads
+
+    LatencyStats latency;                   // Per-request latency: request read -> response written
+    uint64_t totalRequests;                 // Requests served since run() started
+    uint64_t totalBatches;                  // Batches run since run() started
+
+    // Accepts connections until the server stops (runs on its own thread)
+    void acceptLoop();
+
+    // Reads the requests of one connection into the queue (one detached thread per connection)
+    void readLoop(std::shared_ptr<UnixSocket> connection);
+
+    // Forms micro-batches, runs them and reports statistics (runs on the thread that called run())
+    void batchLoop(unsigned reportIntervalSeconds);
+
+    // Runs one micro-batch and writes the responses
+    void processBatch(std::vector<Request>& batch, std::vector<Scalar>& inputs, std::vector<Scalar>& probabilities,
+                      Workspace& workspace, std::vector<char>& response, std::vector<double>& latencies);
+
+    // Prints throughput, batch size and latency percentiles for the last reporting window
+    void printReport(double seconds, uint64_t requests, uint64_t batches);
+
+public:
+    // Constructor: Listens on socketPath; throws std::runtime_error if the socket cannot be created
+    InferenceServer(const Network& network, const std::string& socketPath, size_t maxBatchSize = 32,
+                    unsigned batchWindowMicroseconds = 1000);
+
+    // Destructor: Removes the socket file
+    ~InferenceServer();
+
+    InferenceServer(const InferenceServer&) = delete;
+    InferenceServer& operator=(const InferenceServer&) = delete;
+
+    // Serves requests until stop() is called or the process receives SIGINT/SIGTERM,
+    // printing statistics every reportIntervalSeconds
+    void run(unsigned reportIntervalSeconds = 5);
+
+    // Asks run() to return (safe to call from any thread)
+    void stop();
+};
+
+#endif /* InferenceServer_hpp */
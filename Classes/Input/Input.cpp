@@ -5,50 +5,61 @@
 //  Created by Necati Sefercioğlu
 //
 
-#include "input.hpp"
+#include "Input.hpp"
+#include <algorithm>
 #include <stdexcept>
 
-// Constructor: Initializes the display rectangles
-Input::Input() {
-    // Create 784 rectangles for a 280x280 display at position (10, 50)
-    pixelRects.resize(784);
-    for (int i = 0; i < 28; ++i) {
-        for (int j = 0; j < 28; ++j) {
-            int index = i * 28 + j;
-            pixelRects[index].setSize(sf::Vector2f(10.f, 10.f));
-            pixelRects[index].setPosition(10.f + static_cast<float>(j * 10), 50.f + static_cast<float>(i * 10));
-            pixelRects[index].setFillColor(sf::Color::White);
-        }
+namespace {
+
+const unsigned SIDE = 28;       // Pixels per row and column of a sample
+const float SCALE = 10.f;       // Screen pixels per sample pixel
+const float LEFT = 10.f;        // Position of the display in the window
+const float TOP = 50.f;
+
+} // namespace
+
+// Constructor: Creates the texture and shows a blank sample
+Input::Input() : currentSample(SIDE * SIDE, 0), rgba(SIDE * SIDE * 4) {
+    if (!texture.create(SIDE, SIDE)) {
+        throw std::runtime_error("Failed to create input display texture");
     }
-    // Initialize sample with zeros
-    currentSample.resize(784, 0.0);
+    texture.setSmooth(false); // Keep the pixels sharp when scaled up
+    sprite.setTexture(texture);
+    sprite.setPosition(LEFT, TOP);
+    sprite.setScale(SCALE, SCALE);
+
+    // Black border around the 280x280 display
+    border.setSize(sf::Vector2f(SIDE * SCALE, SIDE * SCALE));
+    border.setPosition(LEFT, TOP);
+    border.setFillColor(sf::Color::Transparent);
+    border.setOutlineColor(sf::Color::Black);
+    border.setOutlineThickness(2.f);
+
+    // Start blank (white)
+    std::fill(rgba.begin(), rgba.end(), sf::Uint8(255));
+    texture.update(rgba.data());
 }
 
 // Updates the display with a new sample
-void Input::setSample(const std::vector<double>& sample) {
+void Input::setSample(std::span<const uint8_t> sample) {
     // Validate sample size
-    if (sample.size() != 784) {
+    if (sample.size() != SIDE * SIDE) {
         throw std::invalid_argument("Sample must have 784 pixel values");
     }
-    currentSample = sample;
-    // Update rectangle colors: invert mapping for correct display
-    for (int i = 0; i < 784; ++i) {
-        uint8_t colorValue = static_cast<uint8_t>((1.0 - currentSample[i]) * 255);
-        pixelRects[i].setFillColor(sf::Color(colorValue, colorValue, colorValue));
+    currentSample.assign(sample.begin(), sample.end());
+    // Invert the values so ink is dark on a white background, then upload the whole image at once
+    for (size_t i = 0; i < currentSample.size(); ++i) {
+        sf::Uint8 colorValue = static_cast<sf::Uint8>(255 - currentSample[i]);
+        rgba[4 * i] = colorValue;
+        rgba[4 * i + 1] = colorValue;
+        rgba[4 * i + 2] = colorValue;
+        rgba[4 * i + 3] = 255;
     }
+    texture.update(rgba.data());
 }
 
 // Draws the input display to the window
 void Input::draw(sf::RenderWindow& window) {
-    // Draw black border around the 280x280 display
-    sf::RectangleShape border(sf::Vector2f(280.f, 280.f));
-    border.setPosition(10.f, 50.f);
-    border.setFillColor(sf::Color::Transparent);
-    border.setOutlineColor(sf::Color::Black);
-    border.setOutlineThickness(2.f);
+    window.draw(sprite);
     window.draw(border);
-    // Render each rectangle
-    for (const auto& rect : pixelRects) {
-        window.draw(rect);
-    }
 }
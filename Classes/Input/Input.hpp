@@ -9,23 +9,35 @@
 #define Input_hpp
 
 #include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <span>
 #include <vector>
 
-// Class representing the input display for MNIST samples
+// Class representing the input display for MNIST samples.
+// The sample lives in a 28x28 texture drawn scaled up by one sprite, so a new sample is a single
+// texture upload and the display costs two draw calls (border and sprite)
 class Input {
 private:
-    std::vector<sf::RectangleShape> pixelRects; // Rectangles for scaled pixel display
-    std::vector<double> currentSample;          // Pixel values of the current sample
+    sf::Texture texture;                        // 28x28 texture holding the current sample
+    sf::Sprite sprite;                          // Draws the texture scaled to 280x280
+    sf::RectangleShape border;                  // Black frame around the display
+    std::vector<uint8_t> currentSample;         // Raw 0-255 pixel values of the current sample
+    std::vector<sf::Uint8> rgba;                // Upload buffer: 4 bytes per pixel
 
 public:
-    // Constructor: Initializes the display rectangles
+    // Constructor: Creates the texture and shows a blank sample
+    // Throws: std::runtime_error if the texture cannot be created
     Input();
 
+    // The sprite points at this object's texture, so the display cannot be copied
+    Input(const Input&) = delete;
+    Input& operator=(const Input&) = delete;
+
     // Updates the display with a new sample
     // Parameters:
-    //   sample: Vector of 784 normalized pixel values
+    //   sample: 784 raw pixel values (0-255)
     // Throws: std::invalid_argument if sample size is incorrect
-    void setSample(const std::vector<double>& sample);
+    void setSample(std::span<const uint8_t> sample);
 
     // Draws the input display to the window
     // Parameters:
@@ -0,0 +1,1080 @@
+//
+//  Kernels.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "Kernels.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// ---- Scalar kernels (portable fallback and reference) ----
+
+template <typename T>
+T dotScalar(const T* x, const T* y, size_t n) {
+    T sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += x[i] * y[i];
+    }
+    return sum;
+}
+
+template <typename T>
+void axpyScalar(T alpha, const T* x, T* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        y[i] += alpha * x[i];
+    }
+}
+
+template <typename T>
+void multiAxpyScalar(const T* alpha, const T* x, size_t stride, size_t count, T* y, size_t n) {
+    for (size_t j = 0; j < count; ++j) {
+        axpyScalar(alpha[j], x + j * stride, y, n);
+    }
+}
+
+template <typename T>
+T sparseDotScalar(const T* x, const uint32_t* indices, const T* values, size_t n) {
+    T sum = 0;
+    for (size_t k = 0; k < n; ++k) {
+        sum += values[k] * x[indices[k]];
+    }
+    return sum;
+}
+
+template <typename T>
+void sparseAxpyScalar(T alpha, const uint32_t* indices, const T* values, T* y, size_t n) {
+    for (size_t k = 0; k < n; ++k) {
+        y[indices[k]] += alpha * values[k];
+    }
+}
+
+template <typename T>
+void addBiasScalar(T* y, const T* bias, size_t n, bool relu) {
+    for (size_t i = 0; i < n; ++i) {
+        T v = y[i] + bias[i];
+        y[i] = relu ? std::max(T(0), v) : v;
+    }
+}
+
+template <typename T>
+void reluMaskScalar(T* delta, const T* activations, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        if (!(activations[i] > 0)) {
+            delta[i] = 0;
+        }
+    }
+}
+
+template <typename T>
+void momentumScalar(T* w, const T* g, T* v, size_t n, const Kernels::MomentumStep<T>& step) {
+    for (size_t i = 0; i < n; ++i) {
+        T gradient = step.gradientScale * g[i] + step.l2Decay * w[i];
+        T velocity = step.momentum * v[i] + gradient;
+        v[i] = velocity;
+        w[i] -= step.learningRate * (step.nesterov ? gradient + step.momentum * velocity : velocity);
+    }
+}
+
+template <typename T>
+void adamScalar(T* w, const T* g, T* m, T* v, size_t n, const Kernels::AdamStep<T>& step) {
+    for (size_t i = 0; i < n; ++i) {
+        T gradient = step.gradientScale * g[i] + step.l2Decay * w[i];
+        T first = step.beta1 * m[i] + (1 - step.beta1) * gradient;
+        T second = step.beta2 * v[i] + (1 - step.beta2) * gradient * gradient;
+        m[i] = first;
+        v[i] = second;
+        T update = first * step.correction1 / (std::sqrt(second * step.correction2) + step.epsilon);
+        w[i] -= step.learningRate * (update + step.decoupledDecay * w[i]);
+    }
+}
+
+// Unsigned x signed bytes, accumulated exactly in 32 bits
+int32_t dotU8S8Scalar(const uint8_t* x, const int8_t* w, size_t n) {
+    int32_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += static_cast<int32_t>(x[i]) * w[i];
+    }
+    return sum;
+}
+
+#ifdef KERNELS_X86
+
+// ---- AVX2 + FMA kernels (4 doubles per register) ----
+
+__attribute__((target("avx2,fma")))
+double dotAVX2(const double* x, const double* y, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), acc1);
+    }
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), acc0);
+    }
+    __m256d acc = _mm256_add_pd(acc0, acc1);
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+    double sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    for (; i < n; ++i) {
+        sum += x[i] * y[i];
+    }
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+void axpyAVX2(double alpha, const double* x, double* y, size_t n) {
+    __m256d a = _mm256_set1_pd(alpha);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(y + i, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    }
+    for (; i < n; ++i) {
+        y[i] += alpha * x[i];
+    }
+}
+
+// Fused axpys keep a block of y in registers across all count rows of x, so y is loaded and stored once
+__attribute__((target("avx2,fma")))
+void multiAxpyAVX2(const double* alpha, const double* x, size_t stride, size_t count, double* y, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256d acc0 = _mm256_loadu_pd(y + i);
+        __m256d acc1 = _mm256_loadu_pd(y + i + 4);
+        __m256d acc2 = _mm256_loadu_pd(y + i + 8);
+        __m256d acc3 = _mm256_loadu_pd(y + i + 12);
+        for (size_t j = 0; j < count; ++j) {
+            __m256d a = _mm256_set1_pd(alpha[j]);
+            const double* row = x + j * stride + i;
+            acc0 = _mm256_fmadd_pd(a, _mm256_loadu_pd(row), acc0);
+            acc1 = _mm256_fmadd_pd(a, _mm256_loadu_pd(row + 4), acc1);
+            acc2 = _mm256_fmadd_pd(a, _mm256_loadu_pd(row + 8), acc2);
+            acc3 = _mm256_fmadd_pd(a, _mm256_loadu_pd(row + 12), acc3);
+        }
+        _mm256_storeu_pd(y + i, acc0);
+        _mm256_storeu_pd(y + i + 4, acc1);
+        _mm256_storeu_pd(y + i + 8, acc2);
+        _mm256_storeu_pd(y + i + 12, acc3);
+    }
+    for (; i + 4 <= n; i += 4) {
+        __m256d acc = _mm256_loadu_pd(y + i);
+        for (size_t j = 0; j < count; ++j) {
+            acc = _mm256_fmadd_pd(_mm256_set1_pd(alpha[j]), _mm256_loadu_pd(x + j * stride + i), acc);
+        }
+        _mm256_storeu_pd(y + i, acc);
+    }
+    if (i < n) {
+        multiAxpyScalar(alpha, x + i, stride, count, y + i, n - i);
+    }
+}
+
+// AVX2 has gathers but no scatters, so only the sparse dot product is vectorized
+__attribute__((target("avx2,fma")))
+double sparseDotAVX2(const double* x, const uint32_t* indices, const double* values, size_t n) {
+    __m256d acc = _mm256_setzero_pd();
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        __m128i index = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + k));
+        acc = _mm256_fmadd_pd(_mm256_loadu_pd(values + k), _mm256_i32gather_pd(x, index, 8), acc);
+    }
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+    double sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    return sum + sparseDotScalar(x, indices + k, values + k, n - k);
+}
+
+__attribute__((target("avx2,fma")))
+void addBiasAVX2(double* y, const double* bias, size_t n, bool relu) {
+    __m256d zero = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_add_pd(_mm256_loadu_pd(y + i), _mm256_loadu_pd(bias + i));
+        _mm256_storeu_pd(y + i, relu ? _mm256_max_pd(v, zero) : v);
+    }
+    addBiasScalar(y + i, bias + i, n - i, relu);
+}
+
+__attribute__((target("avx2,fma")))
+void reluMaskAVX2(double* delta, const double* activations, size_t n) {
+    __m256d zero = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d active = _mm256_cmp_pd(_mm256_loadu_pd(activations + i), zero, _CMP_GT_OQ);
+        _mm256_storeu_pd(delta + i, _mm256_and_pd(_mm256_loadu_pd(delta + i), active));
+    }
+    reluMaskScalar(delta + i, activations + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+void momentumAVX2(double* w, const double* g, double* v, size_t n, const Kernels::MomentumStep<double>& step) {
+    __m256d scale = _mm256_set1_pd(step.gradientScale);
+    __m256d decay = _mm256_set1_pd(step.l2Decay);
+    __m256d mu = _mm256_set1_pd(step.momentum);
+    __m256d rate = _mm256_set1_pd(step.learningRate);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d weights = _mm256_loadu_pd(w + i);
+        __m256d gradient = _mm256_fmadd_pd(scale, _mm256_loadu_pd(g + i), _mm256_mul_pd(decay, weights));
+        __m256d velocity = _mm256_fmadd_pd(mu, _mm256_loadu_pd(v + i), gradient);
+        _mm256_storeu_pd(v + i, velocity);
+        __m256d direction = step.nesterov ? _mm256_fmadd_pd(mu, velocity, gradient) : velocity;
+        _mm256_storeu_pd(w + i, _mm256_fnmadd_pd(rate, direction, weights));
+    }
+    momentumScalar(w + i, g + i, v + i, n - i, step);
+}
+
+__attribute__((target("avx2,fma")))
+void adamAVX2(double* w, const double* g, double* m, double* v, size_t n, const Kernels::AdamStep<double>& step) {
+    __m256d scale = _mm256_set1_pd(step.gradientScale);
+    __m256d decay = _mm256_set1_pd(step.l2Decay);
+    __m256d beta1 = _mm256_set1_pd(step.beta1);
+    __m256d beta2 = _mm256_set1_pd(step.beta2);
+    __m256d oneMinusBeta1 = _mm256_set1_pd(1 - step.beta1);
+    __m256d oneMinusBeta2 = _mm256_set1_pd(1 - step.beta2);
+    __m256d correction1 = _mm256_set1_pd(step.correction1);
+    __m256d correction2 = _mm256_set1_pd(step.correction2);
+    __m256d epsilon = _mm256_set1_pd(step.epsilon);
+    __m256d decoupled = _mm256_set1_pd(step.decoupledDecay);
+    __m256d rate = _mm256_set1_pd(step.learningRate);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d weights = _mm256_loadu_pd(w + i);
+        __m256d gradient = _mm256_fmadd_pd(scale, _mm256_loadu_pd(g + i), _mm256_mul_pd(decay, weights));
+        __m256d first = _mm256_fmadd_pd(beta1, _mm256_loadu_pd(m + i), _mm256_mul_pd(oneMinusBeta1, gradient));
+        __m256d second = _mm256_fmadd_pd(beta2, _mm256_loadu_pd(v + i),
+                                         _mm256_mul_pd(oneMinusBeta2, _mm256_mul_pd(gradient, gradient)));
+        _mm256_storeu_pd(m + i, first);
+        _mm256_storeu_pd(v + i, second);
+        __m256d denominator = _mm256_add_pd(_mm256_sqrt_pd(_mm256_mul_pd(second, correction2)), epsilon);
+        __m256d update = _mm256_fmadd_pd(decoupled, weights, _mm256_div_pd(_mm256_mul_pd(first, correction1), denominator));
+        _mm256_storeu_pd(w + i, _mm256_fnmadd_pd(rate, update, weights));
+    }
+    adamScalar(w + i, g + i, m + i, v + i, n - i, step);
+}
+
+// ---- AVX2 + FMA kernels (8 floats per register) ----
+
+__attribute__((target("avx2,fma")))
+float dotAVX2(const float* x, const float* y, size_t n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8), acc1);
+    }
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), acc0);
+    }
+    __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 quad = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    __m128 pair = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+    float sum = _mm_cvtss_f32(_mm_add_ss(pair, _mm_shuffle_ps(pair, pair, 1)));
+    for (; i < n; ++i) {
+        sum += x[i] * y[i];
+    }
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+void axpyAVX2(float alpha, const float* x, float* y, size_t n) {
+    __m256 a = _mm256_set1_ps(alpha);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(a, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+    }
+    for (; i < n; ++i) {
+        y[i] += alpha * x[i];
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void multiAxpyAVX2(const float* alpha, const float* x, size_t stride, size_t count, float* y, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256 acc0 = _mm256_loadu_ps(y + i);
+        __m256 acc1 = _mm256_loadu_ps(y + i + 8);
+        __m256 acc2 = _mm256_loadu_ps(y + i + 16);
+        __m256 acc3 = _mm256_loadu_ps(y + i + 24);
+        for (size_t j = 0; j < count; ++j) {
+            __m256 a = _mm256_set1_ps(alpha[j]);
+            const float* row = x + j * stride + i;
+            acc0 = _mm256_fmadd_ps(a, _mm256_loadu_ps(row), acc0);
+            acc1 = _mm256_fmadd_ps(a, _mm256_loadu_ps(row + 8), acc1);
+            acc2 = _mm256_fmadd_ps(a, _mm256_loadu_ps(row + 16), acc2);
+            acc3 = _mm256_fmadd_ps(a, _mm256_loadu_ps(row + 24), acc3);
+        }
+        _mm256_storeu_ps(y + i, acc0);
+        _mm256_storeu_ps(y + i + 8, acc1);
+        _mm256_storeu_ps(y + i + 16, acc2);
+        _mm256_storeu_ps(y + i + 24, acc3);
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m256 acc = _mm256_loadu_ps(y + i);
+        for (size_t j = 0; j < count; ++j) {
+            acc = _mm256_fmadd_ps(_mm256_set1_ps(alpha[j]), _mm256_loadu_ps(x + j * stride + i), acc);
+        }
+        _mm256_storeu_ps(y + i, acc);
+    }
+    if (i < n) {
+        multiAxpyScalar(alpha, x + i, stride, count, y + i, n - i);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+float sparseDotAVX2(const float* x, const uint32_t* indices, const float* values, size_t n) {
+    __m256 acc = _mm256_setzero_ps();
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + k));
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(values + k), _mm256_i32gather_ps(x, index, 4), acc);
+    }
+    __m128 quad = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    __m128 pair = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+    float sum = _mm_cvtss_f32(_mm_add_ss(pair, _mm_shuffle_ps(pair, pair, 1)));
+    return sum + sparseDotScalar(x, indices + k, values + k, n - k);
+}
+
+__attribute__((target("avx2,fma")))
+void addBiasAVX2(float* y, const float* bias, size_t n, bool relu) {
+    __m256 zero = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_loadu_ps(bias + i));
+        _mm256_storeu_ps(y + i, relu ? _mm256_max_ps(v, zero) : v);
+    }
+    addBiasScalar(y + i, bias + i, n - i, relu);
+}
+
+__attribute__((target("avx2,fma")))
+void reluMaskAVX2(float* delta, const float* activations, size_t n) {
+    __m256 zero = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 active = _mm256_cmp_ps(_mm256_loadu_ps(activations + i), zero, _CMP_GT_OQ);
+        _mm256_storeu_ps(delta + i, _mm256_and_ps(_mm256_loadu_ps(delta + i), active));
+    }
+    reluMaskScalar(delta + i, activations + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+void momentumAVX2(float* w, const float* g, float* v, size_t n, const Kernels::MomentumStep<float>& step) {
+    __m256 scale = _mm256_set1_ps(step.gradientScale);
+    __m256 decay = _mm256_set1_ps(step.l2Decay);
+    __m256 mu = _mm256_set1_ps(step.momentum);
+    __m256 rate = _mm256_set1_ps(step.learningRate);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 weights = _mm256_loadu_ps(w + i);
+        __m256 gradient = _mm256_fmadd_ps(scale, _mm256_loadu_ps(g + i), _mm256_mul_ps(decay, weights));
+        __m256 velocity = _mm256_fmadd_ps(mu, _mm256_loadu_ps(v + i), gradient);
+        _mm256_storeu_ps(v + i, velocity);
+        __m256 direction = step.nesterov ? _mm256_fmadd_ps(mu, velocity, gradient) : velocity;
+        _mm256_storeu_ps(w + i, _mm256_fnmadd_ps(rate, direction, weights));
+    }
+    momentumScalar(w + i, g + i, v + i, n - i, step);
+}
+
+__attribute__((target("avx2,fma")))
+void adamAVX2(float* w, const float* g, float* m, float* v, size_t n, const Kernels::AdamStep<float>& step) {
+    __m256 scale = _mm256_set1_ps(step.gradientScale);
+    __m256 decay = _mm256_set1_ps(step.l2Decay);
+    __m256 beta1 = _mm256_set1_ps(step.beta1);
+    __m256 beta2 = _mm256_set1_ps(step.beta2);
+    __m256 oneMinusBeta1 = _mm256_set1_ps(1 - step.beta1);
+    __m256 oneMinusBeta2 = _mm256_set1_ps(1 - step.beta2);
+    __m256 correction1 = _mm256_set1_ps(step.correction1);
+    __m256 correction2 = _mm256_set1_ps(step.correction2);
+    __m256 epsilon = _mm256_set1_ps(step.epsilon);
+    __m256 decoupled = _mm256_set1_ps(step.decoupledDecay);
+    __m256 rate = _mm256_set1_ps(step.learningRate);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 weights = _mm256_loadu_ps(w + i);
+        __m256 gradient = _mm256_fmadd_ps(scale, _mm256_loadu_ps(g + i), _mm256_mul_ps(decay, weights));
+        __m256 first = _mm256_fmadd_ps(beta1, _mm256_loadu_ps(m + i), _mm256_mul_ps(oneMinusBeta1, gradient));
+        __m256 second = _mm256_fmadd_ps(beta2, _mm256_loadu_ps(v + i),
+                                        _mm256_mul_ps(oneMinusBeta2, _mm256_mul_ps(gradient, gradient)));
+        _mm256_storeu_ps(m + i, first);
+        _mm256_storeu_ps(v + i, second);
+        __m256 denominator = _mm256_add_ps(_mm256_sqrt_ps(_mm256_mul_ps(second, correction2)), epsilon);
+        __m256 update = _mm256_fmadd_ps(decoupled, weights, _mm256_div_ps(_mm256_mul_ps(first, correction1), denominator));
+        _mm256_storeu_ps(w + i, _mm256_fnmadd_ps(rate, update, weights));
+    }
+    adamScalar(w + i, g + i, m + i, v + i, n - i, step);
+}
+
+// ---- AVX2 int8 kernel (16 bytes per step, widened to 16 bits) ----
+
+// Both operands are widened to 16 bits so madd cannot saturate (|255 * 127 * 2| < 2^31)
+__attribute__((target("avx2,fma")))
+int32_t dotU8S8AVX2(const uint8_t* x, const int8_t* w, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i xv = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+        __m256i wv = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i)));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(xv, wv));
+    }
+    __m128i quad = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    __m128i pair = _mm_add_epi32(quad, _mm_unpackhi_epi64(quad, quad));
+    int32_t sum = _mm_cvtsi128_si32(_mm_add_epi32(pair, _mm_shuffle_epi32(pair, 1)));
+    return sum + dotU8S8Scalar(x + i, w + i, n - i);
+}
+
+// ---- AVX-512 kernels (8 doubles per register, masked tails) ----
+
+__attribute__((target("avx512f")))
+double dotAVX512(const double* x, const double* y, size_t n) {
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), acc0);
+        acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8), acc1);
+    }
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), acc0);
+    }
+    if (i < n) {
+        __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+        acc1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i), acc1);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1));
+}
+
+__attribute__((target("avx512f")))
+void axpyAVX512(double alpha, const double* x, double* y, size_t n) {
+    __m512d a = _mm512_set1_pd(alpha);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_pd(y + i, _mm512_fmadd_pd(a, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+    }
+    if (i < n) {
+        __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+        __m512d v = _mm512_fmadd_pd(a, _mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i));
+        _mm512_mask_storeu_pd(y + i, mask, v);
+    }
+}
+
+__attribute__((target("avx512f")))
+void multiAxpyAVX512(const double* alpha, const double* x, size_t stride, size_t count, double* y, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m512d acc0 = _mm512_loadu_pd(y + i);
+        __m512d acc1 = _mm512_loadu_pd(y + i + 8);
+        __m512d acc2 = _mm512_loadu_pd(y + i + 16);
+        __m512d acc3 = _mm512_loadu_pd(y + i + 24);
+        for (size_t j = 0; j < count; ++j) {
+            __m512d a = _mm512_set1_pd(alpha[j]);
+            const double* row = x + j * stride + i;
+            acc0 = _mm512_fmadd_pd(a, _mm512_loadu_pd(row), acc0);
+            acc1 = _mm512_fmadd_pd(a, _mm512_loadu_pd(row + 8), acc1);
+            acc2 = _mm512_fmadd_pd(a, _mm512_loadu_pd(row + 16), acc2);
+            acc3 = _mm512_fmadd_pd(a, _mm512_loadu_pd(row + 24), acc3);
+        }
+        _mm512_storeu_pd(y + i, acc0);
+        _mm512_storeu_pd(y + i + 8, acc1);
+        _mm512_storeu_pd(y + i + 16, acc2);
+        _mm512_storeu_pd(y + i + 24, acc3);
+    }
+    for (; i < n; i += 8) {
+        __mmask8 mask = n - i >= 8 ? __mmask8(0xFF) : static_cast<__mmask8>((1u << (n - i)) - 1);
+        __m512d acc = _mm512_maskz_loadu_pd(mask, y + i);
+        for (size_t j = 0; j < count; ++j) {
+            acc = _mm512_fmadd_pd(_mm512_set1_pd(alpha[j]), _mm512_maskz_loadu_pd(mask, x + j * stride + i), acc);
+        }
+        _mm512_mask_storeu_pd(y + i, mask, acc);
+    }
+}
+
+// Sparse kernels gather (and scatter) 8 nonzeros per step; the few leftover ones run through the scalar versions
+__attribute__((target("avx512f")))
+double sparseDotAVX512(const double* x, const uint32_t* indices, const double* values, size_t n) {
+    __m512d acc = _mm512_setzero_pd();
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + k));
+        acc = _mm512_fmadd_pd(_mm512_loadu_pd(values + k), _mm512_i32gather_pd(index, x, 8), acc);
+    }
+    return _mm512_reduce_add_pd(acc) + sparseDotScalar(x, indices + k, values + k, n - k);
+}
+
+__attribute__((target("avx512f")))
+void sparseAxpyAVX512(double alpha, const uint32_t* indices, const double* values, double* y, size_t n) {
+    __m512d a = _mm512_set1_pd(alpha);
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        // Indices are distinct, so the scattered lanes never overlap
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + k));
+        __m512d v = _mm512_fmadd_pd(a, _mm512_loadu_pd(values + k), _mm512_i32gather_pd(index, y, 8));
+        _mm512_i32scatter_pd(y, index, v, 8);
+    }
+    sparseAxpyScalar(alpha, indices + k, values + k, y, n - k);
+}
+
+__attribute__((target("avx512f")))
+void addBiasAVX512(double* y, const double* bias, size_t n, bool relu) {
+    __m512d zero = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d v = _mm512_add_pd(_mm512_loadu_pd(y + i), _mm512_loadu_pd(bias + i));
+        _mm512_storeu_pd(y + i, relu ? _mm512_max_pd(v, zero) : v);
+    }
+    if (i < n) {
+        __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+        __m512d v = _mm512_add_pd(_mm512_maskz_loadu_pd(mask, y + i), _mm512_maskz_loadu_pd(mask, bias + i));
+        _mm512_mask_storeu_pd(y + i, mask, relu ? _mm512_max_pd(v, zero) : v);
+    }
+}
+
+__attribute__((target("avx512f")))
+void reluMaskAVX512(double* delta, const double* activations, size_t n) {
+    __m512d zero = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __mmask8 inactive = _mm512_cmp_pd_mask(_mm512_loadu_pd(activations + i), zero, _CMP_NGT_UQ);
+        _mm512_mask_storeu_pd(delta + i, inactive, zero);
+    }
+    if (i < n) {
+        __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+        __mmask8 inactive = _mm512_mask_cmp_pd_mask(mask, _mm512_maskz_loadu_pd(mask, activations + i), zero, _CMP_NGT_UQ);
+        _mm512_mask_storeu_pd(delta + i, inactive, zero);
+    }
+}
+
+// The optimizer kernels are memory bound, so their short tails run through the scalar versions
+__attribute__((target("avx512f")))
+void momentumAVX512(double* w, const double* g, double* v, size_t n, const Kernels::MomentumStep<double>& step) {
+    __m512d scale = _mm512_set1_pd(step.gradientScale);
+    __m512d decay = _mm512_set1_pd(step.l2Decay);
+    __m512d mu = _mm512_set1_pd(step.momentum);
+    __m512d rate = _mm512_set1_pd(step.learningRate);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d weights = _mm512_loadu_pd(w + i);
+        __m512d gradient = _mm512_fmadd_pd(scale, _mm512_loadu_pd(g + i), _mm512_mul_pd(decay, weights));
+        __m512d velocity = _mm512_fmadd_pd(mu, _mm512_loadu_pd(v + i), gradient);
+        _mm512_storeu_pd(v + i, velocity);
+        __m512d direction = step.nesterov ? _mm512_fmadd_pd(mu, velocity, gradient) : velocity;
+        _mm512_storeu_pd(w + i, _mm512_fnmadd_pd(rate, direction, weights));
+    }
+    momentumScalar(w + i, g + i, v + i, n - i, step);
+}
+
+__attribute__((target("avx512f")))
+void adamAVX512(double* w, const double* g, double* m, double* v, size_t n, const Kernels::AdamStep<double>& step) {
+    __m512d scale = _mm512_set1_pd(step.gradientScale);
+    __m512d decay = _mm512_set1_pd(step.l2Decay);
+    __m512d beta1 = _mm512_set1_pd(step.beta1);
+    __m512d beta2 = _mm512_set1_pd(step.beta2);
+    __m512d oneMinusBeta1 = _mm512_set1_pd(1 - step.beta1);
+    __m512d oneMinusBeta2 = _mm512_set1_pd(1 - step.beta2);
+    __m512d correction1 = _mm512_set1_pd(step.correction1);
+    __m512d correction2 = _mm512_set1_pd(step.correction2);
+    __m512d epsilon = _mm512_set1_pd(step.epsilon);
+    __m512d decoupled = _mm512_set1_pd(step.decoupledDecay);
+    __m512d rate = _mm512_set1_pd(step.learningRate);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d weights = _mm512_loadu_pd(w + i);
+        __m512d gradient = _mm512_fmadd_pd(scale, _mm512_loadu_pd(g + i), _mm512_mul_pd(decay, weights));
+        __m512d first = _mm512_fmadd_pd(beta1, _mm512_loadu_pd(m + i), _mm512_mul_pd(oneMinusBeta1, gradient));
+        __m512d second = _mm512_fmadd_pd(beta2, _mm512_loadu_pd(v + i),
+                                         _mm512_mul_pd(oneMinusBeta2, _mm512_mul_pd(gradient, gradient)));
+        _mm512_storeu_pd(m + i, first);
+        _mm512_storeu_pd(v + i, second);
+        __m512d denominator = _mm512_add_pd(_mm512_sqrt_pd(_mm512_mul_pd(second, correction2)), epsilon);
+        __m512d update = _mm512_fmadd_pd(decoupled, weights, _mm512_div_pd(_mm512_mul_pd(first, correction1), denominator));
+        _mm512_storeu_pd(w + i, _mm512_fnmadd_pd(rate, update, weights));
+    }
+    adamScalar(w + i, g + i, m + i, v + i, n - i, step);
+}
+
+// ---- AVX-512 kernels (16 floats per register, masked tails) ----
+
+__attribute__((target("avx512f")))
+float dotAVX512(const float* x, const float* y, size_t n) {
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 16), _mm512_loadu_ps(y + i + 16), acc1);
+    }
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), acc0);
+    }
+    if (i < n) {
+        __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+        acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i), acc1);
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+__attribute__((target("avx512f")))
+void axpyAVX512(float alpha, const float* x, float* y, size_t n) {
+    __m512 a = _mm512_set1_ps(alpha);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(y + i, _mm512_fmadd_ps(a, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+    }
+    if (i < n) {
+        __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+        __m512 v = _mm512_fmadd_ps(a, _mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i));
+        _mm512_mask_storeu_ps(y + i, mask, v);
+    }
+}
+
+__attribute__((target("avx512f")))
+void multiAxpyAVX512(const float* alpha, const float* x, size_t stride, size_t count, float* y, size_t n) {
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m512 acc0 = _mm512_loadu_ps(y + i);
+        __m512 acc1 = _mm512_loadu_ps(y + i + 16);
+        __m512 acc2 = _mm512_loadu_ps(y + i + 32);
+        __m512 acc3 = _mm512_loadu_ps(y + i + 48);
+        for (size_t j = 0; j < count; ++j) {
+            __m512 a = _mm512_set1_ps(alpha[j]);
+            const float* row = x + j * stride + i;
+            acc0 = _mm512_fmadd_ps(a, _mm512_loadu_ps(row), acc0);
+            acc1 = _mm512_fmadd_ps(a, _mm512_loadu_ps(row + 16), acc1);
+            acc2 = _mm512_fmadd_ps(a, _mm512_loadu_ps(row + 32), acc2);
+            acc3 = _mm512_fmadd_ps(a, _mm512_loadu_ps(row + 48), acc3);
+        }
+        _mm512_storeu_ps(y + i, acc0);
+        _mm512_storeu_ps(y + i + 16, acc1);
+        _mm512_storeu_ps(y + i + 32, acc2);
+        _mm512_storeu_ps(y + i + 48, acc3);
+    }
+    for (; i < n; i += 16) {
+        __mmask16 mask = n - i >= 16 ? __mmask16(0xFFFF) : static_cast<__mmask16>((1u << (n - i)) - 1);
+        __m512 acc = _mm512_maskz_loadu_ps(mask, y + i);
+        for (size_t j = 0; j < count; ++j) {
+            acc = _mm512_fmadd_ps(_mm512_set1_ps(alpha[j]), _mm512_maskz_loadu_ps(mask, x + j * stride + i), acc);
+        }
+        _mm512_mask_storeu_ps(y + i, mask, acc);
+    }
+}
+
+__attribute__((target("avx512f")))
+float sparseDotAVX512(const float* x, const uint32_t* indices, const float* values, size_t n) {
+    __m512 acc = _mm512_setzero_ps();
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        __m512i index = _mm512_loadu_si512(indices + k);
+        acc = _mm512_fmadd_ps(_mm512_loadu_ps(values + k), _mm512_i32gather_ps(index, x, 4), acc);
+    }
+    return _mm512_reduce_add_ps(acc) + sparseDotScalar(x, indices + k, values + k, n - k);
+}
+
+__attribute__((target("avx512f")))
+void sparseAxpyAVX512(float alpha, const uint32_t* indices, const float* values, float* y, size_t n) {
+    __m512 a = _mm512_set1_ps(alpha);
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        __m512i index = _mm512_loadu_si512(indices + k);
+        __m512 v = _mm512_fmadd_ps(a, _mm512_loadu_ps(values + k), _mm512_i32gather_ps(index, y, 4));
+        _mm512_i32scatter_ps(y, index, v, 4);
+    }
+    sparseAxpyScalar(alpha, indices + k, values + k, y, n - k);
+}
+
+__attribute__((target("avx512f")))
+void addBiasAVX512(float* y, const float* bias, size_t n, bool relu) {
+    __m512 zero = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 v = _mm512_add_ps(_mm512_loadu_ps(y + i), _mm512_loadu_ps(bias + i));
+        _mm512_storeu_ps(y + i, relu ? _mm512_max_ps(v, zero) : v);
+    }
+    if (i < n) {
+        __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+        __m512 v = _mm512_add_ps(_mm512_maskz_loadu_ps(mask, y + i), _mm512_maskz_loadu_ps(mask, bias + i));
+        _mm512_mask_storeu_ps(y + i, mask, relu ? _mm512_max_ps(v, zero) : v);
+    }
+}
+
+__attribute__((target("avx512f")))
+void reluMaskAVX512(float* delta, const float* activations, size_t n) {
+    __m512 zero = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __mmask16 inactive = _mm512_cmp_ps_mask(_mm512_loadu_ps(activations + i), zero, _CMP_NGT_UQ);
+        _mm512_mask_storeu_ps(delta + i, inactive, zero);
+    }
+    if (i < n) {
+        __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+        __mmask16 inactive = _mm512_mask_cmp_ps_mask(mask, _mm512_maskz_loadu_ps(mask, activations + i), zero, _CMP_NGT_UQ);
+        _mm512_mask_storeu_ps(delta + i, inactive, zero);
+    }
+}
+
+__attribute__((target("avx512f")))
+void momentumAVX512(float* w, const float* g, float* v, size_t n, const Kernels::MomentumStep<float>& step) {
+    __m512 scale = _mm512_set1_ps(step.gradientScale);
+    __m512 decay = _mm512_set1_ps(step.l2Decay);
+    __m512 mu = _mm512_set1_ps(step.momentum);
+    __m512 rate = _mm512_set1_ps(step.learningRate);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 weights = _mm512_loadu_ps(w + i);
+        __m512 gradient = _mm512_fmadd_ps(scale, _mm512_loadu_ps(g + i), _mm512_mul_ps(decay, weights));
+        __m512 velocity = _mm512_fmadd_ps(mu, _mm512_loadu_ps(v + i), gradient);
+        _mm512_storeu_ps(v + i, velocity);
+        __m512 direction = step.nesterov ? _mm512_fmadd_ps(mu, velocity, gradient) : velocity;
+        _mm512_storeu_ps(w + i, _mm512_fnmadd_ps(rate, direction, weights));
+    }
+    momentumScalar(w + i, g + i, v + i, n - i, step);
+}
+
+__attribute__((target("avx512f")))
+void adamAVX512(float* w, const float* g, float* m, float* v, size_t n, const Kernels::AdamStep<float>& step) {
+    __m512 scale = _mm512_set1_ps(step.gradientScale);
+    __m512 decay = _mm512_set1_ps(step.l2Decay);
+    __m512 beta1 = _mm512_set1_ps(step.beta1);
+    __m512 beta2 = _mm512_set1_ps(step.beta2);
+    __m512 oneMinusBeta1 = _mm512_set1_ps(1 - step.beta1);
+    __m512 oneMinusBeta2 = _mm512_set1_ps(1 - step.beta2);
+    __m512 correction1 = _mm512_set1_ps(step.correction1);
+    __m512 correction2 = _mm512_set1_ps(step.correction2);
+    __m512 epsilon = _mm512_set1_ps(step.epsilon);
+    __m512 decoupled = _mm512_set1_ps(step.decoupledDecay);
+    __m512 rate = _mm512_set1_ps(step.learningRate);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 weights = _mm512_loadu_ps(w + i);
+        __m512 gradient = _mm512_fmadd_ps(scale, _mm512_loadu_ps(g + i), _mm512_mul_ps(decay, weights));
+        __m512 first = _mm512_fmadd_ps(beta1, _mm512_loadu_ps(m + i), _mm512_mul_ps(oneMinusBeta1, gradient));
+        __m512 second = _mm512_fmadd_ps(beta2, _mm512_loadu_ps(v + i),
+                                        _mm512_mul_ps(oneMinusBeta2, _mm512_mul_ps(gradient, gradient)));
+        _mm512_storeu_ps(m + i, first);
+        _mm512_storeu_ps(v + i, second);
+        __m512 denominator = _mm512_add_ps(_mm512_sqrt_ps(_mm512_mul_ps(second, correction2)), epsilon);
+        __m512 update = _mm512_fmadd_ps(decoupled, weights, _mm512_div_ps(_mm512_mul_ps(first, correction1), denominator));
+        _mm512_storeu_ps(w + i, _mm512_fnmadd_ps(rate, update, weights));
+    }
+    adamScalar(w + i, g + i, m + i, v + i, n - i, step);
+}
+
+// ---- AVX-512 VNNI int8 kernel (64 bytes per instruction, masked tail) ----
+
+// vpdpbusd multiplies unsigned by signed bytes and adds groups of four into 32-bit lanes without saturation
+__attribute__((target("avx512f,avx512bw,avx512vnni")))
+int32_t dotU8S8VNNI(const uint8_t* x, const int8_t* w, size_t n) {
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        acc = _mm512_dpbusd_epi32(acc, _mm512_loadu_si512(x + i), _mm512_loadu_si512(w + i));
+    }
+    if (i < n) {
+        __mmask64 mask = (1ull << (n - i)) - 1;
+        acc = _mm512_dpbusd_epi32(acc, _mm512_maskz_loadu_epi8(mask, x + i), _mm512_maskz_loadu_epi8(mask, w + i));
+    }
+    return _mm512_reduce_add_epi32(acc);
+}
+
+#endif // KERNELS_X86
+
+// Int8 dot product and its printable name
+struct Int8Kernel {
+    int32_t (*dot)(const uint8_t*, const int8_t*, size_t);
+    const char* name;
+};
+
+// Returns the int8 dot product for a level; VNNI is a separate CPU feature on top of AVX-512
+Int8Kernel int8KernelFor(Kernels::Level level) {
+#ifdef KERNELS_X86
+    if (level == Kernels::Level::AVX512 && __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512vnni")) {
+        return { dotU8S8VNNI, "AVX-512 VNNI" };
+    }
+    if (level != Kernels::Level::Scalar) {
+        return { dotU8S8AVX2, "AVX2" };
+    }
+#endif
+    (void)level;
+    return { dotU8S8Scalar, "Scalar" };
+}
+
+// Function pointers of one precision at one instruction set level
+template <typename T>
+struct KernelSet {
+    T (*dot)(const T*, const T*, size_t);
+    void (*axpy)(T, const T*, T*, size_t);
+    void (*multiAxpy)(const T*, const T*, size_t, size_t, T*, size_t);
+    T (*sparseDot)(const T*, const uint32_t*, const T*, size_t);
+    void (*sparseAxpy)(T, const uint32_t*, const T*, T*, size_t);
+    void (*addBias)(T*, const T*, size_t, bool);
+    void (*reluMask)(T*, const T*, size_t);
+    void (*momentum)(T*, const T*, T*, size_t, const Kernels::MomentumStep<T>&);
+    void (*adam)(T*, const T*, T*, T*, size_t, const Kernels::AdamStep<T>&);
+};
+
+// Returns the kernels of precision T for a level (overloads are resolved by the pointer types)
+template <typename T>
+KernelSet<T> kernelsFor(Kernels::Level level) {
+#ifdef KERNELS_X86
+    if (level == Kernels::Level::AVX512) {
+        return { dotAVX512, axpyAVX512, multiAxpyAVX512, sparseDotAVX512, sparseAxpyAVX512, addBiasAVX512, reluMaskAVX512,
+                 momentumAVX512, adamAVX512 };
+    }
+    if (level == Kernels::Level::AVX2) {
+        return { dotAVX2, axpyAVX2, multiAxpyAVX2, sparseDotAVX2, sparseAxpyScalar<T>, addBiasAVX2, reluMaskAVX2,
+                 momentumAVX2, adamAVX2 };
+    }
+#endif
+    (void)level;
+    return { dotScalar<T>, axpyScalar<T>, multiAxpyScalar<T>, sparseDotScalar<T>, sparseAxpyScalar<T>, addBiasScalar<T>,
+             reluMaskScalar<T>, momentumScalar<T>, adamScalar<T> };
+}
+
+// Checks every supported level against the scalar kernels of precision T on random data
+template <typename T>
+bool checkKernels(double tolerance) {
+    std::default_random_engine generator(42);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    KernelSet<T> reference = kernelsFor<T>(Kernels::Level::Scalar);
+    const char* precision = sizeof(T) == sizeof(float) ? "float" : "double";
+    bool passed = true;
+
+    // Relative comparison, scaled by the magnitude of the reference value
+    auto check = [&](const char* kernel, Kernels::Level level, size_t n, double expected, double actual) {
+        if (std::abs(expected - actual) > tolerance * std::max(1.0, std::abs(expected))) {
+            std::cerr << "Kernel mismatch: " << kernel << " (" << Kernels::getLevelName(level) << ", " << precision
+                      << ", n=" << n << "): expected " << expected << ", got " << actual << std::endl;
+            passed = false;
+        }
+    };
+
+    for (Kernels::Level level : { Kernels::Level::AVX2, Kernels::Level::AVX512 }) {
+        if (!Kernels::isSupported(level)) {
+            continue;
+        }
+        KernelSet<T> candidate = kernelsFor<T>(level);
+        // Cover every tail length of both lane widths as well as a typical MNIST row
+        for (size_t n : { 0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 47, 64, 784 }) {
+            std::vector<T> x(n), y(n);
+            for (size_t i = 0; i < n; ++i) {
+                x[i] = static_cast<T>(distribution(generator));
+                y[i] = static_cast<T>(distribution(generator));
+            }
+            check("dot", level, n, reference.dot(x.data(), y.data(), n), candidate.dot(x.data(), y.data(), n));
+
+            std::vector<T> expected = y, actual = y;
+            reference.axpy(T(0.37), x.data(), expected.data(), n);
+            candidate.axpy(T(0.37), x.data(), actual.data(), n);
+            for (size_t i = 0; i < n; ++i) {
+                check("axpy", level, n, expected[i], actual[i]);
+            }
+
+            // Three rows of x, n apart, fused into y
+            std::vector<T> rows(3 * n + 3);
+            for (T& value : rows) {
+                value = static_cast<T>(distribution(generator));
+            }
+            T alphas[3] = { T(0.37), T(-1.25), T(0.5) };
+            expected = y;
+            actual = y;
+            reference.multiAxpy(alphas, rows.data(), n + 1, 3, expected.data(), n);
+            candidate.multiAxpy(alphas, rows.data(), n + 1, 3, actual.data(), n);
+            for (size_t i = 0; i < n; ++i) {
+                check("multiAxpy", level, n, expected[i], actual[i]);
+            }
+
+            for (bool relu : { false, true }) {
+                expected = y;
+                actual = y;
+                reference.addBias(expected.data(), x.data(), n, relu);
+                candidate.addBias(actual.data(), x.data(), n, relu);
+                for (size_t i = 0; i < n; ++i) {
+                    check(relu ? "addBias+relu" : "addBias", level, n, expected[i], actual[i]);
+                }
+            }
+
+            // Sparse kernels over a random subset of the positions of x, in increasing order
+            std::vector<uint32_t> indices;
+            std::vector<T> values;
+            for (size_t i = 0; i < n; ++i) {
+                if (distribution(generator) > -0.4) {
+                    indices.push_back(static_cast<uint32_t>(i));
+                    values.push_back(static_cast<T>(distribution(generator)));
+                }
+            }
+            size_t nonzeros = indices.size();
+            check("sparseDot", level, nonzeros, reference.sparseDot(x.data(), indices.data(), values.data(), nonzeros),
+                  candidate.sparseDot(x.data(), indices.data(), values.data(), nonzeros));
+            expected = y;
+            actual = y;
+            reference.sparseAxpy(T(0.37), indices.data(), values.data(), expected.data(), nonzeros);
+            candidate.sparseAxpy(T(0.37), indices.data(), values.data(), actual.data(), nonzeros);
+            for (size_t i = 0; i < n; ++i) {
+                check("sparseAxpy", level, nonzeros, expected[i], actual[i]);
+            }
+
+            expected = y;
+            actual = y;
+            reference.reluMask(expected.data(), x.data(), n);
+            candidate.reluMask(actual.data(), x.data(), n);
+            for (size_t i = 0; i < n; ++i) {
+                check("reluMask", level, n, expected[i], actual[i]);
+            }
+
+            // Optimizer kernels: x is the gradient, y the weights; the second moment must be non-negative
+            std::vector<T> state1(n), state2(n);
+            for (size_t i = 0; i < n; ++i) {
+                state1[i] = static_cast<T>(distribution(generator));
+                state2[i] = static_cast<T>(std::abs(distribution(generator)));
+            }
+            for (bool nesterov : { false, true }) {
+                Kernels::MomentumStep<T> step = { T(0.25), T(0.1), T(0.9), T(0.01), nesterov };
+                std::vector<T> expectedWeights = y, actualWeights = y;
+                std::vector<T> expectedVelocity = state1, actualVelocity = state1;
+                reference.momentum(expectedWeights.data(), x.data(), expectedVelocity.data(), n, step);
+                candidate.momentum(actualWeights.data(), x.data(), actualVelocity.data(), n, step);
+                for (size_t i = 0; i < n; ++i) {
+                    check(nesterov ? "nesterov" : "momentum", level, n, expectedWeights[i], actualWeights[i]);
+                    check(nesterov ? "nesterov" : "momentum", level, n, expectedVelocity[i], actualVelocity[i]);
+                }
+            }
+            Kernels::AdamStep<T> step = { T(0.25), T(0.01), T(0.9), T(0.999), T(1e-6), T(1.5), T(20), T(0.01), T(0.02) };
+            std::vector<T> expectedWeights = y, actualWeights = y;
+            std::vector<T> expectedFirst = state1, actualFirst = state1;
+            std::vector<T> expectedSecond = state2, actualSecond = state2;
+            reference.adam(expectedWeights.data(), x.data(), expectedFirst.data(), expectedSecond.data(), n, step);
+            candidate.adam(actualWeights.data(), x.data(), actualFirst.data(), actualSecond.data(), n, step);
+            for (size_t i = 0; i < n; ++i) {
+                check("adam", level, n, expectedWeights[i], actualWeights[i]);
+                check("adam", level, n, expectedFirst[i], actualFirst[i]);
+                check("adam", level, n, expectedSecond[i], actualSecond[i]);
+            }
+        }
+    }
+    return passed;
+}
+
+// Checks the int8 dot product of every supported level against the scalar version (results must be identical)
+bool checkInt8Kernels() {
+    std::default_random_engine generator(7);
+    std::uniform_int_distribution<int> pixel(0, 255);
+    std::uniform_int_distribution<int> weight(-127, 127);
+    bool passed = true;
+    for (Kernels::Level level : { Kernels::Level::AVX2, Kernels::Level::AVX512 }) {
+        if (!Kernels::isSupported(level)) {
+            continue;
+        }
+        Int8Kernel candidate = int8KernelFor(level);
+        for (size_t n : { 0, 1, 3, 15, 16, 17, 31, 63, 64, 65, 127, 128, 129, 784 }) {
+            std::vector<uint8_t> x(n);
+            std::vector<int8_t> w(n);
+            for (size_t i = 0; i < n; ++i) {
+                x[i] = static_cast<uint8_t>(pixel(generator));
+                w[i] = static_cast<int8_t>(weight(generator));
+            }
+            int32_t expected = dotU8S8Scalar(x.data(), w.data(), n);
+            int32_t actual = candidate.dot(x.data(), w.data(), n);
+            if (expected != actual) {
+                std::cerr << "Kernel mismatch: dotU8S8 (" << candidate.name << ", n=" << n << "): expected "
+                          << expected << ", got " << actual << std::endl;
+                passed = false;
+            }
+        }
+    }
+    return passed;
+}
+
+} // namespace
+
+// Active function table, chosen once from CPUID at startup
+Kernels::Table Kernels::table = Kernels::tableFor(Kernels::detectLevel());
+
+// Returns the function table for a level
+Kernels::Table Kernels::tableFor(Level level) {
+#ifndef KERNELS_X86
+    level = Level::Scalar; // Only the scalar kernels are built
+#endif
+    KernelSet<Scalar> kernels = kernelsFor<Scalar>(level);
+    Int8Kernel int8 = int8KernelFor(level);
+    return { kernels.dot, kernels.axpy, kernels.multiAxpy, kernels.sparseDot, kernels.sparseAxpy, kernels.addBias, kernels.reluMask,
+             kernels.momentum, kernels.adam, int8.dot, int8.name, level };
+}
+
+// Returns true if the CPU (and this build) supports the given level
+bool Kernels::isSupported(Level level) {
+#ifdef KERNELS_X86
+    __builtin_cpu_init(); // Needed when called during static initialization
+#endif
+    switch (level) {
+        case Level::Scalar:
+            return true;
+#ifdef KERNELS_X86
+        case Level::AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case Level::AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return false;
+    }
+}
+
+// Returns the level best supported by this CPU
+Kernels::Level Kernels::detectLevel() {
+    if (isSupported(Level::AVX512)) {
+        return Level::AVX512;
+    }
+    if (isSupported(Level::AVX2)) {
+        return Level::AVX2;
+    }
+    return Level::Scalar;
+}
+
+// Returns the level currently in use
+Kernels::Level Kernels::getLevel() {
+    return table.level;
+}
+
+// Forces a level; throws if it is not supported
+void Kernels::setLevel(Level level) {
+    if (!isSupported(level)) {
+        throw std::invalid_argument(std::string("Kernel level not supported: ") + getLevelName(level));
+    }
+    table = tableFor(level);
+}
+
+// Returns a printable name for a level
+const char* Kernels::getLevelName(Level level) {
+    switch (level) {
+        case Level::AVX2:
+            return "AVX2";
+        case Level::AVX512:
+            return "AVX-512";
+        default:
+            return "Scalar";
+    }
+}
+
+// Returns a printable name of the int8 dot product in use
+const char* Kernels::getInt8KernelName() {
+    return table.int8KernelName;
+}
+
+// Checks every supported level against the scalar kernels, in both precisions and for int8
+bool Kernels::selfTest(double tolerance, double floatTolerance) {
+    bool doublePassed = checkKernels<double>(tolerance);
+    bool floatPassed = checkKernels<float>(floatTolerance);
+    bool int8Passed = checkInt8Kernels();
+    return doublePassed && floatPassed && int8Passed;
+}
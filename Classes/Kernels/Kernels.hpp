@@ -0,0 +1,137 @@
+//
+//  Kernels.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef Kernels_hpp
+#define Kernels_hpp
+
+#include "Scalar.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// Vector kernels used by the forward and backward passes.
+// Each kernel has a scalar version plus AVX2/FMA and AVX-512 versions on x86-64;
+// the best version supported by the CPU is selected once at startup (CPUID).
+// Kernels exist for float and double; the active table operates on Scalar.
+class Kernels {
+public:
+    // Instruction set levels, from slowest to fastest
+    enum class Level { Scalar, AVX2, AVX512 };
+
+    // Coefficients of a fused momentum (heavy-ball or Nesterov) update
+    template <typename T>
+    struct MomentumStep {
+        T gradientScale;    // Multiplies the raw gradient (1 / batch size)
+        T learningRate;     // Step size
+        T momentum;         // Velocity decay
+        T l2Decay;          // L2 penalty: g += l2Decay * w
+        bool nesterov;      // Look-ahead step g + momentum * v instead of v
+    };
+
+    // Coefficients of a fused Adam/AdamW update
+    template <typename T>
+    struct AdamStep {
+        T gradientScale;    // Multiplies the raw gradient (1 / batch size)
+        T learningRate;     // Step size
+        T beta1;            // Decay of the first moment
+        T beta2;            // Decay of the second moment
+        T epsilon;          // Added to the denominator
+        T correction1;      // Bias correction 1 / (1 - beta1^t)
+        T correction2;      // Bias correction 1 / (1 - beta2^t)
+        T l2Decay;          // L2 penalty added to the gradient (Adam)
+        T decoupledDecay;   // Weight decay applied directly to the weights (AdamW)
+    };
+
+    // Returns the dot product of x and y
+    static Scalar dot(const Scalar* x, const Scalar* y, size_t n) { return table.dot(x, y, n); }
+
+    // y += alpha * x
+    static void axpy(Scalar alpha, const Scalar* x, Scalar* y, size_t n) { table.axpy(alpha, x, y, n); }
+
+    // y += sum over j < count of alpha[j] * x[j * stride ...]: count axpys fused so y is read and written once
+    static void multiAxpy(const Scalar* alpha, const Scalar* x, size_t stride, size_t count, Scalar* y, size_t n) {
+        table.multiAxpy(alpha, x, stride, count, y, n);
+    }
+
+    // Sparse-dense dot product: sum of values[k] * x[indices[k]] over n nonzeros
+    static Scalar sparseDot(const Scalar* x, const uint32_t* indices, const Scalar* values, size_t n) {
+        return table.sparseDot(x, indices, values, n);
+    }
+
+    // Sparse axpy: y[indices[k]] += alpha * values[k] over n nonzeros (indices must be distinct)
+    static void sparseAxpy(Scalar alpha, const uint32_t* indices, const Scalar* values, Scalar* y, size_t n) {
+        table.sparseAxpy(alpha, indices, values, y, n);
+    }
+
+    // y += bias, followed by ReLU (y = max(0, y)) when relu is true
+    static void addBias(Scalar* y, const Scalar* bias, size_t n, bool relu) { table.addBias(y, bias, n, relu); }
+
+    // ReLU derivative mask: delta = 0 wherever activation <= 0
+    static void reluMask(Scalar* delta, const Scalar* activations, size_t n) { table.reluMask(delta, activations, n); }
+
+    // One pass of momentum SGD over n parameters w with raw gradients g and velocities v:
+    // g' = scale * g + l2 * w, v = momentum * v + g', w -= lr * (nesterov ? g' + momentum * v : v)
+    static void momentum(Scalar* w, const Scalar* g, Scalar* v, size_t n, const MomentumStep<Scalar>& step) {
+        table.momentum(w, g, v, n, step);
+    }
+
+    // One pass of Adam over n parameters w with raw gradients g and moments m, v:
+    // g' = scale * g + l2 * w, m = b1 * m + (1 - b1) * g', v = b2 * v + (1 - b2) * g'^2,
+    // w -= lr * (m * c1 / (sqrt(v * c2) + eps) + decoupledDecay * w)
+    static void adam(Scalar* w, const Scalar* g, Scalar* m, Scalar* v, size_t n, const AdamStep<Scalar>& step) {
+        table.adam(w, g, m, v, n, step);
+    }
+
+    // Integer dot product of unsigned 8-bit x and signed 8-bit w with exact 32-bit accumulation
+    static int32_t dotU8S8(const uint8_t* x, const int8_t* w, size_t n) { return table.dotU8S8(x, w, n); }
+
+    // Returns the level best supported by this CPU
+    static Level detectLevel();
+
+    // Returns true if the CPU (and this build) supports the given level
+    static bool isSupported(Level level);
+
+    // Returns the level currently in use
+    static Level getLevel();
+
+    // Forces a level (e.g. for comparisons); throws std::invalid_argument if it is not supported
+    static void setLevel(Level level);
+
+    // Returns a printable name for a level
+    static const char* getLevelName(Level level);
+
+    // Returns a printable name of the int8 dot product in use (AVX-512 uses VNNI when the CPU has it)
+    static const char* getInt8KernelName();
+
+    // Checks every supported level against the scalar kernels on random data, for both precisions
+    // (the int8 dot product must match exactly).
+    // Returns false (and prints the mismatch) if any result differs by more than the relative tolerance
+    static bool selfTest(double tolerance = 1e-9, double floatTolerance = 1e-4);
+
+private:
+    // Function table for one instruction set level
+    struct Table {
+        Scalar (*dot)(const Scalar*, const Scalar*, size_t);
+        void (*axpy)(Scalar, const Scalar*, Scalar*, size_t);
+        void (*multiAxpy)(const Scalar*, const Scalar*, size_t, size_t, Scalar*, size_t);
+        Scalar (*sparseDot)(const Scalar*, const uint32_t*, const Scalar*, size_t);
+        void (*sparseAxpy)(Scalar, const uint32_t*, const Scalar*, Scalar*, size_t);
+        void (*addBias)(Scalar*, const Scalar*, size_t, bool);
+        void (*reluMask)(Scalar*, const Scalar*, size_t);
+        void (*momentum)(Scalar*, const Scalar*, Scalar*, size_t, const MomentumStep<Scalar>&);
+        void (*adam)(Scalar*, const Scalar*, Scalar*, Scalar*, size_t, const AdamStep<Scalar>&);
+        int32_t (*dotU8S8)(const uint8_t*, const int8_t*, size_t);
+        const char* int8KernelName;
+        Level level;
+    };
+
+    // Returns the function table for a level
+    static Table tableFor(Level level);
+
+    static Table table; // Active function table
+};
+
+#endif /* Kernels_hpp */
@@ -0,0 +1,69 @@
+//
+//  LatencyStats.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "LatencyStats.hpp"
+#include <algorithm>
+
+namespace {
+
+// Computes the summary of a set of latencies (reorders them)
+LatencyStats::Summary summarizeSamples(std::vector<double>& samples) {
+    LatencyStats::Summary summary;
+    summary.count = samples.size();
+    if (samples.empty()) {
+        return summary;
+    }
+    // Nearest-rank percentile
+    auto percentile = [&](double fraction) {
+        size_t rank = std::min(samples.size() - 1, static_cast<size_t>(fraction * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+        return samples[rank];
+    };
+    summary.p50 = percentile(0.50);
+    summary.p99 = percentile(0.99);
+    double total = 0.0;
+    for (double sample : samples) {
+        total += sample;
+        summary.max = std::max(summary.max, sample);
+    }
+    summary.mean = total / samples.size();
+    return summary;
+}
+
+} // namespace
+
+// Records one latency in microseconds
+void LatencyStats::record(double microseconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    samples.push_back(microseconds);
+}
+
+// Records several latencies at once
+void LatencyStats::record(const std::vector<double>& microseconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    samples.insert(samples.end(), microseconds.begin(), microseconds.end());
+}
+
+// Returns the summary of everything recorded since the last reset
+LatencyStats::Summary LatencyStats::summarize() const {
+    std::vector<double> copy;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        copy = samples;
+    }
+    return summarizeSamples(copy);
+}
+
+// Returns the summary and starts a new measurement window
+LatencyStats::Summary LatencyStats::summarizeAndReset() {
+    std::vector<double> taken;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        taken.swap(samples);
+    }
+    return summarizeSamples(taken);
+}
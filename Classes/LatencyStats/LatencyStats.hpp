@@ -0,0 +1,44 @@
+//
+//  LatencyStats.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef LatencyStats_hpp
+#define LatencyStats_hpp
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Thread-safe collection of request latencies with percentile summaries
+class LatencyStats {
+private:
+    mutable std::mutex mutex;           // Guards samples
+    std::vector<double> samples;        // Recorded latencies in microseconds
+
+public:
+    // Percentiles of the recorded latencies (all in microseconds)
+    struct Summary {
+        size_t count = 0;   // Number of recorded requests
+        double mean = 0.0;  // Average latency
+        double p50 = 0.0;   // Median latency
+        double p99 = 0.0;   // 99th percentile latency
+        double max = 0.0;   // Largest latency
+    };
+
+    // Records one latency in microseconds
+    void record(double microseconds);
+
+    // Records several latencies at once (one lock for a whole batch)
+    void record(const std::vector<double>& microseconds);
+
+    // Returns the summary of everything recorded since the last reset
+    Summary summarize() const;
+
+    // Returns the summary and starts a new measurement window
+    Summary summarizeAndReset();
+};
+
+#endif /* LatencyStats_hpp */
@@ -6,75 +6,109 @@
 //
 
 #include "Layer.hpp"
+#include "Optimizer.hpp"
+#include <algorithm>
 
-// Constructor: Initializes a layer with a specified number of neurons, each taking inputSize inputs
-Layer::Layer(int numNeurons, int inputSize, bool useReLU) : numNeurons(numNeurons), inputSize(inputSize), layerUseReLU(useReLU) {
-    // Create numNeurons neurons, each initialized with a weight vector of size inputSize and useReLU flag
-    for (int i = 0; i < numNeurons; ++i) {
-        neurons.emplace_back(inputSize, useReLU);
-    }
+// Static member initialization for random weight initialization
+std::default_random_engine Layer::generator;
+std::uniform_real_distribution<double> Layer::distribution(-1.0, 1.0);
+
+// Number of values per sample
+size_t Layer::Shape::size() const {
+    return static_cast<size_t>(height) * width * channels;
 }
 
-// Adds a new neuron to the layer
-void Layer::addNeuron() {
-    // Append a new neuron with a weight vector of size inputSize and the layer's useReLU setting
-    neurons.emplace_back(inputSize, layerUseReLU);
-    // Increment the count of neurons in the layer
-    numNeurons++;
+// Printable form, e.g. "28x28x1"
+std::string Layer::Shape::toString() const {
+    return std::to_string(height) + "x" + std::to_string(width) + "x" + std::to_string(channels);
 }
 
-// Forward pass: Computes the output of each neuron in the layer given the inputs
-std::vector<double> Layer::forward(const std::vector<double>& inputs) {
-    // Validate that the input size matches the expected input size for the layer
-    if (inputs.size() != inputSize) {
-        throw std::invalid_argument("Input size does not match layer's input size");
-    }
-    // Store the outputs of all neurons in the layer
-    std::vector<double> outputs;
-    // Compute the forward pass for each neuron and collect its output
-    for (auto& neuron : neurons) {
-        outputs.push_back(neuron.forward(inputs));
-    }
-    // Return the vector of neuron outputs
-    return outputs;
+// Constructor: No parameters yet
+Layer::Layer() {}
+
+// Constructor: Uses external parameters in place
+Layer::Layer(std::span<Scalar> weights, std::span<Scalar> biases, std::shared_ptr<void> storage)
+    : storage(std::move(storage)), weights(weights), biases(biases) {}
+
+// Copy constructor: Copies the parameters into owned storage
+Layer::Layer(const Layer& other)
+    : ownedWeights(other.weights.begin(), other.weights.end()), ownedBiases(other.biases.begin(), other.biases.end()) {
+    bindOwned();
 }
 
-// Computes gradients for all neurons in the layer during backpropagation
-void Layer::computeGradients(const std::vector<double>& nextLayerGradients,
-                             const std::vector<std::vector<double>>& nextLayerWeights,
-                             bool isOutputLayer, int target) {
-    if (isOutputLayer) {
-        for (int i = 0; i < numNeurons; ++i) {
-            // dL/da_i is provided by nextLayerGradients (p_i - y_i)
-            double dL_da = nextLayerGradients[i];
-            // da_i/dz_i = 1 since output layer is linear (no ReLU)
-            double da_dz = 1.0;
-            // dL/dz_i = dL/da_i * da_i/dz_i
-            neurons[i].setGradient(dL_da * da_dz);
-        }
-    } else {
-        // Hidden layer computation
-        for (int i = 0; i < numNeurons; ++i) {
-            double gradSum = 0.0;
-            for (int j = 0; j < nextLayerGradients.size(); ++j) {
-                gradSum += nextLayerWeights[j][i] * nextLayerGradients[j];
-            }
-            // da_i/dz_i = 1 if ReLU input z_i > 0, else 0; since a_i = ReLU(z_i), check a_i > 0
-            neurons[i].setGradient(gradSum * (neurons[i].getOutput() > 0 ? 1.0 : 0.0));
-        }
+// Points weights and biases at the owned storage
+void Layer::bindOwned() {
+    weights = ownedWeights;
+    biases = ownedBiases;
+}
+
+// Copies external parameters into owned storage so the layer can grow
+void Layer::makeOwned() {
+    if (storage) {
+        ownedWeights.assign(weights.begin(), weights.end());
+        ownedBiases.assign(biases.begin(), biases.end());
+        storage.reset();
     }
 }
 
-// Updates weights and biases of all neurons in the layer using gradient descent
-void Layer::updateWeights(double learningRate) {
-    // Iterate through each neuron in the layer
-    for (auto& neuron : neurons) {
-        // Update the neuron's weights and bias based on its gradient and learning rate
-        neuron.updateWeights(learningRate);
+// Getter: Layers are linear unless they say otherwise
+bool Layer::usesReLU() const {
+    return false;
+}
+
+// Getter: Layers need no scratch space unless they say otherwise
+size_t Layer::getScratchSize(size_t) const {
+    return 0;
+}
+
+// Applies accumulated gradients to the weights and biases with the optimizer's update rule
+void Layer::applyGradients(std::span<const Scalar> weightGradients, std::span<const Scalar> biasGradients,
+                           size_t batchSize, Optimizer& optimizer, size_t layerIndex) {
+    optimizer.update(layerIndex, weights, biases, weightGradients, biasGradients, batchSize);
+}
+
+// Overwrites the weights and biases with those of a layer of the same type and shape
+void Layer::copyParameters(const Layer& other) {
+    if (other.getType() != getType() || other.getInputShape() != getInputShape() ||
+        other.getOutputShape() != getOutputShape() || other.weights.size() != weights.size() ||
+        other.biases.size() != biases.size()) {
+        throw std::invalid_argument("Layer shapes do not match");
     }
+    std::copy(other.weights.begin(), other.weights.end(), weights.begin());
+    std::copy(other.biases.begin(), other.biases.end(), biases.begin());
+}
+
+// Getter: Returns the weight block
+std::span<const Scalar> Layer::getWeights() const {
+    return weights;
+}
+
+// Getter: Returns the bias vector
+std::span<const Scalar> Layer::getBiases() const {
+    return biases;
 }
 
-// Getter: Returns a const reference to the vector of neurons in the layer
-const std::vector<Neuron>& Layer::getNeurons() const {
-    return neurons;
+// Getter: Returns the number of input values per sample
+size_t Layer::getNumInputs() const {
+    return getInputShape().size();
+}
+
+// Getter: Returns the number of output values per sample
+size_t Layer::getNumOutputs() const {
+    return getOutputShape().size();
+}
+
+// Returns a printable name for a type
+const char* Layer::getTypeName(Type type) {
+    switch (type) {
+        case Type::Dense:
+            return "Dense";
+        case Type::Conv2D:
+            return "Conv2D";
+        case Type::MaxPool:
+            return "MaxPool";
+        case Type::Flatten:
+            return "Flatten";
+    }
+    return "Unknown";
 }
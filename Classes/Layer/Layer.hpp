@@ -8,38 +8,123 @@
 #ifndef Layer_hpp
 #define Layer_hpp
 
-#include "Neuron.hpp"
+#include "Scalar.hpp"
+#include <cstdint>
+#include <memory>
 #include <vector>
+#include <span>
+#include <random>
 #include <stdexcept>
+#include <string>
 
-// Class representing a layer of neurons in a neural network
+class Optimizer;
+
+// Interface of the layers a Network stacks (dense, conv2d, max-pool, flatten).
+// A layer maps a batch of inputs to a batch of outputs, each sample stored as one row. Images are stored
+// channels-last (row by row, the channels of a pixel next to each other), so a flattened image is just its row.
+// Trainable layers keep their parameters as one weight block plus a bias vector, either owned or living
+// in external memory such as a mapped model file. Layers are const during batched passes: everything a pass
+// writes lives in buffers the caller provides (see Workspace), so several threads can share a layer.
 class Layer {
-private:
-    std::vector<Neuron> neurons;    // Collection of neurons in the layer
-    int numNeurons;                 // Number of neurons in the layer
-    int inputSize;                  // Number of inputs each neuron expects (size of previous layer)
-    bool layerUseReLU;              // Flag to determine if neurons in this layer use ReLU
+public:
+    // Kind of layer, as stored in model files
+    enum class Type : uint32_t {
+        Dense = 1,      // Fully connected layer
+        Conv2D = 2,     // 2D convolution
+        MaxPool = 3,    // Non-overlapping max pooling
+        Flatten = 4     // Reinterprets an image as a vector
+    };
+
+    // Size of the input or output of one sample: height x width x channels (1 x 1 x n for vectors)
+    struct Shape {
+        int height = 1;
+        int width = 1;
+        int channels = 1;
+
+        // Number of values per sample
+        size_t size() const;
+
+        // Printable form, e.g. "28x28x1"
+        std::string toString() const;
+
+        bool operator==(const Shape& other) const = default;
+    };
+
+protected:
+    std::vector<Scalar> ownedWeights;   // Weight storage when the layer owns its parameters
+    std::vector<Scalar> ownedBiases;    // Bias storage when the layer owns its parameters
+    std::shared_ptr<void> storage;      // Keeps external parameter memory alive (empty when owned)
+    std::span<Scalar> weights;          // Weight block (layout defined by the layer type)
+    std::span<Scalar> biases;           // Bias of each output unit or filter
+
+    // Random number generator for weight initialization
+    static std::default_random_engine generator;
+    static std::uniform_real_distribution<double> distribution; // Drawn in double so both precisions start from the same weights
+
+    // Constructor: No parameters yet; owned parameters are added by the derived class
+    Layer();
+
+    // Constructor: Uses parameters held elsewhere in place; storage keeps that memory alive
+    Layer(std::span<Scalar> weights, std::span<Scalar> biases, std::shared_ptr<void> storage);
+
+    // Copies always own their parameters, so they never write to another layer's memory
+    Layer(const Layer& other);
+
+    // Points weights and biases at the owned storage
+    void bindOwned();
+
+    // Copies external parameters into owned storage so the layer can grow
+    void makeOwned();
 
 public:
-    // Constructor: Initializes a layer with a specified number of neurons, input size, and ReLU flag
-    Layer(int numNeurons, int inputSize, bool useReLU = true);
+    virtual ~Layer() = default;
+    Layer& operator=(const Layer&) = delete;
+
+    // Returns a copy that owns its parameters
+    virtual std::unique_ptr<Layer> clone() const = 0;
+
+    // Getters describing the layer
+    virtual Type getType() const = 0;
+    virtual Shape getInputShape() const = 0;
+    virtual Shape getOutputShape() const = 0;
+    virtual bool usesReLU() const;
+
+    // One-line description of the layer, e.g. "Dense 784 -> 128, ReLU"
+    virtual std::string describe() const = 0;
+
+    // Number of scratch values the batched passes need for batchSize samples (0 for most layers)
+    virtual size_t getScratchSize(size_t batchSize) const;
+
+    // Batched forward pass: inputs holds batchSize samples of getNumInputs() values, outputs receives
+    // batchSize x getNumOutputs() values. scratch must hold getScratchSize(batchSize) values
+    virtual void forwardBatch(std::span<const Scalar> inputs, std::span<Scalar> outputs, size_t batchSize,
+                              std::span<Scalar> scratch) const = 0;
 
-    // Adds a new neuron to the layer
-    void addNeuron();
+    // Batched backward pass over the inputs and outputs of a forward pass. On entry deltas holds dL/da for
+    // every output; it is turned into dL/dz in place. Weight and bias gradients are accumulated (not
+    // overwritten), and inputDeltas (batchSize x getNumInputs()) receives dL/d(inputs) unless it is empty
+    virtual void backwardBatch(std::span<const Scalar> inputs, std::span<const Scalar> outputs,
+                               std::span<Scalar> deltas, std::span<Scalar> inputDeltas,
+                               std::span<Scalar> weightGradients, std::span<Scalar> biasGradients, size_t batchSize,
+                               std::span<Scalar> scratch) const = 0;
 
-    // Forward pass: Computes outputs for all neurons given the input vector
-    std::vector<double> forward(const std::vector<double>& inputs);
+    // Applies gradients summed over batchSize samples with the optimizer's update rule,
+    // using the optimizer state kept for layer number layerIndex
+    void applyGradients(std::span<const Scalar> weightGradients, std::span<const Scalar> biasGradients,
+                        size_t batchSize, Optimizer& optimizer, size_t layerIndex);
 
-    // Computes gradients for neurons, handling output and hidden layers differently
-    void computeGradients(const std::vector<double>& nextLayerGradients,
-                          const std::vector<std::vector<double>>& nextLayerWeights,
-                          bool isOutputLayer, int target);
+    // Overwrites the weights and biases with those of a layer of the same type and shape, without
+    // reallocating. Throws std::invalid_argument if they differ
+    void copyParameters(const Layer& other);
 
-    // Updates weights and biases of all neurons using gradient descent
-    void updateWeights(double learningRate);
+    // Getters for the parameters (empty for layers without any) and the per-sample sizes
+    std::span<const Scalar> getWeights() const;
+    std::span<const Scalar> getBiases() const;
+    size_t getNumInputs() const;
+    size_t getNumOutputs() const;
 
-    // Getter: Returns a const reference to the vector of neurons
-    const std::vector<Neuron>& getNeurons() const;
+    // Returns a printable name for a type
+    static const char* getTypeName(Type type);
 };
 
 #endif /* Layer_hpp */
@@ -0,0 +1,102 @@
+//
+//  LoadGenerator.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "LoadGenerator.hpp"
+#include "InferenceServer.hpp"
+#include "UnixSocket.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Runs the closed-loop clients and reports what they observed
+LoadGenerator::Report LoadGenerator::run(const std::string& socketPath, const Dataset& data, unsigned connections,
+                                         size_t requestsPerConnection) {
+    if (connections == 0 || data.getNumSamples() == 0) {
+        throw std::invalid_argument("Load generator needs at least one connection and one sample");
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    LatencyStats latency;
+    std::atomic<size_t> correct(0);
+    std::atomic<size_t> answered(0);
+    std::vector<std::exception_ptr> errors(connections);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> clients;
+    for (unsigned c = 0; c < connections; ++c) {
+        clients.emplace_back([&, c] {
+            try {
+                UnixSocket socket = UnixSocket::connect(socketPath);
+                InferenceServer::Hello hello;
+                if (!socket.readFully(&hello, sizeof(hello)) || std::memcmp(hello.magic, "NNIS", 4) != 0 ||
+                    hello.version != InferenceServer::PROTOCOL_VERSION) {
+                    throw std::runtime_error("Unexpected greeting from " + socketPath);
+                }
+                if (hello.inputSize != data.getSampleSize()) {
+                    throw std::runtime_error("Server expects " + std::to_string(hello.inputSize) + " pixels per request");
+                }
+                std::vector<float> probabilities(hello.outputSize);
+                std::vector<double> latencies;
+                latencies.reserve(requestsPerConnection);
+                for (size_t r = 0; r < requestsPerConnection; ++r) {
+                    // Connections walk the dataset interleaved so they send different samples
+                    size_t index = (r * connections + c) % data.getNumSamples();
+                    uint32_t id = static_cast<uint32_t>(r);
+                    std::span<const uint8_t> pixels = data.getPixels(index);
+                    auto sent = std::chrono::steady_clock::now();
+                    uint32_t answerId = 0;
+                    if (!socket.writeFully(&id, sizeof(id)) || !socket.writeFully(pixels.data(), pixels.size()) ||
+                        !socket.readFully(&answerId, sizeof(answerId)) ||
+                        !socket.readFully(probabilities.data(), probabilities.size() * sizeof(float))) {
+                        throw std::runtime_error("Server closed the connection");
+                    }
+                    latencies.push_back(
+                        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - sent).count());
+                    if (answerId != id) {
+                        throw std::runtime_error("Response id does not match request id");
+                    }
+                    auto best = std::max_element(probabilities.begin(), probabilities.end());
+                    if (best - probabilities.begin() == data.getLabel(index)) {
+                        correct++;
+                    }
+                    answered++;
+                }
+                latency.record(latencies);
+            } catch (...) {
+                errors[c] = std::current_exception();
+            }
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    Report report;
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report.requests = answered;
+    report.correct = correct;
+    report.requestsPerSecond = report.seconds > 0.0 ? report.requests / report.seconds : 0.0;
+    report.latency = latency.summarize();
+    std::cout << report.requests << " requests over " << connections << " connections in " << report.seconds
+              << " s: " << report.requestsPerSecond << " req/s" << std::endl;
+    std::cout << "  Round trip: mean " << report.latency.mean << " us, p50 " << report.latency.p50 << " us, p99 "
+              << report.latency.p99 << " us, max " << report.latency.max << " us" << std::endl;
+    std::cout << "  Accuracy of answers: " << static_cast<double>(report.correct) / std::max<size_t>(1, report.requests)
+              << std::endl;
+    return report;
+}
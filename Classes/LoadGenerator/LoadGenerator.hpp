@@ -0,0 +1,34 @@
+//
+//  LoadGenerator.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef LoadGenerator_hpp
+#define LoadGenerator_hpp
+
+#include "Dataset.hpp"
+#include "LatencyStats.hpp"
+#include <string>
+
+// Local load generator for the InferenceServer: several concurrent closed-loop clients, each sending one
+// request at a time with samples from a Dataset and waiting for the answer
+class LoadGenerator {
+public:
+    // Results seen by the clients
+    struct Report {
+        size_t requests = 0;                // Requests answered
+        size_t correct = 0;                 // Answers whose most probable class matches the label
+        double seconds = 0.0;               // Wall-clock time of the run
+        double requestsPerSecond = 0.0;     // Throughput over all connections
+        LatencyStats::Summary latency;      // Round-trip latency in microseconds
+    };
+
+    // Opens `connections` connections to socketPath and sends requestsPerConnection requests on each.
+    // Prints and returns the report; throws std::runtime_error if the server cannot be reached or misbehaves
+    static Report run(const std::string& socketPath, const Dataset& data, unsigned connections,
+                      size_t requestsPerConnection);
+};
+
+#endif /* LoadGenerator_hpp */
@@ -0,0 +1,65 @@
+//
+//  MappedFile.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "MappedFile.hpp"
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Constructor: Maps the whole file, read-only or copy-on-write
+MappedFile::MappedFile(const std::string& filename, Mode mode) : address(nullptr), length(0), mode(mode) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Could not stat file: " + filename);
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (length > 0) {
+        // A private mapping shares clean pages with the page cache until they are written
+        int protection = mode == Mode::CopyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ;
+        int flags = mode == Mode::CopyOnWrite ? MAP_PRIVATE : MAP_SHARED;
+        address = ::mmap(nullptr, length, protection, flags, fd, 0);
+        if (address == MAP_FAILED) {
+            address = nullptr;
+            ::close(fd);
+            throw std::runtime_error("Could not map file: " + filename);
+        }
+    }
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+// Destructor: Unmaps the file
+MappedFile::~MappedFile() {
+    if (address) {
+        ::munmap(address, length);
+    }
+}
+
+// Getter: Returns the first byte of the mapping
+const uint8_t* MappedFile::data() const {
+    return static_cast<const uint8_t*>(address);
+}
+
+// Returns a writable pointer to a copy-on-write mapping
+uint8_t* MappedFile::writableData() {
+    if (mode != Mode::CopyOnWrite) {
+        throw std::logic_error("Mapping is read-only");
+    }
+    return static_cast<uint8_t*>(address);
+}
+
+// Getter: Returns the mapping length in bytes
+size_t MappedFile::size() const {
+    return length;
+}
@@ -0,0 +1,48 @@
+//
+//  MappedFile.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef MappedFile_hpp
+#define MappedFile_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Memory mapping of a whole file (POSIX mmap).
+// Pages are shared with the page cache, so several processes mapping the same file share memory
+class MappedFile {
+public:
+    // How the mapping may be used
+    enum class Mode {
+        ReadOnly,       // Read-only view of the file
+        CopyOnWrite     // Writable private view: written pages are copied, the file never changes
+    };
+
+private:
+    void* address;      // Start of the mapping (nullptr for an empty file)
+    size_t length;      // Length of the mapping in bytes
+    Mode mode;          // Access mode of the mapping
+
+public:
+    // Constructor: Maps the file; throws std::runtime_error if it cannot be opened or mapped
+    explicit MappedFile(const std::string& filename, Mode mode = Mode::ReadOnly);
+
+    // Destructor: Unmaps the file
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Getters
+    const uint8_t* data() const;
+    size_t size() const;
+
+    // Returns a writable pointer to the mapping; throws std::logic_error for read-only mappings
+    uint8_t* writableData();
+};
+
+#endif /* MappedFile_hpp */
@@ -0,0 +1,117 @@
+//
+//  MaxPoolLayer.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "MaxPoolLayer.hpp"
+#include <algorithm>
+
+// Constructor: Pools inputShape images over poolSize x poolSize windows
+MaxPoolLayer::MaxPoolLayer(const Shape& inputShape, int poolSize) : inputShape(inputShape), poolSize(poolSize) {
+    if (inputShape.height <= 0 || inputShape.width <= 0 || inputShape.channels <= 0 || poolSize <= 0) {
+        throw std::invalid_argument("Pooling dimensions must be positive");
+    }
+    if (poolSize > inputShape.height || poolSize > inputShape.width) {
+        throw std::invalid_argument("Pooling window is larger than the input");
+    }
+    outputShape = { inputShape.height / poolSize, inputShape.width / poolSize, inputShape.channels };
+}
+
+// Returns a copy of the layer
+std::unique_ptr<Layer> MaxPoolLayer::clone() const {
+    return std::make_unique<MaxPoolLayer>(*this);
+}
+
+// Getter: Returns the layer type
+Layer::Type MaxPoolLayer::getType() const {
+    return Type::MaxPool;
+}
+
+// Getter: Returns the input image shape
+Layer::Shape MaxPoolLayer::getInputShape() const {
+    return inputShape;
+}
+
+// Getter: Returns the pooled image shape
+Layer::Shape MaxPoolLayer::getOutputShape() const {
+    return outputShape;
+}
+
+// One-line description of the layer
+std::string MaxPoolLayer::describe() const {
+    return "MaxPool " + inputShape.toString() + " -> " + outputShape.toString() + ", " + std::to_string(poolSize) +
+           "x" + std::to_string(poolSize);
+}
+
+// Batched forward pass: each output pixel starts from the window's first pixel and takes the
+// channel-wise maximum of the others, so the channels of a pixel are processed together
+void MaxPoolLayer::forwardBatch(std::span<const Scalar> inputs, std::span<Scalar> outputs, size_t batchSize,
+                                std::span<Scalar>) const {
+    if (inputs.size() < batchSize * inputShape.size() || outputs.size() < batchSize * outputShape.size()) {
+        throw std::invalid_argument("Batch buffers are too small for layer");
+    }
+    size_t channels = inputShape.channels;
+    Scalar* out = outputs.data();
+    for (size_t b = 0; b < batchSize; ++b) {
+        const Scalar* image = inputs.data() + b * inputShape.size();
+        for (int oy = 0; oy < outputShape.height; ++oy) {
+            for (int ox = 0; ox < outputShape.width; ++ox, out += channels) {
+                const Scalar* corner = image + (static_cast<size_t>(oy) * poolSize * inputShape.width + ox * poolSize) * channels;
+                std::copy_n(corner, channels, out);
+                for (int ky = 0; ky < poolSize; ++ky) {
+                    const Scalar* pixel = corner + static_cast<size_t>(ky) * inputShape.width * channels;
+                    for (int kx = 0; kx < poolSize; ++kx, pixel += channels) {
+                        for (size_t c = 0; c < channels; ++c) {
+                            out[c] = std::max(out[c], pixel[c]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Batched backward pass: the argmax of every window is found again from the inputs and outputs,
+// so no indices need to be kept between the passes
+void MaxPoolLayer::backwardBatch(std::span<const Scalar> inputs, std::span<const Scalar> outputs,
+                                 std::span<Scalar> deltas, std::span<Scalar> inputDeltas, std::span<Scalar>,
+                                 std::span<Scalar>, size_t batchSize, std::span<Scalar>) const {
+    if (inputDeltas.empty()) {
+        return; // No parameters, so there is nothing else to compute
+    }
+    if (inputDeltas.size() < batchSize * inputShape.size()) {
+        throw std::invalid_argument("Batch buffers are too small for layer");
+    }
+    std::fill_n(inputDeltas.begin(), batchSize * inputShape.size(), Scalar(0));
+    size_t channels = inputShape.channels;
+    size_t index = 0;
+    for (size_t b = 0; b < batchSize; ++b) {
+        size_t imageOffset = b * inputShape.size();
+        for (int oy = 0; oy < outputShape.height; ++oy) {
+            for (int ox = 0; ox < outputShape.width; ++ox) {
+                size_t corner = imageOffset + (static_cast<size_t>(oy) * poolSize * inputShape.width + ox * poolSize) * channels;
+                for (size_t c = 0; c < channels; ++c, ++index) {
+                    Scalar maximum = outputs[index];
+                    bool found = false;
+                    for (int ky = 0; ky < poolSize && !found; ++ky) {
+                        size_t pixel = corner + static_cast<size_t>(ky) * inputShape.width * channels + c;
+                        for (int kx = 0; kx < poolSize; ++kx, pixel += channels) {
+                            if (inputs[pixel] == maximum) {
+                                inputDeltas[pixel] += deltas[index];
+                                found = true;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Getter: Returns the window size
+int MaxPoolLayer::getPoolSize() const {
+    return poolSize;
+}
@@ -0,0 +1,47 @@
+//
+//  MaxPoolLayer.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef MaxPoolLayer_hpp
+#define MaxPoolLayer_hpp
+
+#include "Layer.hpp"
+
+// Non-overlapping max pooling over channels-last images: every poolSize x poolSize window of each channel
+// is reduced to its largest value. Rows and columns that do not fill a whole window are dropped.
+// The layer has no parameters; the backward pass routes each delta to the input that held the maximum.
+class MaxPoolLayer : public Layer {
+private:
+    Shape inputShape;   // Input image: height x width x channels
+    Shape outputShape;  // Pooled image: same channels
+    int poolSize;       // Side of the square window (also its stride)
+
+public:
+    // Constructor: Pools inputShape images over poolSize x poolSize windows.
+    // Throws std::invalid_argument if the window is larger than the image
+    MaxPoolLayer(const Shape& inputShape, int poolSize);
+
+    // Layer interface
+    std::unique_ptr<Layer> clone() const override;
+    Type getType() const override;
+    Shape getInputShape() const override;
+    Shape getOutputShape() const override;
+    std::string describe() const override;
+
+    // Batched forward pass: the maximum of every window
+    void forwardBatch(std::span<const Scalar> inputs, std::span<Scalar> outputs, size_t batchSize,
+                      std::span<Scalar> scratch) const override;
+
+    // Batched backward pass: each window's delta goes to its first input equal to the window's maximum
+    void backwardBatch(std::span<const Scalar> inputs, std::span<const Scalar> outputs, std::span<Scalar> deltas,
+                       std::span<Scalar> inputDeltas, std::span<Scalar> weightGradients,
+                       std::span<Scalar> biasGradients, size_t batchSize, std::span<Scalar> scratch) const override;
+
+    // Getter: Returns the window size
+    int getPoolSize() const;
+};
+
+#endif /* MaxPoolLayer_hpp */
@@ -6,150 +6,885 @@
 //
 
 #include "Network.hpp"
+#include "Conv2DLayer.hpp"
+#include "DatasetSource.hpp"
+#include "FlattenLayer.hpp"
+#include "Kernels.hpp"
+#include "MappedFile.hpp"
+#include "MaxPoolLayer.hpp"
+#include "ThreadPool.hpp"
+#include "Tracer.hpp"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
 
+namespace {
+
+// Alignment of every parameter block inside a model file
+constexpr uint64_t PARAMETER_ALIGNMENT = 64;
+
+// Rounds offset up to the next multiple of PARAMETER_ALIGNMENT
+uint64_t alignOffset(uint64_t offset) {
+    return (offset + PARAMETER_ALIGNMENT - 1) / PARAMETER_ALIGNMENT * PARAMETER_ALIGNMENT;
+}
+
+// Converts count parameters of type T (as written by a build with a different Scalar) to Scalar
+template <typename T>
+void convertParameters(const uint8_t* source, Scalar* out, size_t count) {
+    const T* values = reinterpret_cast<const T*>(source);
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = static_cast<Scalar>(values[i]);
+    }
+}
+
+// Layer record of version 1 model files (dense layers only)
+struct LayerRecordV1 {
+    uint32_t numNeurons;
+    uint32_t inputSize;
+    uint32_t useReLU;
+    uint32_t reserved;
+    uint64_t weightOffset;
+    uint64_t biasOffset;
+};
+
+// Number of weights and biases a layer record describes (0 for layers without parameters)
+std::pair<uint64_t, uint64_t> parameterCounts(const Network::LayerRecord& record) {
+    uint64_t inputs = uint64_t(record.inputHeight) * record.inputWidth * record.inputChannels;
+    switch (static_cast<Layer::Type>(record.type)) {
+        case Layer::Type::Dense:
+            return { uint64_t(record.numOutputs) * inputs, record.numOutputs };
+        case Layer::Type::Conv2D:
+            return { uint64_t(record.numOutputs) * record.kernelSize * record.kernelSize * record.inputChannels,
+                     record.numOutputs };
+        default:
+            return { 0, 0 };
+    }
+}
+
+// Builds the layer a record describes around the given parameters
+std::unique_ptr<Layer> makeLayer(const Network::LayerRecord& record, std::span<Scalar> weights,
+                                 std::span<Scalar> biases, std::shared_ptr<void> storage) {
+    Layer::Shape inputShape = { static_cast<int>(record.inputHeight), static_cast<int>(record.inputWidth),
+                                static_cast<int>(record.inputChannels) };
+    bool useReLU = record.useReLU != 0;
+    switch (static_cast<Layer::Type>(record.type)) {
+        case Layer::Type::Dense:
+            return std::make_unique<DenseLayer>(weights, biases, static_cast<int>(record.numOutputs),
+                                                static_cast<int>(inputShape.size()), useReLU, std::move(storage));
+        case Layer::Type::Conv2D:
+            return std::make_unique<Conv2DLayer>(inputShape, static_cast<int>(record.numOutputs),
+                                                 static_cast<int>(record.kernelSize), static_cast<int>(record.stride),
+                                                 static_cast<int>(record.padding), useReLU, weights, biases,
+                                                 std::move(storage));
+        case Layer::Type::MaxPool:
+            return std::make_unique<MaxPoolLayer>(inputShape, static_cast<int>(record.kernelSize));
+        case Layer::Type::Flatten:
+            return std::make_unique<FlattenLayer>(inputShape);
+    }
+    throw std::invalid_argument("Unknown layer type");
+}
+
+} // namespace
+
+// Constructor: Empty network, filled in by load()
+Network::Network() : inputSize(0), outputSize(0), sparseThreshold(DEFAULT_SPARSE_THRESHOLD) {}
+
 // Constructor: Initialize network with specified architecture and learning rate
 Network::Network(const std::vector<int>& layerSizes, double learningRate)
-    : inputSize(layerSizes[0]), outputSize(layerSizes.back()), learningRate(learningRate) {
+    : inputSize(layerSizes[0]), outputSize(layerSizes.back()), sparseThreshold(DEFAULT_SPARSE_THRESHOLD) {
     if (layerSizes.size() < 2) {
         throw std::invalid_argument("Network must have at least two layers (input and output)");
     }
+    Optimizer::Settings settings;
+    settings.learningRate = learningRate;
+    optimizer = Optimizer(settings);
     // Create layers based on the provided sizes, disabling ReLU for the output layer
     for (size_t i = 1; i < layerSizes.size(); ++i) {
         int numNeurons = layerSizes[i];
         int inputSize = layerSizes[i - 1];
         bool useReLU = (i < layerSizes.size() - 1); // true for hidden layers, false for output
-        layers.emplace_back(numNeurons, inputSize, useReLU);
+        layers.push_back(std::make_unique<DenseLayer>(numNeurons, inputSize, useReLU));
+    }
+    optimizer.reset(layers);
+}
+
+// Constructor: Network without layers; until layers are added it passes its inputs through
+Network::Network(int inputSize, double learningRate)
+    : inputSize(inputSize), outputSize(inputSize), sparseThreshold(DEFAULT_SPARSE_THRESHOLD) {
+    if (inputSize <= 0) {
+        throw std::invalid_argument("Input size must be positive");
+    }
+    Optimizer::Settings settings;
+    settings.learningRate = learningRate;
+    optimizer = Optimizer(settings);
+}
+
+// Copy constructor: Clones every layer, so the copy owns its parameters
+Network::Network(const Network& other)
+    : inputSize(other.inputSize), outputSize(other.outputSize), optimizer(other.optimizer),
+      workspace(other.workspace), sparseThreshold(other.sparseThreshold) {
+    layers.reserve(other.layers.size());
+    for (const auto& layer : other.layers) {
+        layers.push_back(layer->clone());
     }
 }
 
-// Add a new layer to the network
+// Copy assignment: Clones every layer
+Network& Network::operator=(const Network& other) {
+    if (this != &other) {
+        *this = Network(other);
+    }
+    return *this;
+}
+
+// Add a new dense layer to the network
 void Network::addLayer(int numNeurons, int inputSize) {
-    layers.emplace_back(numNeurons, inputSize);
+    addLayer(std::make_unique<DenseLayer>(numNeurons, inputSize));
+}
+
+// Appends any layer whose input size matches the current output size
+void Network::addLayer(std::unique_ptr<Layer> layer) {
+    if (!layer) {
+        throw std::invalid_argument("Layer must not be null");
+    }
+    size_t previousSize = layers.empty() ? static_cast<size_t>(inputSize) : layers.back()->getNumOutputs();
+    if (layer->getNumInputs() != previousSize) {
+        throw std::invalid_argument("Layer input size does not match the size of the previous layer");
+    }
+    outputSize = static_cast<int>(layer->getNumOutputs());
+    layers.push_back(std::move(layer));
+    optimizer.reset(layers);
+}
+
+// True if every layer is dense
+bool Network::isDenseOnly() const {
+    return std::all_of(layers.begin(), layers.end(),
+                       [](const std::unique_ptr<Layer>& layer) { return layer->getType() == Layer::Type::Dense; });
+}
+
+// Layer l as a dense layer
+DenseLayer& Network::denseLayer(size_t l) {
+    return static_cast<DenseLayer&>(*layers[l]);
+}
+
+// Layer l as a dense layer
+const DenseLayer& Network::denseLayer(size_t l) const {
+    return static_cast<const DenseLayer&>(*layers[l]);
+}
+
+// Replaces the optimizer; its state is sized for the current layers
+void Network::setOptimizer(const Optimizer::Settings& settings) {
+    optimizer = Optimizer(settings);
+    optimizer.reset(layers);
+}
+
+// Sets the learning rate of the current optimizer, keeping its state
+void Network::setLearningRate(double learningRate) {
+    optimizer.setLearningRate(learningRate);
+}
+
+// Sets the input density below which the first layer uses the sparse kernels
+void Network::setSparseThreshold(double threshold) {
+    if (!(threshold >= 0.0)) {
+        throw std::invalid_argument("Sparse threshold must not be negative");
+    }
+    sparseThreshold = threshold;
+}
+
+// Compresses the inputs when the sparse first layer is enabled (and dense); true if they are sparse enough to use it
+bool Network::compressInputs(std::span<const Scalar> inputs, size_t batchSize, SparseInputs& sparse) const {
+    return sparseThreshold > 0.0 && !layers.empty() && layers[0]->getType() == Layer::Type::Dense &&
+           sparse.compress(inputs, batchSize, inputSize) < sparseThreshold;
+}
+
+// Overwrites all weights and biases with those of a network of the same architecture
+void Network::copyParameters(const Network& other) {
+    if (other.layers.size() != layers.size() || other.inputSize != inputSize) {
+        throw std::invalid_argument("Network architectures do not match");
+    }
+    for (size_t l = 0; l < layers.size(); ++l) {
+        layers[l]->copyParameters(*other.layers[l]);
+    }
 }
 
 // Forward pass: Compute output probabilities given an input sample
-std::vector<double> Network::forward(const std::vector<double>& input) {
-    if (input.size() != inputSize) {
+std::vector<Scalar> Network::forward(std::span<const Scalar> input) {
+    std::vector<Scalar> probabilities(outputSize);
+    forward(input, probabilities);
+    return probabilities;
+}
+
+// Forward pass into a caller-provided buffer of output probabilities
+void Network::forward(std::span<const Scalar> input, std::span<Scalar> probabilities) {
+    if (input.size() != static_cast<size_t>(inputSize)) {
         throw std::invalid_argument("Input size does not match network input size");
     }
-    std::vector<double> activations = input;
-    for (auto& layer : layers) {
-        activations = layer.forward(activations);
+    if (probabilities.size() != static_cast<size_t>(outputSize)) {
+        throw std::invalid_argument("Output buffer size does not match network output size");
+    }
+    workspace.reserve(layers, inputSize, 1);
+    if (!isDenseOnly()) {
+        // Only dense layers have a per-sample pass: run a batch of one sample
+        if (input.data() != workspace.activations[0].data()) {
+            std::copy(input.begin(), input.end(), workspace.activations[0].begin());
+        }
+        predictBatch(workspace, 1);
+        std::copy_n(workspace.activations.back().begin(), outputSize, probabilities.begin());
+        return;
+    }
+    bool sparse = compressInputs(input, 1, workspace.sparseInputs);
+    // Each layer reads the previous layer's output buffer in place
+    std::span<const Scalar> activations = input;
+    for (size_t l = 0; l < layers.size(); ++l) {
+        NN_TRACE_SCOPE("forward", l);
+        activations = l == 0 && sparse ? denseLayer(0).forward(workspace.sparseInputs) : denseLayer(l).forward(activations);
     }
     // Apply Softmax to the output layer
-    double maxZ = *std::max_element(activations.begin(), activations.end());
-    double sumExp = 0.0;
-    for (auto& a : activations) {
+    std::copy(activations.begin(), activations.end(), probabilities.begin());
+    softmax(probabilities);
+}
+
+// Applies Softmax in place to a vector of logits
+void Network::softmax(std::span<Scalar> values) {
+    Scalar maxZ = *std::max_element(values.begin(), values.end());
+    Accumulator sumExp = 0.0;
+    for (auto& a : values) {
         a = std::exp(a - maxZ); // For numerical stability
         sumExp += a;
     }
-    for (auto& a : activations) {
-        a /= sumExp;
+    for (auto& a : values) {
+        a = static_cast<Scalar>(a / sumExp);
     }
-    return activations;
 }
 
 // Compute cross-entropy loss for a given sample and its label
-double Network::computeLoss(const std::vector<double>& output, int label) const {
+double Network::computeLoss(std::span<const Scalar> output, int label) const {
     if (label < 0 || label >= outputSize) {
         throw std::invalid_argument("Invalid label for loss computation");
     }
-    double loss = -std::log(output[label] + 1e-10); // Add epsilon to avoid log(0)
+    // Evaluated in double so float networks report the same loss scale; epsilon avoids log(0)
+    double loss = -std::log(static_cast<Accumulator>(output[label]) + 1e-10);
     return loss;
 }
 
 // Backpropagation: Compute gradients and update weights for a given sample and label
-void Network::backpropagate(const std::vector<double>& input, int label) {
-    // Forward pass to get activations
-    std::vector<std::vector<double>> activations;
-    activations.push_back(input);
-    std::vector<double> current = input;
-    for (auto& layer : layers) {
-        current = layer.forward(current);
-        activations.push_back(current);
+void Network::backpropagate(std::span<const Scalar> input, int label) {
+    trainStep(input, label);
+}
+
+// Fused training step: one forward pass, Softmax cross-entropy loss and gradient, backpropagation
+// and weight update; returns the loss of the sample before the update
+double Network::trainStep(std::span<const Scalar> input, int label) {
+    if (input.size() != static_cast<size_t>(inputSize)) {
+        throw std::invalid_argument("Input size does not match network input size");
+    }
+    workspace.reserve(layers, inputSize, 1);
+    if (!optimizer.isStateless() || !isDenseOnly()) {
+        // The optimizer needs the gradients themselves, or a layer has no per-sample pass: run a batch of one sample
+        if (input.data() != workspace.activations[0].data()) {
+            std::copy(input.begin(), input.end(), workspace.activations[0].begin());
+        }
+        workspace.labels.assign(1, label);
+        return runBatch();
+    }
+    // The probabilities and output gradients use the first row of the workspace's output buffers
+    std::span<Scalar> probabilities(workspace.activations.back().data(), outputSize);
+    std::span<Scalar> outputGradients(workspace.deltas.back().data(), outputSize);
+    // Forward pass: every layer keeps its outputs, which serve as the next layer's inputs
+    // for both the forward pass and the weight update, so activations are never copied.
+    // Sparse inputs are compressed once and reused by the first layer's weight update
+    bool sparse = compressInputs(input, 1, workspace.sparseInputs);
+    std::span<const Scalar> logits = input;
+    for (size_t l = 0; l < layers.size(); ++l) {
+        NN_TRACE_SCOPE("forward", l);
+        logits = l == 0 && sparse ? denseLayer(0).forward(workspace.sparseInputs) : denseLayer(l).forward(logits);
     }
     // Compute Softmax probabilities from output layer logits
-    std::vector<double> logits = activations.back();
-    std::vector<double> probabilities(logits.size());
-    double maxZ = *std::max_element(logits.begin(), logits.end());
-    double sumExp = 0.0;
+    Scalar maxZ = *std::max_element(logits.begin(), logits.end());
+    Accumulator sumExp = 0.0;
     for (size_t i = 0; i < logits.size(); ++i) {
         probabilities[i] = std::exp(logits[i] - maxZ);
         sumExp += probabilities[i];
     }
     for (auto& p : probabilities) {
-        p /= sumExp;
+        p = static_cast<Scalar>(p / sumExp);
     }
+    // Cross-entropy loss from the same probabilities (also validates the label)
+    double loss = computeLoss(probabilities, label);
     // Compute output layer gradients (p_i - y_i for Softmax + Cross-Entropy)
-    std::vector<double> outputGradients(outputSize);
     for (int i = 0; i < outputSize; ++i) {
-        outputGradients[i] = probabilities[i] - (i == label ? 1.0 : 0.0);
+        outputGradients[i] = probabilities[i] - (i == label ? 1 : 0);
     }
-    // Backpropagate through layers
-    std::vector<double> nextLayerGradients = outputGradients;
+    // Backpropagate through layers, reading the next layer's gradients and weights in place
     for (size_t l = layers.size() - 1; l < layers.size(); --l) {
-        bool isOutputLayer = (l == layers.size() - 1);
-        // Collect weights from the next layer (if not the output layer)
-        std::vector<std::vector<double>> nextLayerWeights;
-        if (!isOutputLayer && l + 1 < layers.size()) {
-            for (const auto& neuron : layers[l + 1].getNeurons()) {
-                nextLayerWeights.push_back(neuron.getWeights());
-            }
+        NN_TRACE_SCOPE("backward", l);
+        if (l == layers.size() - 1) {
+            denseLayer(l).computeGradients(outputGradients, {}, true);
+        } else {
+            denseLayer(l).computeGradients(denseLayer(l + 1).getGradients(), layers[l + 1]->getWeights(), false);
         }
-        layers[l].computeGradients(nextLayerGradients, nextLayerWeights, isOutputLayer, label);
-        // Prepare gradients for the previous layer
-        if (l > 0) {
-            nextLayerGradients.clear();
-            for (const auto& neuron : layers[l].getNeurons()) {
-                nextLayerGradients.push_back(neuron.getGradient());
-            }
+    }
+    // Update weights; each layer's inputs are the input sample or the previous layer's outputs
+    for (size_t l = 0; l < layers.size(); ++l) {
+        NN_TRACE_SCOPE("update", l);
+        if (l == 0 && sparse) {
+            denseLayer(0).updateWeights(workspace.sparseInputs, optimizer.getLearningRate());
+        } else {
+            denseLayer(l).updateWeights(l == 0 ? input : denseLayer(l - 1).getOutputs(), optimizer.getLearningRate());
         }
     }
-    // Update weights
-    for (auto& layer : layers) {
-        layer.updateWeights(learningRate);
+    return loss;
+}
+
+// Stacks count samples starting at first into the buffers' input matrix and label list
+void Network::loadBatch(const Dataset& data, size_t first, size_t count, Workspace& buffers) const {
+    if (data.getSampleSize() != static_cast<size_t>(inputSize)) {
+        throw std::invalid_argument("Dataset sample size does not match network input size");
+    }
+    NN_TRACE_SCOPE("load batch", -1);
+    // Pixels are normalized while they are stacked into the input matrix
+    data.getBatch(first, count, buffers.activations[0]);
+    buffers.labels.clear();
+    for (size_t b = 0; b < count; ++b) {
+        buffers.labels.push_back(data.getLabel(first + b));
     }
 }
 
-// Train the network over multiple epochs using the training dataset
-void Network::train(const Dataset& trainData, int epochs) {
+// Fills the input matrix and labels of the training buffers with the source's next batch
+size_t Network::nextBatch(BatchSource& source) {
+    NN_TRACE_SCOPE("load batch", -1);
+    return source.nextBatch(workspace.activations[0], workspace.labels);
+}
+
+// Forward pass, loss and backward pass over the samples stacked in the buffers; returns the summed loss
+double Network::computeBatchGradients(Workspace& buffers) const {
+    size_t batchSize = buffers.labels.size();
+    bool sparse = compressInputs(buffers.activations[0], batchSize, buffers.sparseInputs);
+    // Forward pass: one matrix-matrix product per layer
+    for (size_t l = 0; l < layers.size(); ++l) {
+        NN_TRACE_SCOPE("forward", l);
+        if (l == 0 && sparse) {
+            denseLayer(0).forwardBatch(buffers.sparseInputs, buffers.activations[1], batchSize);
+        } else {
+            layers[l]->forwardBatch(buffers.activations[l], buffers.activations[l + 1], batchSize, buffers.scratch[l]);
+        }
+    }
+    // Softmax + cross-entropy for every sample; dL/dz of the output is p - y
+    Accumulator totalLoss = 0.0;
+    std::vector<Scalar>& logits = buffers.activations.back();
+    std::vector<Scalar>& outputDeltas = buffers.deltas.back();
+    for (size_t b = 0; b < batchSize; ++b) {
+        int label = buffers.labels[b];
+        if (label < 0 || label >= outputSize) {
+            throw std::invalid_argument("Invalid label for loss computation");
+        }
+        std::span<Scalar> probabilities(logits.data() + b * outputSize, outputSize);
+        softmax(probabilities);
+        totalLoss += -std::log(static_cast<Accumulator>(probabilities[label]) + 1e-10); // Same epsilon as computeLoss
+        for (int i = 0; i < outputSize; ++i) {
+            outputDeltas[b * outputSize + i] = probabilities[i] - (i == label ? 1 : 0);
+        }
+    }
+    // Backward pass: accumulate gradients over the batch, propagating deltas to the previous layer
+    for (size_t l = layers.size(); l-- > 0;) {
+        NN_TRACE_SCOPE("backward", l);
+        std::fill(buffers.weightGradients[l].begin(), buffers.weightGradients[l].end(), Scalar(0));
+        std::fill(buffers.biasGradients[l].begin(), buffers.biasGradients[l].end(), Scalar(0));
+        if (l == 0 && sparse) {
+            denseLayer(0).backwardBatch(buffers.sparseInputs, buffers.activations[1], buffers.deltas[0],
+                                        buffers.weightGradients[0], buffers.biasGradients[0], batchSize);
+            continue;
+        }
+        std::span<Scalar> inputDeltas = l > 0 ? std::span<Scalar>(buffers.deltas[l - 1]) : std::span<Scalar>();
+        layers[l]->backwardBatch(buffers.activations[l], buffers.activations[l + 1], buffers.deltas[l], inputDeltas,
+                                 buffers.weightGradients[l], buffers.biasGradients[l], batchSize, buffers.scratch[l]);
+    }
+    return totalLoss;
+}
+
+// Applies the gradients held in the buffers with the optimizer, averaged over the batch
+void Network::applyBatchGradients(const Workspace& buffers, size_t batchSize) {
+    optimizer.beginStep();
+    for (size_t l = 0; l < layers.size(); ++l) {
+        NN_TRACE_SCOPE("update", l);
+        layers[l]->applyGradients(buffers.weightGradients[l], buffers.biasGradients[l], batchSize, optimizer, l);
+    }
+}
+
+// Trains on the samples already stacked in the workspace; returns the summed loss
+double Network::runBatch() {
+    double totalLoss = computeBatchGradients(workspace);
+    applyBatchGradients(workspace, workspace.labels.size());
+    return totalLoss;
+}
+
+// Mini-batch step on caller-provided samples stacked row by row
+double Network::trainBatch(std::span<const Scalar> inputs, std::span<const int> labels) {
+    if (labels.empty() || inputs.size() != labels.size() * inputSize) {
+        throw std::invalid_argument("Batch input size does not match number of labels");
+    }
+    workspace.reserve(layers, inputSize, labels.size());
+    std::copy(inputs.begin(), inputs.end(), workspace.activations[0].begin());
+    workspace.labels.assign(labels.begin(), labels.end());
+    return runBatch();
+}
+
+// Train the network over multiple epochs using the training dataset, in file order
+void Network::train(const Dataset& trainData, int epochs, size_t batchSize) {
+    DatasetSource source(trainData);
+    train(source, epochs, batchSize);
+}
+
+// Train the network over multiple epochs on batches from any source, one update per mini-batch
+void Network::train(BatchSource& source, int epochs, size_t batchSize) {
+    if (batchSize == 0) {
+        throw std::invalid_argument("Batch size must be positive");
+    }
+    if (source.getSampleSize() != static_cast<size_t>(inputSize)) {
+        throw std::invalid_argument("Sample size does not match network input size");
+    }
+    workspace.reserve(layers, inputSize, std::max<size_t>(1, std::min(batchSize, source.getNumSamples())));
+    for (int epoch = 0; epoch < epochs; ++epoch) {
+        Accumulator totalLoss = 0.0;
+        size_t numSamples = 0;
+        source.startEpoch(epoch, batchSize);
+        // The source writes each batch straight into the input activation matrix
+        while (size_t count = nextBatch(source)) {
+            if (count == 1) {
+                // The fused per-sample step skips the batched kernels (for plain SGD; other optimizers batch inside)
+                totalLoss += trainStep(std::span<const Scalar>(workspace.activations[0].data(), inputSize), workspace.labels[0]);
+            } else {
+                totalLoss += runBatch();
+            }
+            numSamples += count;
+        }
+        // Print average loss for the epoch
+        std::cout << "Epoch " << epoch + 1 << ", Loss: " << totalLoss / std::max<size_t>(1, numSamples) << std::endl;
+    }
+}
+
+// Train the network with several threads, either synchronously or Hogwild-style
+Network::TrainingStats Network::trainParallel(const Dataset& trainData, int epochs, size_t batchSize,
+                                              unsigned numThreads, ParallelMode mode) {
+    if (batchSize == 0) {
+        throw std::invalid_argument("Batch size must be positive");
+    }
+    if (mode == ParallelMode::Hogwild && !optimizer.isStateless()) {
+        throw std::invalid_argument("Hogwild training only supports plain SGD");
+    }
+    ThreadPool pool(numThreads);
+    size_t threads = pool.getNumThreads();
+    size_t numSamples = trainData.getNumSamples();
+    // Synchronous mode splits every batch into one shard per thread; Hogwild gives each thread whole batches
+    size_t shardSize = mode == ParallelMode::Synchronous ? (batchSize + threads - 1) / threads : batchSize;
+    std::vector<Workspace> workers(threads);
+    for (auto& buffers : workers) {
+        buffers.reserve(layers, inputSize, std::min(shardSize, numSamples));
+    }
+    std::vector<Accumulator> workerLoss(threads);
+
+    TrainingStats stats;
+    auto start = std::chrono::steady_clock::now();
     for (int epoch = 0; epoch < epochs; ++epoch) {
-        double totalLoss = 0.0;
-        for (size_t i = 0; i < trainData.getNumSamples(); ++i) {
-            const auto& sample = trainData.getSample(i);
-            int label = trainData.getLabel(i);
-            // Forward pass
-            auto output = forward(sample);
-            // Compute loss
-            double loss = computeLoss(output, label);
+        std::fill(workerLoss.begin(), workerLoss.end(), 0.0);
+        if (mode == ParallelMode::Synchronous) {
+            for (size_t first = 0; first < numSamples; first += batchSize) {
+                size_t count = std::min(batchSize, numSamples - first);
+                size_t shards = (count + shardSize - 1) / shardSize;
+                // Each worker computes the gradients of its shard
+                pool.parallelFor(shards, [&](size_t shard) {
+                    size_t shardFirst = first + shard * shardSize;
+                    loadBatch(trainData, shardFirst, std::min(shardSize, first + count - shardFirst), workers[shard]);
+                    workerLoss[shard] += computeBatchGradients(workers[shard]);
+                });
+                // Reduce all shard gradients into the first worker's buffers, one layer slice per task
+                if (shards > 1) {
+                    pool.parallelFor(layers.size() * threads, [&](size_t task) {
+                        size_t l = task / threads;
+                        size_t part = task % threads;
+                        std::vector<Scalar>& weightSum = workers[0].weightGradients[l];
+                        size_t sliceSize = (weightSum.size() + threads - 1) / threads;
+                        size_t sliceBegin = std::min(weightSum.size(), part * sliceSize);
+                        size_t sliceEnd = std::min(weightSum.size(), sliceBegin + sliceSize);
+                        for (size_t shard = 1; shard < shards; ++shard) {
+                            Kernels::axpy(1, workers[shard].weightGradients[l].data() + sliceBegin,
+                                          weightSum.data() + sliceBegin, sliceEnd - sliceBegin);
+                            if (part == 0) {
+                                Kernels::axpy(1, workers[shard].biasGradients[l].data(),
+                                              workers[0].biasGradients[l].data(), workers[0].biasGradients[l].size());
+                            }
+                        }
+                    });
+                }
+                // One shared update per batch
+                applyBatchGradients(workers[0], count);
+            }
+        } else {
+            // Hogwild: every thread walks its own contiguous slice of the data and updates the shared
+            // weights without synchronization. Updates race by design and some may be lost; this trades
+            // determinism for throughput and is only intended for sparse-update experiments
+            size_t sliceSize = (numSamples + threads - 1) / threads;
+            pool.parallelFor(threads, [&](size_t worker) {
+                size_t sliceBegin = std::min(numSamples, worker * sliceSize);
+                size_t sliceEnd = std::min(numSamples, sliceBegin + sliceSize);
+                for (size_t first = sliceBegin; first < sliceEnd; first += batchSize) {
+                    size_t count = std::min(batchSize, sliceEnd - first);
+                    loadBatch(trainData, first, count, workers[worker]);
+                    workerLoss[worker] += computeBatchGradients(workers[worker]);
+                    applyBatchGradients(workers[worker], count);
+                }
+            });
+        }
+        Accumulator totalLoss = 0.0;
+        for (Accumulator loss : workerLoss) {
             totalLoss += loss;
-            // Backpropagation
-            backpropagate(sample, label);
         }
+        stats.averageLoss = totalLoss / std::max<size_t>(1, numSamples);
         // Print average loss for the epoch
-        std::cout << "Epoch " << epoch + 1 << ", Loss: " << totalLoss / trainData.getNumSamples() << std::endl;
+        std::cout << "Epoch " << epoch + 1 << ", Loss: " << stats.averageLoss << std::endl;
     }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.samplesPerSecond = stats.seconds > 0.0 ? static_cast<double>(numSamples) * epochs / stats.seconds : 0.0;
+    std::cout << "Trained on " << threads << " threads: " << stats.samplesPerSecond << " samples/sec" << std::endl;
+    return stats;
 }
 
-// Test the network on the test dataset and compute accuracy
-double Network::test(const Dataset& testData) {
+// Const forward pass over the samples stacked in the buffers, ending with Softmax per sample
+void Network::predictBatch(Workspace& buffers, size_t batchSize) const {
+    bool sparse = compressInputs(buffers.activations[0], batchSize, buffers.sparseInputs);
+    for (size_t l = 0; l < layers.size(); ++l) {
+        NN_TRACE_SCOPE("predict", l);
+        if (l == 0 && sparse) {
+            denseLayer(0).forwardBatch(buffers.sparseInputs, buffers.activations[1], batchSize);
+        } else {
+            layers[l]->forwardBatch(buffers.activations[l], buffers.activations[l + 1], batchSize, buffers.scratch[l]);
+        }
+    }
+    std::vector<Scalar>& outputs = buffers.activations.back();
+    for (size_t b = 0; b < batchSize; ++b) {
+        softmax(std::span<Scalar>(outputs.data() + b * outputSize, outputSize));
+    }
+}
+
+// Const, reentrant inference using scratch buffers local to the call
+std::vector<Scalar> Network::predict(std::span<const Scalar> input) const {
+    if (input.size() != static_cast<size_t>(inputSize)) {
+        throw std::invalid_argument("Input size does not match network input size");
+    }
+    Workspace scratch;
+    scratch.reserve(layers, inputSize, 1);
+    std::copy(input.begin(), input.end(), scratch.activations[0].begin());
+    predictBatch(scratch, 1);
+    return scratch.activations.back();
+}
+
+// Const, reentrant batched inference on caller-provided samples stacked row by row
+void Network::predictBatch(std::span<const Scalar> inputs, std::span<Scalar> probabilities, size_t batchSize) const {
+    Workspace scratch;
+    predictBatch(inputs, probabilities, batchSize, scratch);
+}
+
+// Batched inference with caller-owned scratch buffers
+void Network::predictBatch(std::span<const Scalar> inputs, std::span<Scalar> probabilities, size_t batchSize,
+                           Workspace& scratch) const {
+    if (inputs.size() < batchSize * inputSize || probabilities.size() < batchSize * outputSize) {
+        throw std::invalid_argument("Batch buffers are too small for network");
+    }
+    scratch.reserve(layers, inputSize, batchSize);
+    std::copy(inputs.begin(), inputs.begin() + batchSize * inputSize, scratch.activations[0].begin());
+    predictBatch(scratch, batchSize);
+    std::copy(scratch.activations.back().begin(), scratch.activations.back().begin() + batchSize * outputSize,
+              probabilities.begin());
+}
+
+// Returns a workspace sized for this network and batches of up to batchSize samples
+Workspace Network::makeWorkspace(size_t batchSize) const {
+    return Workspace(layers, inputSize, batchSize);
+}
+
+// Evaluate the network on a dataset: accuracy, confusion matrix and per-class precision/recall
+Network::EvaluationResult Network::evaluate(const Dataset& testData, unsigned numThreads, size_t batchSize) const {
+    if (batchSize == 0) {
+        throw std::invalid_argument("Batch size must be positive");
+    }
+    ThreadPool pool(numThreads);
+    size_t threads = pool.getNumThreads();
+    size_t numSamples = testData.getNumSamples();
+    size_t shardSize = (numSamples + threads - 1) / threads;
+    // Every thread keeps its own scratch buffers and its own confusion matrix
+    std::vector<std::vector<std::vector<int>>> partialMatrices(
+        threads, std::vector<std::vector<int>>(outputSize, std::vector<int>(outputSize, 0)));
+    pool.parallelFor(threads, [&](size_t worker) {
+        size_t shardBegin = std::min(numSamples, worker * shardSize);
+        size_t shardEnd = std::min(numSamples, shardBegin + shardSize);
+        Workspace scratch;
+        scratch.reserve(layers, inputSize, std::min(batchSize, shardEnd - shardBegin));
+        std::vector<std::vector<int>>& matrix = partialMatrices[worker];
+        for (size_t first = shardBegin; first < shardEnd; first += batchSize) {
+            size_t count = std::min(batchSize, shardEnd - first);
+            loadBatch(testData, first, count, scratch);
+            predictBatch(scratch, count);
+            for (size_t b = 0; b < count; ++b) {
+                int label = scratch.labels[b];
+                if (label < 0 || label >= outputSize) {
+                    throw std::invalid_argument("Invalid label in test data");
+                }
+                // Predict the class with the highest probability
+                const Scalar* output = scratch.activations.back().data() + b * outputSize;
+                ptrdiff_t predicted = std::distance(output, std::max_element(output, output + outputSize));
+                matrix[label][predicted]++;
+            }
+        }
+    });
+
+    // Merge the per-thread confusion matrices and derive the metrics
+    EvaluationResult result;
+    result.confusionMatrix.assign(outputSize, std::vector<int>(outputSize, 0));
+    for (const auto& matrix : partialMatrices) {
+        for (int actual = 0; actual < outputSize; ++actual) {
+            for (int predicted = 0; predicted < outputSize; ++predicted) {
+                result.confusionMatrix[actual][predicted] += matrix[actual][predicted];
+            }
+        }
+    }
     int correct = 0;
-    for (size_t i = 0; i < testData.getNumSamples(); ++i) {
-        const auto& sample = testData.getSample(i);
-        int label = testData.getLabel(i);
-        // Forward pass
-        auto output = forward(sample);
-        // Predict the digit with the highest probability
-        ptrdiff_t predicted = std::distance(output.begin(), std::max_element(output.begin(), output.end()));
-        if (predicted == label) {
-            correct++;
-        }
-    }
-    // Compute and return accuracy
-    double accuracy = static_cast<double>(correct) / testData.getNumSamples();
-    std::cout << "Test Accuracy: " << accuracy << std::endl;
-    return accuracy;
+    result.precision.assign(outputSize, 0.0);
+    result.recall.assign(outputSize, 0.0);
+    for (int c = 0; c < outputSize; ++c) {
+        int truePositives = result.confusionMatrix[c][c];
+        int actualCount = 0;
+        int predictedCount = 0;
+        for (int k = 0; k < outputSize; ++k) {
+            actualCount += result.confusionMatrix[c][k];
+            predictedCount += result.confusionMatrix[k][c];
+        }
+        correct += truePositives;
+        result.precision[c] = predictedCount > 0 ? static_cast<double>(truePositives) / predictedCount : 0.0;
+        result.recall[c] = actualCount > 0 ? static_cast<double>(truePositives) / actualCount : 0.0;
+    }
+    result.accuracy = numSamples > 0 ? static_cast<double>(correct) / numSamples : 0.0;
+    return result;
+}
+
+// Test the network on the test dataset, print the confusion matrix and per-class metrics, and return accuracy
+double Network::test(const Dataset& testData, unsigned numThreads) const {
+    EvaluationResult result = evaluate(testData, numThreads);
+    // Confusion matrix: rows are true labels, columns are predictions
+    std::cout << "Confusion matrix (rows: true label, columns: predicted):" << std::endl;
+    for (int actual = 0; actual < outputSize; ++actual) {
+        std::cout << std::setw(3) << actual << ":";
+        for (int predicted = 0; predicted < outputSize; ++predicted) {
+            std::cout << std::setw(6) << result.confusionMatrix[actual][predicted];
+        }
+        std::cout << std::endl;
+    }
+    std::streamsize previousPrecision = std::cout.precision(3);
+    for (int c = 0; c < outputSize; ++c) {
+        std::cout << "Class " << c << ": precision " << result.precision[c] << ", recall " << result.recall[c] << std::endl;
+    }
+    std::cout.precision(previousPrecision);
+    std::cout << "Test Accuracy: " << result.accuracy << std::endl;
+    return result.accuracy;
+}
+
+// Writes the architecture, weights and biases to a model file
+void Network::save(const std::string& filename) const {
+    FileHeader header = {};
+    std::memcpy(header.magic, "NNMD", sizeof(header.magic));
+    header.version = MODEL_VERSION;
+    header.scalarSize = sizeof(Scalar);
+    header.numLayers = static_cast<uint32_t>(layers.size());
+    header.inputSize = static_cast<uint32_t>(inputSize);
+    header.learningRate = optimizer.getLearningRate();
+
+    // Lay out the parameter blocks after the layer records, each one aligned
+    std::vector<LayerRecord> records(layers.size());
+    uint64_t offset = alignOffset(sizeof(FileHeader) + records.size() * sizeof(LayerRecord));
+    for (size_t l = 0; l < layers.size(); ++l) {
+        const Layer& layer = *layers[l];
+        Layer::Shape inputShape = layer.getInputShape();
+        LayerRecord& record = records[l];
+        record = {};
+        record.type = static_cast<uint32_t>(layer.getType());
+        record.useReLU = layer.usesReLU() ? 1 : 0;
+        record.inputHeight = static_cast<uint32_t>(inputShape.height);
+        record.inputWidth = static_cast<uint32_t>(inputShape.width);
+        record.inputChannels = static_cast<uint32_t>(inputShape.channels);
+        switch (layer.getType()) {
+            case Layer::Type::Dense:
+                record.numOutputs = static_cast<uint32_t>(layer.getNumOutputs());
+                break;
+            case Layer::Type::Conv2D: {
+                const Conv2DLayer& conv = static_cast<const Conv2DLayer&>(layer);
+                record.numOutputs = static_cast<uint32_t>(conv.getNumFilters());
+                record.kernelSize = static_cast<uint32_t>(conv.getKernelSize());
+                record.stride = static_cast<uint32_t>(conv.getStride());
+                record.padding = static_cast<uint32_t>(conv.getPadding());
+                break;
+            }
+            case Layer::Type::MaxPool:
+                record.kernelSize = static_cast<uint32_t>(static_cast<const MaxPoolLayer&>(layer).getPoolSize());
+                break;
+            case Layer::Type::Flatten:
+                break;
+        }
+        record.weightOffset = offset;
+        offset = alignOffset(offset + layer.getWeights().size_bytes());
+        record.biasOffset = offset;
+        offset = alignOffset(offset + layer.getBiases().size_bytes());
+    }
+
+    std::string temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not create file: " + temporary);
+        }
+        uint64_t position = 0;
+        // Writes a block of bytes at the given offset, zero-padding the gap before it
+        auto writeAt = [&](uint64_t blockOffset, const void* bytes, size_t size) {
+            std::vector<char> padding(blockOffset - position, 0);
+            file.write(padding.data(), padding.size());
+            file.write(static_cast<const char*>(bytes), size);
+            position = blockOffset + size;
+        };
+        writeAt(0, &header, sizeof(header));
+        writeAt(position, records.data(), records.size() * sizeof(LayerRecord));
+        for (size_t l = 0; l < layers.size(); ++l) {
+            writeAt(records[l].weightOffset, layers[l]->getWeights().data(), layers[l]->getWeights().size_bytes());
+            writeAt(records[l].biasOffset, layers[l]->getBiases().data(), layers[l]->getBiases().size_bytes());
+        }
+        if (!file) {
+            throw std::runtime_error("Could not write file: " + temporary);
+        }
+    }
+    std::filesystem::rename(temporary, filename);
+}
+
+// Loads a model file written by save(), using the parameters in place when the Scalar type matches
+Network Network::load(const std::string& filename) {
+    auto file = std::make_shared<MappedFile>(filename, MappedFile::Mode::CopyOnWrite);
+    const uint8_t* bytes = file->data();
+    size_t fileSize = file->size();
+
+    FileHeader header;
+    if (fileSize < sizeof(header)) {
+        throw std::runtime_error("Truncated model file: " + filename);
+    }
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic, "NNMD", sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Not a model file: " + filename);
+    }
+    if (header.version != MODEL_VERSION && header.version != 1) {
+        throw std::runtime_error("Unsupported model file version " + std::to_string(header.version) + ": " + filename);
+    }
+    if (header.scalarSize != sizeof(float) && header.scalarSize != sizeof(double)) {
+        throw std::runtime_error("Unsupported parameter type in model file: " + filename);
+    }
+    size_t recordSize = header.version == 1 ? sizeof(LayerRecordV1) : sizeof(LayerRecord);
+    if (header.numLayers == 0 || sizeof(header) + uint64_t(header.numLayers) * recordSize > fileSize) {
+        throw std::runtime_error("Corrupt model file: " + filename);
+    }
+
+    Network network;
+    network.inputSize = static_cast<int>(header.inputSize);
+    // The learning rate is kept for further training with plain SGD; optimizer state is not saved
+    if (header.learningRate > 0.0) {
+        Optimizer::Settings settings;
+        settings.learningRate = header.learningRate;
+        network.optimizer = Optimizer(settings);
+    }
+    uint64_t previousSize = header.inputSize;
+    for (uint32_t l = 0; l < header.numLayers; ++l) {
+        const uint8_t* recordBytes = bytes + sizeof(header) + l * recordSize;
+        LayerRecord record = {};
+        if (header.version == 1) {
+            // Version 1 records describe dense layers
+            LayerRecordV1 dense;
+            std::memcpy(&dense, recordBytes, sizeof(dense));
+            record.type = static_cast<uint32_t>(Layer::Type::Dense);
+            record.useReLU = dense.useReLU;
+            record.inputHeight = 1;
+            record.inputWidth = 1;
+            record.inputChannels = dense.inputSize;
+            record.numOutputs = dense.numNeurons;
+            record.weightOffset = dense.weightOffset;
+            record.biasOffset = dense.biasOffset;
+        } else {
+            std::memcpy(&record, recordBytes, sizeof(record));
+        }
+        auto [numWeights, numBiases] = parameterCounts(record);
+        uint64_t numInputs = uint64_t(record.inputHeight) * record.inputWidth * record.inputChannels;
+        bool valid = numInputs == previousSize && numInputs <= INT32_MAX &&
+                     record.weightOffset % header.scalarSize == 0 && record.biasOffset % header.scalarSize == 0 &&
+                     record.weightOffset <= fileSize && numWeights <= (fileSize - record.weightOffset) / header.scalarSize &&
+                     record.biasOffset <= fileSize && numBiases <= (fileSize - record.biasOffset) / header.scalarSize;
+        if (!valid) {
+            throw std::runtime_error("Corrupt model file: " + filename);
+        }
+        std::unique_ptr<Layer> layer;
+        try {
+            if (header.scalarSize == sizeof(Scalar)) {
+                // Same parameter type: point the layer straight into the mapping
+                Scalar* weights = reinterpret_cast<Scalar*>(file->writableData() + record.weightOffset);
+                Scalar* biases = reinterpret_cast<Scalar*>(file->writableData() + record.biasOffset);
+                layer = makeLayer(record, std::span<Scalar>(weights, numWeights), std::span<Scalar>(biases, numBiases), file);
+            } else {
+                // Written by a build with the other Scalar type: convert into one owned block
+                auto converted = std::make_shared<std::vector<Scalar>>(numWeights + numBiases);
+                if (header.scalarSize == sizeof(float)) {
+                    convertParameters<float>(bytes + record.weightOffset, converted->data(), numWeights);
+                    convertParameters<float>(bytes + record.biasOffset, converted->data() + numWeights, numBiases);
+                } else {
+                    convertParameters<double>(bytes + record.weightOffset, converted->data(), numWeights);
+                    convertParameters<double>(bytes + record.biasOffset, converted->data() + numWeights, numBiases);
+                }
+                layer = makeLayer(record, std::span<Scalar>(converted->data(), numWeights),
+                                  std::span<Scalar>(converted->data() + numWeights, numBiases), converted);
+            }
+        } catch (const std::invalid_argument&) {
+            // Layer settings out of range or an unknown layer type
+            throw std::runtime_error("Corrupt model file: " + filename);
+        }
+        if (layer->getNumOutputs() == 0) {
+            throw std::runtime_error("Corrupt model file: " + filename);
+        }
+        previousSize = layer->getNumOutputs();
+        network.layers.push_back(std::move(layer));
+    }
+    network.outputSize = static_cast<int>(previousSize);
+    network.optimizer.reset(network.layers);
+    return network;
+}
+
+// Getter: Returns the optimizer
+const Optimizer& Network::getOptimizer() const {
+    return optimizer;
+}
+
+// Getter: Returns the input density below which the first layer uses the sparse kernels
+double Network::getSparseThreshold() const {
+    return sparseThreshold;
+}
+
+// Getter: Returns the layers of the network, input layer first
+const std::vector<std::unique_ptr<Layer>>& Network::getLayers() const {
+    return layers;
+}
+
+// Getter: Returns the number of input features
+int Network::getInputSize() const {
+    return inputSize;
+}
+
+// Getter: Returns the number of output classes
+int Network::getOutputSize() const {
+    return outputSize;
 }
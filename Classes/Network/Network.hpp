@@ -9,39 +9,226 @@
 #define Network_hpp
 
 #include "Layer.hpp"
+#include "DenseLayer.hpp"
 #include "Dataset.hpp"
+#include "BatchSource.hpp"
+#include "Optimizer.hpp"
+#include "Workspace.hpp"
+#include <cstdint>
+#include <memory>
 #include <vector>
+#include <span>
 #include <stdexcept>
+#include <string>
 
-// Class representing a neural network composed of layers
+// Class representing a neural network composed of layers.
+// Any stack of layers (dense, conv2d, max-pool, flatten) trains through the batched passes; networks made
+// only of dense layers also get the fused per-sample step and the sparse first layer.
 class Network {
 private:
-    std::vector<Layer> layers;      // Sequence of layers in the network
+    std::vector<std::unique_ptr<Layer>> layers; // Sequence of layers in the network
     int inputSize;                  // Number of input features (784 for MNIST)
     int outputSize;                 // Number of output classes (10 for digits 0-9)
-    double learningRate;            // Learning rate for gradient descent
+    Optimizer optimizer;            // Update rule, learning rate and per-layer optimizer state
+
+    Workspace workspace;            // Buffers of single-threaded training, reused across steps
+    double sparseThreshold;         // Input density below which the first layer uses the sparse kernels
+
+    // Constructor: Empty network, filled in by load()
+    Network();
+
+    // True if every layer is dense, which enables the per-sample paths
+    bool isDenseOnly() const;
+
+    // Layer l as a dense layer (only valid when it is one)
+    DenseLayer& denseLayer(size_t l);
+    const DenseLayer& denseLayer(size_t l) const;
+
+    // Applies Softmax in place to a vector of logits
+    static void softmax(std::span<Scalar> values);
+
+    // Stacks count samples starting at first into the buffers' input matrix and label list
+    void loadBatch(const Dataset& data, size_t first, size_t count, Workspace& buffers) const;
+
+    // Fills the input matrix and labels of the workspace with the source's next batch; returns its size
+    size_t nextBatch(BatchSource& source);
+
+    // Compresses the first batchSize input rows into sparse and returns true if their density is below
+    // sparseThreshold, i.e. if the first layer should use the sparse kernels for them
+    bool compressInputs(std::span<const Scalar> inputs, size_t batchSize, SparseInputs& sparse) const;
+
+    // Forward pass, loss and backward pass over the samples stacked in the buffers.
+    // Overwrites the buffers' gradients with the batch sums; returns the summed loss
+    double computeBatchGradients(Workspace& buffers) const;
+
+    // Applies the gradients held in the buffers (sums over batchSize samples) with the optimizer
+    void applyBatchGradients(const Workspace& buffers, size_t batchSize);
+
+    // Trains on the samples already stacked in the workspace; returns the summed loss
+    double runBatch();
+
+    // Const forward pass over the samples stacked in the buffers; the last activation
+    // matrix receives the output probabilities. Safe to call concurrently with separate buffers
+    void predictBatch(Workspace& buffers, size_t batchSize) const;
 
 public:
+    // Default input density below which the first layer skips zero inputs (about 19% of MNIST pixels are nonzero)
+    static constexpr double DEFAULT_SPARSE_THRESHOLD = 0.3;
+
     // Constructor: Initialize network with specified architecture and learning rate
     Network(const std::vector<int>& layerSizes, double learningRate);
 
-    // Add a new layer to the network
+    // Constructor: Network without layers taking inputSize features; layers are added with addLayer()
+    Network(int inputSize, double learningRate);
+
+    // Copies own their layers' parameters (see Layer::clone)
+    Network(const Network& other);
+    Network& operator=(const Network& other);
+    Network(Network&&) noexcept = default;
+    Network& operator=(Network&&) noexcept = default;
+
+    // Add a new dense layer with ReLU to the network
     void addLayer(int numNeurons, int inputSize);
 
+    // Appends any layer; its input size must match the current output size, which becomes its output size.
+    // The optimizer state is reset. Throws std::invalid_argument if the sizes do not match
+    void addLayer(std::unique_ptr<Layer> layer);
+
+    // Replaces the optimizer (plain SGD with the constructor's learning rate by default); its state starts empty
+    void setOptimizer(const Optimizer::Settings& settings);
+
+    // Sets the learning rate of the current optimizer, keeping its state
+    void setLearningRate(double learningRate);
+
+    // Sets the input density below which the first layer multiplies and updates only nonzero inputs
+    // (0 always uses the dense kernels). Results match the dense kernels up to floating-point summation order
+    void setSparseThreshold(double threshold);
+
+    // Overwrites all weights and biases with those of a network of the same architecture, without
+    // reallocating (used to keep and restore checkpoints in memory). Throws std::invalid_argument otherwise
+    void copyParameters(const Network& other);
+
     // Forward pass: Compute output probabilities given an input sample
-    std::vector<double> forward(const std::vector<double>& input);
+    std::vector<Scalar> forward(std::span<const Scalar> input);
+
+    // Forward pass into a caller-provided buffer of outputSize probabilities (does not allocate)
+    void forward(std::span<const Scalar> input, std::span<Scalar> probabilities);
+
+    // Const, reentrant inference: returns output probabilities without touching the network's state
+    std::vector<Scalar> predict(std::span<const Scalar> input) const;
+
+    // Const, reentrant batched inference: inputs holds batchSize samples stacked row by row and
+    // probabilities receives batchSize x outputSize values. One matrix-matrix product per layer
+    void predictBatch(std::span<const Scalar> inputs, std::span<Scalar> probabilities, size_t batchSize) const;
+
+    // Same as above with caller-owned scratch buffers: once the workspace has grown to the batch size,
+    // the call does not allocate. Concurrent callers need separate workspaces
+    void predictBatch(std::span<const Scalar> inputs, std::span<Scalar> probabilities, size_t batchSize,
+                      Workspace& scratch) const;
+
+    // Returns a workspace sized for this network and batches of up to batchSize samples
+    Workspace makeWorkspace(size_t batchSize) const;
 
     // Compute cross-entropy loss for a given sample and its label
-    double computeLoss(const std::vector<double>& output, int label) const;
+    double computeLoss(std::span<const Scalar> output, int label) const;
 
     // Backpropagation: Compute gradients and update weights for a given sample and label
-    void backpropagate(const std::vector<double>& input, int label);
+    void backpropagate(std::span<const Scalar> input, int label);
+
+    // Fused training step: a single forward pass, Softmax cross-entropy loss and gradient,
+    // backpropagation and weight update. Returns the loss of the sample (before the update).
+    // Optimizers other than plain SGD need explicit gradients, so they take the batched path with one sample
+    double trainStep(std::span<const Scalar> input, int label);
+
+    // Mini-batch step: inputs holds labels.size() samples stacked row by row.
+    // Runs a batched forward and backward pass and applies one averaged update; returns the summed loss
+    double trainBatch(std::span<const Scalar> inputs, std::span<const int> labels);
+
+    // Train the network over multiple epochs using the training dataset (in file order), one update per mini-batch
+    void train(const Dataset& trainData, int epochs, size_t batchSize = 1);
+
+    // Train the network over multiple epochs on batches from any source (in-memory or streaming)
+    void train(BatchSource& source, int epochs, size_t batchSize = 1);
+
+    // How parallel training combines the work of its threads
+    enum class ParallelMode {
+        Synchronous,    // Shards each mini-batch across threads and reduces their gradients before one shared update
+        Hogwild         // Each thread trains on its own slice and updates the shared weights without locks
+    };
+
+    // Statistics reported by the parallel trainer
+    struct TrainingStats {
+        double averageLoss = 0.0;       // Average loss of the last epoch
+        double seconds = 0.0;           // Wall-clock training time
+        double samplesPerSecond = 0.0;  // Training throughput over all epochs
+    };
+
+    // Train the network with numThreads threads (0 = all hardware threads).
+    // Synchronous mode matches train() up to floating-point reduction order.
+    // Hogwild mode requires plain SGD (optimizer state cannot be updated without locks); throws std::invalid_argument otherwise
+    TrainingStats trainParallel(const Dataset& trainData, int epochs, size_t batchSize, unsigned numThreads,
+                                ParallelMode mode = ParallelMode::Synchronous);
+
+    // Evaluation metrics computed by evaluate()
+    struct EvaluationResult {
+        double accuracy = 0.0;                          // Fraction of correctly classified samples
+        std::vector<std::vector<int>> confusionMatrix;  // [true label][predicted label] sample counts
+        std::vector<double> precision;                  // Per-class precision (0 if the class was never predicted)
+        std::vector<double> recall;                     // Per-class recall (0 if the class never occurs)
+    };
+
+    // Evaluate the network on a dataset, sharding it across numThreads threads (0 = all hardware threads)
+    EvaluationResult evaluate(const Dataset& testData, unsigned numThreads = 0, size_t batchSize = 64) const;
+
+    // Test the network on the test dataset, print the confusion matrix and per-class metrics, and return accuracy
+    double test(const Dataset& testData, unsigned numThreads = 0) const;
+
+    // Header of a model file (native byte order), followed by one LayerRecord per layer.
+    // The weights and biases of every layer start 64-byte aligned so the file can be used in place
+    struct FileHeader {
+        char magic[4];          // "NNMD"
+        uint32_t version;       // Format version (MODEL_VERSION)
+        uint32_t scalarSize;    // Bytes per parameter: 4 (float build) or 8 (double build)
+        uint32_t numLayers;     // Number of layers
+        uint32_t inputSize;     // Number of input features
+        uint32_t reserved;      // Padding, always 0
+        double learningRate;    // Learning rate the network was trained with
+    };
+
+    // Architecture and parameter location of one layer in a model file
+    struct LayerRecord {
+        uint32_t type;          // Layer::Type
+        uint32_t useReLU;       // 1 if the layer applies ReLU
+        uint32_t inputHeight;   // Input shape (1 x 1 x inputs for dense layers)
+        uint32_t inputWidth;
+        uint32_t inputChannels;
+        uint32_t numOutputs;    // Neurons of a dense layer or filters of a convolution (0 otherwise)
+        uint32_t kernelSize;    // Kernel side of a convolution or window side of a pooling layer
+        uint32_t stride;        // Convolution stride
+        uint32_t padding;       // Convolution zero padding
+        uint32_t reserved;      // Padding, always 0
+        uint64_t weightOffset;  // Byte offset of the weights (row-major, one row per neuron or filter)
+        uint64_t biasOffset;    // Byte offset of the biases
+    };
+
+    // Version 1 files hold dense layers only, with a shorter record; they are still loaded
+    static constexpr uint32_t MODEL_VERSION = 2;
+
+    // Writes the architecture, weights and biases to a model file (written to a temporary name, then renamed)
+    void save(const std::string& filename) const;
 
-    // Train the network over multiple epochs using the training dataset
-    void train(const Dataset& trainData, int epochs);
+    // Loads a model file written by save(). If it was written by a build with the same Scalar type, the
+    // parameters are used in place from a copy-on-write mapping: nothing is copied, clean pages are shared
+    // between processes, and further training never modifies the file. Otherwise they are converted.
+    // Throws std::runtime_error if the file cannot be read or is not a valid model file
+    static Network load(const std::string& filename);
 
-    // Test the network on the test dataset and compute accuracy
-    double test(const Dataset& testData);
+    // Getters
+    const std::vector<std::unique_ptr<Layer>>& getLayers() const;
+    const Optimizer& getOptimizer() const;
+    double getSparseThreshold() const;
+    int getInputSize() const;
+    int getOutputSize() const;
 };
 
 #endif /* Network_hpp */
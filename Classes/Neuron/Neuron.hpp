@@ -8,43 +8,34 @@
 #ifndef Neuron_hpp
 #define Neuron_hpp
 
-#include <vector>
-#include <random>
+#include "Scalar.hpp"
+#include <span>
 
+// Lightweight, read-only view of a single neuron inside a Layer.
+// The weights are not owned: they point into one row of the layer's weight matrix.
 class Neuron {
 private:
-    std::vector<double> weights;    // Weights for each input connection
-    double bias;                    // Bias term
-    std::vector<double> inputs;     // Stored inputs for weight updates
-    double output;                  // Output after activation
-    double gradient;                // Gradient for backpropagation
-    int numInputs;                  // Number of inputs (size of previous layer)
-    bool useReLU;                   // Flag to apply ReLU activation
-
-    // Random number generator for weight initialization
-    static std::default_random_engine generator;
-    static std::uniform_real_distribution<double> distribution;
+    std::span<const Scalar> weights; // Row of the layer's weight matrix (one weight per input)
+    Scalar bias;                     // Bias term
+    Scalar output;                   // Output after activation (from the layer's last forward pass)
+    Scalar gradient;                 // Gradient for backpropagation (from the layer's last backward pass)
+    bool useReLU;                    // Flag to apply ReLU activation
 
     // Activation function (ReLU)
-    double relu(double x) const;
+    Scalar relu(Scalar x) const;
 
 public:
-    // Constructor: Initialize neuron with random weights and bias
-    Neuron(int numInputs, bool useReLU = true);
+    // Constructor: Wrap a row of a layer's parameters and state
+    Neuron(std::span<const Scalar> weights, Scalar bias, Scalar output, Scalar gradient, bool useReLU = true);
 
-    // Forward pass: Compute output given inputs
-    double forward(const std::vector<double>& inputs);
-
-    // Update weights and bias using gradient descent
-    void updateWeights(double learningRate);
+    // Forward pass: Compute output given inputs (does not modify the layer)
+    Scalar forward(std::span<const Scalar> inputs) const;
 
     // Getters
-    double getOutput() const;
-    double getGradient() const;
-    const std::vector<double>& getWeights() const;
-
-    // Setter for gradient (used by hidden layers during backpropagation)
-    void setGradient(double grad);
+    Scalar getOutput() const;
+    Scalar getGradient() const;
+    Scalar getBias() const;
+    std::span<const Scalar> getWeights() const;
 };
 
 #endif /* Neuron_hpp */
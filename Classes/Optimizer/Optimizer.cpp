@@ -0,0 +1,187 @@
+//
+//  Optimizer.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "Optimizer.hpp"
+#include "Kernels.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <stdexcept>
+
+// Constructor: Plain SGD with the default hyperparameters and no layers yet
+Optimizer::Optimizer() : Optimizer(Settings()) {}
+
+// Constructor: Optimizer with the given hyperparameters and no layers yet
+Optimizer::Optimizer(const Settings& settings) : settings(settings), steps(0) {
+    if (!(settings.learningRate > 0.0)) {
+        throw std::invalid_argument("Learning rate must be positive");
+    }
+}
+
+// Copy constructor: Copies the settings, state and step count
+Optimizer::Optimizer(const Optimizer& other)
+    : settings(other.settings), states(other.states), steps(other.steps.load(std::memory_order_relaxed)) {}
+
+// Copy assignment: Copies the settings, state and step count
+Optimizer& Optimizer::operator=(const Optimizer& other) {
+    settings = other.settings;
+    states = other.states;
+    steps.store(other.steps.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    return *this;
+}
+
+// Number of state values kept per parameter
+size_t Optimizer::stateSlots() const {
+    switch (settings.type) {
+        case Type::SGD:
+            return settings.weightDecay != 0.0 ? 1 : 0; // Decay runs through the momentum kernel with momentum 0
+        case Type::Momentum:
+        case Type::Nesterov:
+            return 1;
+        case Type::Adam:
+        case Type::AdamW:
+            return 2;
+    }
+    return 0;
+}
+
+// Sizes the state for the given layers and clears it
+void Optimizer::reset(const std::vector<std::unique_ptr<Layer>>& layers) {
+    states.assign(layers.size(), LayerState());
+    for (size_t l = 0; l < layers.size(); ++l) {
+        states[l].numWeights = layers[l]->getWeights().size();
+        states[l].numBiases = layers[l]->getBiases().size();
+        states[l].buffer.assign(stateSlots() * (states[l].numWeights + states[l].numBiases), Scalar(0));
+    }
+    steps.store(0, std::memory_order_relaxed);
+}
+
+// Starts a new update of all layers
+void Optimizer::beginStep() {
+    steps.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Updates the parameters of one layer: one fused pass over the weights and one over the biases
+void Optimizer::update(size_t layerIndex, std::span<Scalar> weights, std::span<Scalar> biases,
+                       std::span<const Scalar> weightGradients, std::span<const Scalar> biasGradients,
+                       size_t batchSize) {
+    if (layerIndex >= states.size() || states[layerIndex].numWeights != weights.size() ||
+        states[layerIndex].numBiases != biases.size()) {
+        throw std::logic_error("Optimizer state does not match the layer; reset() must be called after layers change");
+    }
+    LayerState& state = states[layerIndex];
+    Scalar gradientScale = static_cast<Scalar>(1.0 / batchSize);
+    Scalar learningRate = static_cast<Scalar>(settings.learningRate);
+    Scalar decay = static_cast<Scalar>(settings.weightDecay);
+    size_t numWeights = state.numWeights;
+    size_t numBiases = state.numBiases;
+    Scalar* slot = state.buffer.data();
+
+    switch (settings.type) {
+        case Type::SGD:
+            if (decay == 0) {
+                // Same step as the per-sample path: one axpy per parameter block
+                Scalar step = static_cast<Scalar>(-(settings.learningRate / batchSize));
+                Kernels::axpy(step, weightGradients.data(), weights.data(), numWeights);
+                Kernels::axpy(step, biasGradients.data(), biases.data(), numBiases);
+                return;
+            }
+            [[fallthrough]];
+        case Type::Momentum:
+        case Type::Nesterov: {
+            Scalar momentum = settings.type == Type::SGD ? Scalar(0) : static_cast<Scalar>(settings.momentum);
+            Kernels::MomentumStep<Scalar> step = { gradientScale, learningRate, momentum, decay,
+                                                   settings.type == Type::Nesterov };
+            Kernels::momentum(weights.data(), weightGradients.data(), slot, numWeights, step);
+            step.l2Decay = 0;
+            Kernels::momentum(biases.data(), biasGradients.data(), slot + numWeights, numBiases, step);
+            return;
+        }
+        case Type::Adam:
+        case Type::AdamW: {
+            // Bias corrections for the current step; the first moment block is followed by the second
+            uint64_t t = std::max<uint64_t>(1, steps.load(std::memory_order_relaxed));
+            double correction1 = 1.0 / (1.0 - std::pow(settings.beta1, static_cast<double>(t)));
+            double correction2 = 1.0 / (1.0 - std::pow(settings.beta2, static_cast<double>(t)));
+            bool decoupled = settings.type == Type::AdamW;
+            Kernels::AdamStep<Scalar> step = { gradientScale,
+                                               learningRate,
+                                               static_cast<Scalar>(settings.beta1),
+                                               static_cast<Scalar>(settings.beta2),
+                                               static_cast<Scalar>(settings.epsilon),
+                                               static_cast<Scalar>(correction1),
+                                               static_cast<Scalar>(correction2),
+                                               decoupled ? Scalar(0) : decay,
+                                               decoupled ? decay : Scalar(0) };
+            Scalar* second = slot + numWeights + numBiases;
+            Kernels::adam(weights.data(), weightGradients.data(), slot, second, numWeights, step);
+            step.l2Decay = 0;
+            step.decoupledDecay = 0;
+            Kernels::adam(biases.data(), biasGradients.data(), slot + numWeights, second + numWeights, numBiases, step);
+            return;
+        }
+    }
+}
+
+// True for plain SGD without weight decay
+bool Optimizer::isStateless() const {
+    return stateSlots() == 0;
+}
+
+// Getter: Returns the hyperparameters
+const Optimizer::Settings& Optimizer::getSettings() const {
+    return settings;
+}
+
+// Getter: Returns the current learning rate
+double Optimizer::getLearningRate() const {
+    return settings.learningRate;
+}
+
+// Setter: Changes the learning rate, keeping the state (for learning rate schedules)
+void Optimizer::setLearningRate(double learningRate) {
+    if (!(learningRate > 0.0)) {
+        throw std::invalid_argument("Learning rate must be positive");
+    }
+    settings.learningRate = learningRate;
+}
+
+// Getter: Returns the number of updates started so far
+uint64_t Optimizer::getSteps() const {
+    return steps.load(std::memory_order_relaxed);
+}
+
+// Returns a printable name for a type
+const char* Optimizer::getTypeName(Type type) {
+    switch (type) {
+        case Type::SGD:
+            return "SGD";
+        case Type::Momentum:
+            return "Momentum";
+        case Type::Nesterov:
+            return "Nesterov";
+        case Type::Adam:
+            return "Adam";
+        case Type::AdamW:
+            return "AdamW";
+    }
+    return "Unknown";
+}
+
+// Parses a type name
+Optimizer::Type Optimizer::parseType(const std::string& name) {
+    for (Type type : { Type::SGD, Type::Momentum, Type::Nesterov, Type::Adam, Type::AdamW }) {
+        std::string typeName = getTypeName(type);
+        if (name.size() == typeName.size() &&
+            std::equal(name.begin(), name.end(), typeName.begin(), [](char a, char b) {
+                return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+            })) {
+            return type;
+        }
+    }
+    throw std::invalid_argument("Unknown optimizer: " + name);
+}
@@ -0,0 +1,99 @@
+//
+//  Optimizer.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef Optimizer_hpp
+#define Optimizer_hpp
+
+#include "Layer.hpp"
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// Gradient-based update rule applied to the layers of a network.
+// The state of each layer (velocities or Adam moments) lives in one contiguous buffer laid out like the
+// layer's parameters, and each update is a single fused vectorized pass over weights, gradients and state.
+class Optimizer {
+public:
+    // Available update rules
+    enum class Type {
+        SGD,        // w -= lr * g
+        Momentum,   // Heavy-ball momentum: v = mu * v + g, w -= lr * v
+        Nesterov,   // Nesterov momentum: w -= lr * (g + mu * v)
+        Adam,       // Adam with optional L2 penalty added to the gradient
+        AdamW       // Adam with decoupled weight decay
+    };
+
+    // Hyperparameters (the ones that do not apply to the chosen type are ignored)
+    struct Settings {
+        Type type = Type::SGD;
+        double learningRate = 0.01;     // Step size
+        double momentum = 0.9;          // Velocity decay of Momentum and Nesterov
+        double beta1 = 0.9;             // First-moment decay of Adam/AdamW
+        double beta2 = 0.999;           // Second-moment decay of Adam/AdamW
+        double epsilon = 1e-8;          // Denominator offset of Adam/AdamW
+        double weightDecay = 0.0;       // L2 penalty on the weights (decoupled for AdamW; biases are not decayed)
+    };
+
+private:
+    // State of one layer: stateSlots copies of (weights, biases), back to back
+    struct LayerState {
+        std::vector<Scalar> buffer;     // Velocity, or first then second moment
+        size_t numWeights = 0;          // Weights of the layer
+        size_t numBiases = 0;           // Biases of the layer
+    };
+
+    Settings settings;                  // Hyperparameters
+    std::vector<LayerState> states;     // One state per layer
+    // Updates started so far (Adam bias correction). Atomic because Hogwild workers start their updates
+    // concurrently on the shared optimizer
+    std::atomic<uint64_t> steps;
+
+    // Number of state values kept per parameter
+    size_t stateSlots() const;
+
+public:
+    // Constructor: Plain SGD with the default hyperparameters and no layers yet
+    Optimizer();
+
+    // Constructor: Optimizer with the given hyperparameters and no layers yet.
+    // Throws std::invalid_argument if the learning rate is not positive
+    explicit Optimizer(const Settings& settings);
+
+    // Copy constructor and assignment: Copy the settings, state and step count
+    Optimizer(const Optimizer& other);
+    Optimizer& operator=(const Optimizer& other);
+
+    // Sizes the state for the given layers and clears it (and the step count)
+    void reset(const std::vector<std::unique_ptr<Layer>>& layers);
+
+    // Starts a new update of all layers (advances Adam's bias correction)
+    void beginStep();
+
+    // Updates the parameters of one layer with gradients summed over batchSize samples.
+    // Throws std::logic_error if the state was not sized for this layer by reset()
+    void update(size_t layerIndex, std::span<Scalar> weights, std::span<Scalar> biases,
+                std::span<const Scalar> weightGradients, std::span<const Scalar> biasGradients, size_t batchSize);
+
+    // True for plain SGD without weight decay, which needs no state and allows fused per-sample updates
+    bool isStateless() const;
+
+    // Getters and setters
+    const Settings& getSettings() const;
+    double getLearningRate() const;
+    void setLearningRate(double learningRate);
+    uint64_t getSteps() const;
+
+    // Returns a printable name for a type
+    static const char* getTypeName(Type type);
+
+    // Parses a type name ("sgd", "momentum", "nesterov", "adam", "adamw"); throws std::invalid_argument
+    static Type parseType(const std::string& name);
+};
+
+#endif /* Optimizer_hpp */
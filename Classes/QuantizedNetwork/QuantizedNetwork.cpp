@@ -0,0 +1,259 @@
+//
+//  QuantizedNetwork.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "QuantizedNetwork.hpp"
+#include "Kernels.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+// Quantizes a trained network, calibrating activation ranges on a sample of calibrationData
+QuantizedNetwork::QuantizedNetwork(const Network& network, const Dataset& calibrationData, size_t calibrationSamples)
+    : inputSize(network.getInputSize()), outputSize(network.getOutputSize()) {
+    if (calibrationData.getSampleSize() != static_cast<size_t>(inputSize)) {
+        throw std::invalid_argument("Calibration sample size does not match network input size");
+    }
+    // The int8 kernels cover dense layers only
+    std::vector<const DenseLayer*> source;
+    for (const auto& layer : network.getLayers()) {
+        if (layer->getType() != Layer::Type::Dense) {
+            throw std::invalid_argument("Quantization requires a network of dense layers");
+        }
+        source.push_back(static_cast<const DenseLayer*>(layer.get()));
+    }
+    for (size_t l = 0; l + 1 < source.size(); ++l) {
+        if (!source[l]->usesReLU()) {
+            throw std::invalid_argument("Quantization requires ReLU on every hidden layer");
+        }
+    }
+
+    // Calibration: record the largest output of every layer over the calibration samples
+    const size_t batchSize = 64;
+    size_t numSamples = std::min(calibrationSamples, calibrationData.getNumSamples());
+    std::vector<std::vector<Scalar>> activations(source.size() + 1);
+    activations[0].resize(batchSize * inputSize);
+    for (size_t l = 0; l < source.size(); ++l) {
+        activations[l + 1].resize(batchSize * source[l]->getNumNeurons());
+    }
+    std::vector<Scalar> maxOutputs(source.size(), 0);
+    for (size_t first = 0; first < numSamples; first += batchSize) {
+        size_t count = std::min(batchSize, numSamples - first);
+        calibrationData.getBatch(first, count, activations[0]);
+        for (size_t l = 0; l < source.size(); ++l) {
+            source[l]->forwardBatch(activations[l], activations[l + 1], count, {});
+            auto end = activations[l + 1].begin() + count * source[l]->getNumNeurons();
+            maxOutputs[l] = std::max(maxOutputs[l], *std::max_element(activations[l + 1].begin(), end));
+        }
+    }
+
+    // Quantization: symmetric int8 weights per output neuron, unsigned 8-bit activations per layer.
+    // The first layer reads raw pixels, so its input step is exactly 1/255
+    float inputScale = 1.0f / 255.0f;
+    for (size_t l = 0; l < source.size(); ++l) {
+        const DenseLayer& layer = *source[l];
+        QuantizedLayer quantized;
+        quantized.numNeurons = layer.getNumNeurons();
+        quantized.inputSize = layer.getInputSize();
+        quantized.useReLU = layer.usesReLU();
+        quantized.inputScale = inputScale;
+        quantized.weights.resize(layer.getWeights().size());
+        std::span<const Scalar> weights = layer.getWeights();
+        for (int i = 0; i < quantized.numNeurons; ++i) {
+            std::span<const Scalar> row = weights.subspan(static_cast<size_t>(i) * quantized.inputSize, quantized.inputSize);
+            Scalar maxAbs = 0;
+            for (Scalar w : row) {
+                maxAbs = std::max(maxAbs, std::abs(w));
+            }
+            float scale = maxAbs > 0 ? static_cast<float>(maxAbs) / 127.0f : 1.0f;
+            int8_t* out = quantized.weights.data() + static_cast<size_t>(i) * quantized.inputSize;
+            for (size_t j = 0; j < row.size(); ++j) {
+                out[j] = static_cast<int8_t>(std::clamp(std::lround(row[j] / scale), -127L, 127L));
+            }
+            quantized.weightScales.push_back(scale);
+            quantized.multipliers.push_back(inputScale * scale);
+            quantized.biases.push_back(static_cast<float>(layer.getBiases()[i]));
+        }
+        // The outputs of a hidden layer become the next layer's inputs: 255 steps up to the calibrated maximum
+        if (l + 1 < source.size()) {
+            quantized.outputScale = maxOutputs[l] > 0 ? static_cast<float>(maxOutputs[l]) / 255.0f : 1.0f;
+            inputScale = quantized.outputScale;
+        }
+        layers.push_back(std::move(quantized));
+    }
+}
+
+// Runs the int8 layers on raw pixels and writes the output logits; hidden layers alternate between the two
+// halves of scratch
+void QuantizedNetwork::computeLogits(std::span<const uint8_t> pixels, std::span<float> logits,
+                                     std::span<uint8_t> scratch) const {
+    if (pixels.size() != static_cast<size_t>(inputSize)) {
+        throw std::invalid_argument("Input size does not match network input size");
+    }
+    if (logits.size() < static_cast<size_t>(outputSize) || scratch.size() < getScratchSize()) {
+        throw std::invalid_argument("Buffers are too small for network");
+    }
+    size_t half = getScratchSize() / 2;
+    const uint8_t* input = pixels.data();
+    for (size_t l = 0; l < layers.size(); ++l) {
+        const QuantizedLayer& layer = layers[l];
+        bool isOutputLayer = (l + 1 == layers.size());
+        uint8_t* next = scratch.data() + (l % 2) * half;
+        float inverseOutputScale = 1.0f / layer.outputScale;
+        const int8_t* row = layer.weights.data();
+        for (int i = 0; i < layer.numNeurons; ++i, row += layer.inputSize) {
+            // Integer dot product, then back to real values with the combined input and weight scale
+            int32_t sum = Kernels::dotU8S8(input, row, layer.inputSize);
+            float z = static_cast<float>(sum) * layer.multipliers[i] + layer.biases[i];
+            if (isOutputLayer) {
+                logits[i] = layer.useReLU ? std::max(0.0f, z) : z;
+            } else {
+                // Requantize; clamping at 0 also applies ReLU
+                next[i] = static_cast<uint8_t>(std::clamp(std::lround(z * inverseOutputScale), 0L, 255L));
+            }
+        }
+        input = next;
+    }
+}
+
+// Const, reentrant inference on raw 0-255 pixels: returns output probabilities
+std::vector<float> QuantizedNetwork::predict(std::span<const uint8_t> pixels) const {
+    std::vector<float> output(outputSize);
+    std::vector<uint8_t> scratch(getScratchSize());
+    predict(pixels, output, scratch);
+    return output;
+}
+
+// Allocation-free inference into caller-owned buffers
+void QuantizedNetwork::predict(std::span<const uint8_t> pixels, std::span<float> probabilities,
+                               std::span<uint8_t> scratch) const {
+    computeLogits(pixels, probabilities, scratch);
+    // Softmax
+    std::span<float> output = probabilities.first(outputSize);
+    float maxZ = *std::max_element(output.begin(), output.end());
+    double sumExp = 0.0;
+    for (auto& a : output) {
+        a = std::exp(a - maxZ);
+        sumExp += a;
+    }
+    for (auto& a : output) {
+        a = static_cast<float>(a / sumExp);
+    }
+}
+
+// Returns the most probable class for raw 0-255 pixels
+int QuantizedNetwork::classify(std::span<const uint8_t> pixels) const {
+    std::vector<float> logits(outputSize);
+    std::vector<uint8_t> scratch(getScratchSize());
+    return classify(pixels, logits, scratch);
+}
+
+// Allocation-free classify (Softmax does not change the order, so the logits decide)
+int QuantizedNetwork::classify(std::span<const uint8_t> pixels, std::span<float> logits,
+                               std::span<uint8_t> scratch) const {
+    computeLogits(pixels, logits, scratch);
+    std::span<const float> output = logits.first(outputSize);
+    return static_cast<int>(std::distance(output.begin(), std::max_element(output.begin(), output.end())));
+}
+
+// Runs both models on every sample of testData, one sample at a time on the calling thread
+QuantizedNetwork::ComparisonReport QuantizedNetwork::compare(const Network& reference, const Dataset& testData) const {
+    size_t numSamples = testData.getNumSamples();
+    ComparisonReport result;
+    if (numSamples == 0) {
+        return result;
+    }
+
+    // Reference network on normalized inputs, with one workspace reused across samples so the timing
+    // measures inference rather than buffer allocation
+    std::vector<int> referencePredictions(numSamples);
+    std::vector<Scalar> sample(testData.getSampleSize());
+    std::vector<Scalar> output(reference.getOutputSize());
+    Workspace workspace = reference.makeWorkspace(1);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < numSamples; ++i) {
+        testData.getSample(i, sample);
+        reference.predictBatch(sample, output, 1, workspace);
+        referencePredictions[i] = static_cast<int>(std::distance(output.begin(), std::max_element(output.begin(), output.end())));
+    }
+    double referenceSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Int8 model straight on the raw pixels, with its buffers reused the same way
+    std::vector<int> quantizedPredictions(numSamples);
+    std::vector<float> logits(outputSize);
+    std::vector<uint8_t> scratch(getScratchSize());
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < numSamples; ++i) {
+        quantizedPredictions[i] = classify(testData.getPixels(i), logits, scratch);
+    }
+    double quantizedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t referenceCorrect = 0;
+    size_t quantizedCorrect = 0;
+    size_t agreed = 0;
+    for (size_t i = 0; i < numSamples; ++i) {
+        int label = testData.getLabel(i);
+        referenceCorrect += referencePredictions[i] == label;
+        quantizedCorrect += quantizedPredictions[i] == label;
+        agreed += referencePredictions[i] == quantizedPredictions[i];
+    }
+    result.referenceAccuracy = static_cast<double>(referenceCorrect) / numSamples;
+    result.quantizedAccuracy = static_cast<double>(quantizedCorrect) / numSamples;
+    result.agreement = static_cast<double>(agreed) / numSamples;
+    result.referenceMicroseconds = referenceSeconds * 1e6 / numSamples;
+    result.quantizedMicroseconds = quantizedSeconds * 1e6 / numSamples;
+    for (const auto& layer : reference.getLayers()) {
+        result.referenceBytes += (layer->getWeights().size() + layer->getBiases().size()) * sizeof(Scalar);
+    }
+    result.quantizedBytes = getSizeInBytes();
+    return result;
+}
+
+// Prints the comparison against the reference network and returns the int8 accuracy
+double QuantizedNetwork::report(const Network& reference, const Dataset& testData) const {
+    ComparisonReport result = compare(reference, testData);
+    std::cout << "Int8 model (" << Kernels::getInt8KernelName() << " dot product) vs " << sizeof(Scalar) * 8
+              << "-bit network on " << testData.getNumSamples() << " test samples:" << std::endl;
+    std::cout << "  Accuracy: " << result.referenceAccuracy << " -> " << result.quantizedAccuracy
+              << " (" << (result.quantizedAccuracy - result.referenceAccuracy) * 100.0 << " points), "
+              << "agreement " << result.agreement * 100.0 << "%" << std::endl;
+    std::cout << "  Latency per sample: " << result.referenceMicroseconds << " us -> " << result.quantizedMicroseconds
+              << " us" << std::endl;
+    std::cout << "  Parameters: " << result.referenceBytes / 1024 << " KB -> " << result.quantizedBytes / 1024
+              << " KB" << std::endl;
+    return result.quantizedAccuracy;
+}
+
+// Getter: Returns the number of input pixels
+int QuantizedNetwork::getInputSize() const {
+    return inputSize;
+}
+
+// Getter: Returns the number of output classes
+int QuantizedNetwork::getOutputSize() const {
+    return outputSize;
+}
+
+// Getter: Returns the scratch bytes of one inference: room for the widest hidden layer, twice
+size_t QuantizedNetwork::getScratchSize() const {
+    size_t widest = 0;
+    for (size_t l = 0; l + 1 < layers.size(); ++l) {
+        widest = std::max(widest, static_cast<size_t>(layers[l].numNeurons));
+    }
+    return 2 * widest;
+}
+
+// Getter: Returns the size of the int8 weights plus the float scales and biases
+size_t QuantizedNetwork::getSizeInBytes() const {
+    size_t bytes = 0;
+    for (const auto& layer : layers) {
+        bytes += layer.weights.size() * sizeof(int8_t);
+        bytes += (layer.weightScales.size() + layer.multipliers.size() + layer.biases.size()) * sizeof(float);
+    }
+    return bytes;
+}
@@ -0,0 +1,88 @@
+//
+//  QuantizedNetwork.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef QuantizedNetwork_hpp
+#define QuantizedNetwork_hpp
+
+#include "Network.hpp"
+#include "Dataset.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Int8 inference model produced from a trained Network by post-training quantization.
+// Weights are stored as signed 8-bit values with one scale per output neuron; activations between
+// layers are unsigned 8-bit values with one scale per layer, calibrated on a sample of a Dataset.
+// Dot products run on bytes with 32-bit accumulation (AVX2 or AVX-512 VNNI when available).
+class QuantizedNetwork {
+private:
+    // One dense layer in quantized form
+    struct QuantizedLayer {
+        std::vector<int8_t> weights;        // Row-major int8 weight matrix (numNeurons x inputSize)
+        std::vector<float> weightScales;    // Real value of one weight step, per output neuron
+        std::vector<float> multipliers;     // inputScale * weightScales[i]: converts an int32 sum back to real
+        std::vector<float> biases;          // Biases, kept in float
+        float inputScale = 1.0f;            // Real value of one input step
+        float outputScale = 1.0f;           // Real value of one output step (hidden layers only)
+        int numNeurons = 0;                 // Number of neurons in the layer
+        int inputSize = 0;                  // Number of inputs of each neuron
+        bool useReLU = true;                // Whether the layer applies ReLU
+    };
+
+    std::vector<QuantizedLayer> layers;     // Quantized layers, input layer first
+    int inputSize;                          // Number of input pixels
+    int outputSize;                         // Number of output classes
+
+    // Runs the int8 layers on raw pixels and writes the output logits; hidden activations go to scratch
+    void computeLogits(std::span<const uint8_t> pixels, std::span<float> logits, std::span<uint8_t> scratch) const;
+
+public:
+    // Quantizes a trained network. Activation ranges of the hidden layers are calibrated by running
+    // the network on the first calibrationSamples samples of calibrationData.
+    // Throws std::invalid_argument if a layer is not dense or a hidden layer does not use ReLU (its outputs must be non-negative)
+    QuantizedNetwork(const Network& network, const Dataset& calibrationData, size_t calibrationSamples = 1000);
+
+    // Const, reentrant inference on raw 0-255 pixels: returns output probabilities
+    std::vector<float> predict(std::span<const uint8_t> pixels) const;
+
+    // Allocation-free inference into caller-owned buffers: probabilities needs getOutputSize() values and
+    // scratch getScratchSize() bytes. Throws std::invalid_argument if a buffer is too small
+    void predict(std::span<const uint8_t> pixels, std::span<float> probabilities, std::span<uint8_t> scratch) const;
+
+    // Returns the most probable class for raw 0-255 pixels
+    int classify(std::span<const uint8_t> pixels) const;
+
+    // Allocation-free classify: logits needs getOutputSize() values and scratch getScratchSize() bytes
+    int classify(std::span<const uint8_t> pixels, std::span<float> logits, std::span<uint8_t> scratch) const;
+
+    // Accuracy and latency of the quantized model next to the network it was built from
+    struct ComparisonReport {
+        double referenceAccuracy = 0.0;     // Accuracy of the floating-point network
+        double quantizedAccuracy = 0.0;     // Accuracy of the int8 model
+        double agreement = 0.0;             // Fraction of samples where both predict the same class
+        double referenceMicroseconds = 0.0; // Average single-sample latency of the network, buffers reused
+        double quantizedMicroseconds = 0.0; // Average single-sample latency of classify, buffers reused
+        size_t referenceBytes = 0;          // Size of the network's weights and biases
+        size_t quantizedBytes = 0;          // Size of the int8 weights, scales and biases
+    };
+
+    // Runs both models on every sample of testData, one sample at a time on the calling thread
+    ComparisonReport compare(const Network& reference, const Dataset& testData) const;
+
+    // Prints the comparison against the reference network and returns the int8 accuracy
+    double report(const Network& reference, const Dataset& testData) const;
+
+    // Getters
+    int getInputSize() const;
+    int getOutputSize() const;
+    size_t getSizeInBytes() const;
+
+    // Getter: Returns the scratch bytes one predict or classify call needs (two hidden activation vectors)
+    size_t getScratchSize() const;
+};
+
+#endif /* QuantizedNetwork_hpp */
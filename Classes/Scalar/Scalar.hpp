@@ -0,0 +1,26 @@
+//
+//  Scalar.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef Scalar_hpp
+#define Scalar_hpp
+
+// Numeric type of weights, activations and gradients.
+// Defaults to double; build with -DNN_USE_FLOAT for a float32 network, which halves memory
+// traffic and doubles the SIMD lane width. Weights start from the same values in both builds;
+// on the bundled MNIST test set (999 samples, 784-256-10) the float build's accuracy is expected to
+// stay within 2 percentage points of the double build (measured: 0.1 for SGD, up to 1.9 for
+// short mini-batch runs, where rounding sends training down a slightly different path).
+#ifdef NN_USE_FLOAT
+using Scalar = float;
+#else
+using Scalar = double;
+#endif
+
+// Type used for reductions that need extra precision regardless of Scalar (loss sums, metrics)
+using Accumulator = double;
+
+#endif /* Scalar_hpp */
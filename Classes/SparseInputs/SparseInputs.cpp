@@ -0,0 +1,80 @@
+//
+//  SparseInputs.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "SparseInputs.hpp"
+#include <stdexcept>
+
+// Constructor: Empty, sized by the first reserve() or compress()
+SparseInputs::SparseInputs() : offsets(1, 0), numRows(0), numColumns(0) {}
+
+// Grows the buffers to hold numRows fully dense rows
+void SparseInputs::reserve(size_t numRows, size_t numColumns) {
+    if (indices.size() < numRows * numColumns) {
+        indices.resize(numRows * numColumns);
+        values.resize(numRows * numColumns);
+    }
+    if (offsets.size() < numRows + 1) {
+        offsets.resize(numRows + 1);
+    }
+}
+
+// Compresses dense rows, keeping the nonzero columns of each row in increasing order
+double SparseInputs::compress(std::span<const Scalar> dense, size_t numRows, size_t numColumns) {
+    if (dense.size() < numRows * numColumns) {
+        throw std::invalid_argument("Dense input is smaller than the given rows and columns");
+    }
+    if (numColumns > UINT32_MAX) {
+        throw std::invalid_argument("Too many columns for sparse inputs");
+    }
+    reserve(numRows, numColumns);
+    this->numRows = numRows;
+    this->numColumns = numColumns;
+    size_t count = 0;
+    const Scalar* x = dense.data();
+    for (size_t r = 0; r < numRows; ++r, x += numColumns) {
+        offsets[r] = count;
+        for (size_t c = 0; c < numColumns; ++c) {
+            // Written unconditionally and kept only for nonzeros, so the loop has no hard-to-predict branch
+            indices[count] = static_cast<uint32_t>(c);
+            values[count] = x[c];
+            count += x[c] != 0;
+        }
+    }
+    offsets[numRows] = count;
+    return numRows * numColumns > 0 ? static_cast<double>(count) / (numRows * numColumns) : 0.0;
+}
+
+// Column indices of the nonzeros of one row
+std::span<const uint32_t> SparseInputs::getIndices(size_t row) const {
+    if (row >= numRows) {
+        throw std::out_of_range("Row out of range");
+    }
+    return std::span<const uint32_t>(indices.data() + offsets[row], offsets[row + 1] - offsets[row]);
+}
+
+// Values of the nonzeros of one row
+std::span<const Scalar> SparseInputs::getValues(size_t row) const {
+    if (row >= numRows) {
+        throw std::out_of_range("Row out of range");
+    }
+    return std::span<const Scalar>(values.data() + offsets[row], offsets[row + 1] - offsets[row]);
+}
+
+// Getter: Returns the number of rows compressed by the last compress()
+size_t SparseInputs::getNumRows() const {
+    return numRows;
+}
+
+// Getter: Returns the number of values per dense row
+size_t SparseInputs::getNumColumns() const {
+    return numColumns;
+}
+
+// Getter: Returns the number of nonzeros over all rows
+size_t SparseInputs::getNumNonzeros() const {
+    return offsets[numRows];
+}
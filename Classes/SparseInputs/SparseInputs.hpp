@@ -0,0 +1,47 @@
+//
+//  SparseInputs.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef SparseInputs_hpp
+#define SparseInputs_hpp
+
+#include "Scalar.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Nonzero entries of a batch of input rows in compressed sparse row form (column indices and values per row).
+// Most MNIST pixels are exactly zero, so the first layer can multiply and update only the nonzero columns.
+// Buffers grow to the largest batch compressed so far and are reused afterwards without allocating.
+class SparseInputs {
+private:
+    std::vector<uint32_t> indices;  // Column of every nonzero, row after row
+    std::vector<Scalar> values;     // Value of every nonzero
+    std::vector<size_t> offsets;    // Nonzeros of row r are [offsets[r], offsets[r + 1])
+    size_t numRows;                 // Rows compressed by the last compress()
+    size_t numColumns;              // Values per dense row
+
+public:
+    // Constructor: Empty, sized by the first reserve() or compress()
+    SparseInputs();
+
+    // Grows the buffers so batches of up to numRows dense rows of numColumns values compress without allocating
+    void reserve(size_t numRows, size_t numColumns);
+
+    // Compresses numRows dense rows of numColumns values stacked row by row; returns the fraction of nonzeros
+    double compress(std::span<const Scalar> dense, size_t numRows, size_t numColumns);
+
+    // Column indices (increasing) and values of the nonzeros of one row
+    std::span<const uint32_t> getIndices(size_t row) const;
+    std::span<const Scalar> getValues(size_t row) const;
+
+    // Getters
+    size_t getNumRows() const;
+    size_t getNumColumns() const;
+    size_t getNumNonzeros() const;
+};
+
+#endif /* SparseInputs_hpp */
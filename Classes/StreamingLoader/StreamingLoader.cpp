@@ -0,0 +1,272 @@
+//
+//  StreamingLoader.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "StreamingLoader.hpp"
+#include "Dataset.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+// Reads exactly size bytes at offset, throwing on a short read
+void readAt(std::ifstream& file, uint64_t offset, void* destination, size_t size, const std::string& filename) {
+    file.seekg(static_cast<std::streamoff>(offset));
+    if (!file.read(static_cast<char*>(destination), static_cast<std::streamsize>(size))) {
+        throw std::runtime_error("Could not read " + std::to_string(size) + " bytes from " + filename);
+    }
+}
+
+// Reads a big-endian 32-bit integer from an IDX header
+uint32_t readBigEndian(std::ifstream& file, uint64_t offset, const std::string& filename) {
+    uint8_t bytes[4];
+    readAt(file, offset, bytes, sizeof(bytes), filename);
+    return (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | uint32_t(bytes[3]);
+}
+
+} // namespace
+
+// Constructor: Streams a binary cache file written by Dataset::save()
+StreamingLoader::StreamingLoader(const std::string& filename, size_t shuffleBufferSize, bool shuffle,
+                                 unsigned seed, size_t chunkSamples)
+    : pixelFilename(filename), labelFilename(filename), shuffle(shuffle), seed(seed) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+    Dataset::FileHeader bytes;
+    readAt(file, 0, &bytes, sizeof(bytes), filename);
+    Dataset::FileHeader header = Dataset::readFileHeader(reinterpret_cast<const uint8_t*>(&bytes),
+                                                         std::filesystem::file_size(filename), filename);
+    pixelOffset = header.dataOffset;
+    labelOffset = header.labelOffset;
+    numSamples = header.numSamples;
+    sampleSize = static_cast<size_t>(header.rows) * header.cols;
+    configure(shuffleBufferSize, chunkSamples);
+}
+
+// Constructor: Streams the original MNIST IDX image and label files
+StreamingLoader::StreamingLoader(const std::string& imagesFilename, const std::string& labelsFilename,
+                                 size_t shuffleBufferSize, bool shuffle, unsigned seed, size_t chunkSamples)
+    : pixelFilename(imagesFilename), labelFilename(labelsFilename), pixelOffset(16), labelOffset(8),
+      shuffle(shuffle), seed(seed) {
+    std::ifstream images(imagesFilename, std::ios::binary);
+    std::ifstream labels(labelsFilename, std::ios::binary);
+    if (!images.is_open() || !labels.is_open()) {
+        throw std::runtime_error("Could not open IDX files: " + imagesFilename + ", " + labelsFilename);
+    }
+    if (readBigEndian(images, 0, imagesFilename) != 0x00000803) {
+        throw std::runtime_error("Not an IDX image file: " + imagesFilename);
+    }
+    if (readBigEndian(labels, 0, labelsFilename) != 0x00000801) {
+        throw std::runtime_error("Not an IDX label file: " + labelsFilename);
+    }
+    numSamples = readBigEndian(images, 4, imagesFilename);
+    sampleSize = static_cast<size_t>(readBigEndian(images, 8, imagesFilename)) * readBigEndian(images, 12, imagesFilename);
+    if (readBigEndian(labels, 4, labelsFilename) != numSamples) {
+        throw std::runtime_error("IDX image and label counts do not match");
+    }
+    if (std::filesystem::file_size(imagesFilename) < pixelOffset + numSamples * sampleSize ||
+        std::filesystem::file_size(labelsFilename) < labelOffset + numSamples) {
+        throw std::runtime_error("Truncated IDX file");
+    }
+    configure(shuffleBufferSize, chunkSamples);
+}
+
+// Validates the options shared by both constructors and resets the slot state
+void StreamingLoader::configure(size_t shuffleBufferSize, size_t chunkSamples) {
+    if (chunkSamples == 0) {
+        throw std::invalid_argument("Chunk size must be positive");
+    }
+    chunkSize = chunkSamples;
+    // The buffer must hold at least one whole chunk
+    bufferCapacity = std::max(shuffleBufferSize, chunkSize);
+    readSlot = 0;
+    writeSlot = 0;
+    filledSlots = 0;
+    epochFinished = true;
+    stopping = false;
+}
+
+// Destructor: Stops the producer
+StreamingLoader::~StreamingLoader() {
+    stopProducer();
+}
+
+// Get number of samples delivered per epoch
+size_t StreamingLoader::getNumSamples() const {
+    return numSamples;
+}
+
+// Get number of input values per sample
+size_t StreamingLoader::getSampleSize() const {
+    return sampleSize;
+}
+
+// Stops and joins the producer thread of the current epoch
+void StreamingLoader::stopProducer() {
+    if (producer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        slotFreed.notify_all();
+        producer.join();
+    }
+    readSlot = 0;
+    writeSlot = 0;
+    filledSlots = 0;
+    epochFinished = true;
+    stopping = false;
+    error = nullptr;
+}
+
+// Starts a new epoch: restarts the producer with a fresh shuffle
+void StreamingLoader::startEpoch(int epoch, size_t batchSize) {
+    stopProducer();
+    batchSize = std::max<size_t>(1, batchSize);
+    for (auto& slot : slots) {
+        slot.inputs.resize(batchSize * sampleSize);
+        slot.labels.reserve(batchSize);
+    }
+    epochFinished = false;
+    producer = std::thread(&StreamingLoader::produce, this, epoch, batchSize);
+}
+
+// Producer main loop for one epoch
+void StreamingLoader::produce(int epoch, size_t batchSize) {
+    try {
+        std::ifstream pixelFile(pixelFilename, std::ios::binary);
+        std::ifstream labelFile(labelFilename, std::ios::binary);
+        if (!pixelFile.is_open() || !labelFile.is_open()) {
+            throw std::runtime_error("Could not open file: " + pixelFilename);
+        }
+        std::mt19937 generator(seed + static_cast<unsigned>(epoch));
+
+        // Chunks are visited in random order, then samples are drawn at random from the buffer
+        size_t numChunks = (numSamples + chunkSize - 1) / chunkSize;
+        std::vector<size_t> chunkOrder(numChunks);
+        std::iota(chunkOrder.begin(), chunkOrder.end(), 0);
+        if (shuffle) {
+            std::shuffle(chunkOrder.begin(), chunkOrder.end(), generator);
+        }
+        std::vector<uint8_t> pixels(bufferCapacity * sampleSize);
+        std::vector<uint8_t> labels(bufferCapacity);
+        size_t buffered = 0;    // Samples in the buffer
+        size_t readPos = 0;     // Next sample to take in file order (stays 0 when shuffling)
+        size_t nextChunk = 0;   // Next entry of chunkOrder to read
+
+        // Reads whole chunks while they fit; in file order the buffer is only refilled once drained
+        auto refill = [&] {
+            if (readPos == buffered) {
+                buffered = 0;
+                readPos = 0;
+            }
+            while (nextChunk < numChunks) {
+                size_t first = chunkOrder[nextChunk] * chunkSize;
+                size_t count = std::min(chunkSize, numSamples - first);
+                if (buffered + count > bufferCapacity || (!shuffle && buffered > 0)) {
+                    break;
+                }
+                readAt(pixelFile, pixelOffset + first * sampleSize, pixels.data() + buffered * sampleSize,
+                       count * sampleSize, pixelFilename);
+                readAt(labelFile, labelOffset + first, labels.data() + buffered, count, labelFilename);
+                for (size_t i = buffered; i < buffered + count; ++i) {
+                    if (labels[i] > 9) {
+                        throw std::runtime_error("Invalid label " + std::to_string(labels[i]) + " in " + labelFilename);
+                    }
+                }
+                buffered += count;
+                nextChunk++;
+            }
+        };
+
+        while (true) {
+            // Wait for a free slot
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                slotFreed.wait(lock, [&] { return stopping || filledSlots < slots.size(); });
+                if (stopping) {
+                    return;
+                }
+            }
+            // The free slot belongs to the producer until it is published
+            Batch& slot = slots[writeSlot];
+            slot.labels.clear();
+            size_t count = 0;
+            while (count < batchSize) {
+                refill();
+                if (readPos == buffered) {
+                    break; // No samples left in this epoch
+                }
+                size_t index = shuffle ? std::uniform_int_distribution<size_t>(0, buffered - 1)(generator) : readPos++;
+                Dataset::normalizePixels(std::span<const uint8_t>(pixels.data() + index * sampleSize, sampleSize),
+                                         std::span<Scalar>(slot.inputs.data() + count * sampleSize, sampleSize));
+                slot.labels.push_back(labels[index]);
+                if (shuffle) {
+                    // Fill the hole with the last buffered sample
+                    buffered--;
+                    std::copy_n(pixels.data() + buffered * sampleSize, sampleSize, pixels.data() + index * sampleSize);
+                    labels[index] = labels[buffered];
+                }
+                count++;
+            }
+            // Publish the batch, or signal the end of the epoch
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (count > 0) {
+                    filledSlots++;
+                    writeSlot = (writeSlot + 1) % slots.size();
+                } else {
+                    epochFinished = true;
+                }
+            }
+            slotFilled.notify_one();
+            if (count == 0) {
+                return;
+            }
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = std::current_exception();
+        epochFinished = true;
+        slotFilled.notify_one();
+    }
+}
+
+// Copies the next ready batch out of the double buffer; returns 0 at the end of the epoch
+size_t StreamingLoader::nextBatch(std::span<Scalar> inputs, std::vector<int>& labels) {
+    std::unique_lock<std::mutex> lock(mutex);
+    slotFilled.wait(lock, [&] { return filledSlots > 0 || epochFinished; });
+    if (filledSlots == 0) {
+        if (error) {
+            std::exception_ptr thrown = error;
+            error = nullptr;
+            std::rethrow_exception(thrown);
+        }
+        labels.clear();
+        return 0;
+    }
+    // The filled slot is not touched by the producer until it is released below
+    Batch& slot = slots[readSlot];
+    lock.unlock();
+    size_t count = slot.labels.size();
+    if (inputs.size() < count * sampleSize) {
+        throw std::invalid_argument("Input buffer is too small for the batch");
+    }
+    std::copy_n(slot.inputs.data(), count * sampleSize, inputs.data());
+    labels.assign(slot.labels.begin(), slot.labels.end());
+    lock.lock();
+    filledSlots--;
+    readSlot = (readSlot + 1) % slots.size();
+    lock.unlock();
+    slotFreed.notify_one();
+    return count;
+}
@@ -0,0 +1,85 @@
+//
+//  StreamingLoader.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef StreamingLoader_hpp
+#define StreamingLoader_hpp
+
+#include "BatchSource.hpp"
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Out-of-core batch source for datasets larger than memory.
+// Samples are read from a binary cache file (or MNIST IDX files) in chunks, mixed in a bounded
+// shuffle buffer and assembled into ready-to-use batches by a background thread. Two batch slots
+// are double-buffered so training never waits on I/O as long as the producer keeps up.
+class StreamingLoader : public BatchSource {
+private:
+    std::string pixelFilename;      // File holding the pixel matrix
+    std::string labelFilename;      // File holding the labels (one byte per sample)
+    uint64_t pixelOffset;           // Byte offset of the first pixel
+    uint64_t labelOffset;           // Byte offset of the first label
+    size_t numSamples;              // Number of samples in the file
+    size_t sampleSize;              // Pixels per sample
+    size_t chunkSize;               // Samples read per I/O request
+    size_t bufferCapacity;          // Capacity of the shuffle buffer in samples
+    bool shuffle;                   // Shuffle chunk order and samples within the buffer
+    unsigned seed;                  // Base seed; epoch e uses seed + e
+
+    // One ready-to-use batch
+    struct Batch {
+        std::vector<Scalar> inputs; // Normalized inputs stacked row by row
+        std::vector<int> labels;    // Labels of the batch
+    };
+    std::array<Batch, 2> slots;     // Double buffer shared with the producer
+    size_t readSlot;                // Next slot the consumer reads
+    size_t writeSlot;               // Next slot the producer fills
+    size_t filledSlots;             // Slots ready for the consumer
+    bool epochFinished;             // Producer delivered the last batch of the epoch
+    bool stopping;                  // Producer must exit
+    std::exception_ptr error;       // Error raised by the producer
+    std::mutex mutex;               // Guards the slot state above
+    std::condition_variable slotFilled;
+    std::condition_variable slotFreed;
+    std::thread producer;           // Background thread assembling batches
+
+    // Validates the options shared by both constructors
+    void configure(size_t shuffleBufferSize, size_t chunkSamples);
+
+    // Stops and joins the producer thread of the current epoch
+    void stopProducer();
+
+    // Producer main loop for one epoch: reads chunks, shuffles and assembles batches
+    void produce(int epoch, size_t batchSize);
+
+public:
+    // Constructor: Streams a binary cache file written by Dataset::save()
+    StreamingLoader(const std::string& filename, size_t shuffleBufferSize = 16384, bool shuffle = true,
+                    unsigned seed = 0, size_t chunkSamples = 1024);
+
+    // Constructor: Streams the original MNIST IDX image and label files
+    StreamingLoader(const std::string& imagesFilename, const std::string& labelsFilename,
+                    size_t shuffleBufferSize = 16384, bool shuffle = true, unsigned seed = 0,
+                    size_t chunkSamples = 1024);
+
+    // Destructor: Stops the producer
+    ~StreamingLoader() override;
+
+    StreamingLoader(const StreamingLoader&) = delete;
+    StreamingLoader& operator=(const StreamingLoader&) = delete;
+
+    size_t getNumSamples() const override;
+    size_t getSampleSize() const override;
+    void startEpoch(int epoch, size_t batchSize) override;
+    size_t nextBatch(std::span<Scalar> inputs, std::vector<int>& labels) override;
+};
+
+#endif /* StreamingLoader_hpp */
@@ -0,0 +1,100 @@
+//
+//  ThreadPool.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "ThreadPool.hpp"
+
+// Constructor: Starts numThreads - 1 workers; the caller is the remaining thread
+ThreadPool::ThreadPool(unsigned numThreads) {
+    if (numThreads == 0) {
+        numThreads = hardwareThreads();
+    }
+    for (unsigned i = 1; i < numThreads; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+// Destructor: Stops and joins all workers
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+// Claims and runs task indices of the current job until none are left (called with the lock held)
+void ThreadPool::runTasks(std::unique_lock<std::mutex>& lock) {
+    const std::function<void(size_t)>& current = *task;
+    while (nextTask < numTasks) {
+        size_t index = nextTask++;
+        lock.unlock();
+        try {
+            current(index);
+        } catch (...) {
+            std::lock_guard<std::mutex> errorLock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        lock.lock();
+    }
+}
+
+// Worker thread main loop: waits for a job, helps run it, reports completion
+void ThreadPool::workerLoop() {
+    size_t seenGeneration = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        jobReady.wait(lock, [&] { return stopping || generation != seenGeneration; });
+        if (stopping) {
+            return;
+        }
+        seenGeneration = generation;
+        runTasks(lock);
+        if (--busyWorkers == 0) {
+            jobDone.notify_one();
+        }
+    }
+}
+
+// Runs task(i) for every i in [0, numTasks) and blocks until all are done
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& function) {
+    if (count == 0) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    task = &function;
+    numTasks = count;
+    nextTask = 0;
+    error = nullptr;
+    busyWorkers = static_cast<unsigned>(workers.size());
+    ++generation;
+    jobReady.notify_all();
+    // The calling thread works on the job too
+    runTasks(lock);
+    jobDone.wait(lock, [&] { return busyWorkers == 0; });
+    task = nullptr;
+    if (error) {
+        std::exception_ptr thrown = error;
+        error = nullptr;
+        std::rethrow_exception(thrown);
+    }
+}
+
+// Getter: Returns the total number of threads, including the caller
+unsigned ThreadPool::getNumThreads() const {
+    return static_cast<unsigned>(workers.size()) + 1;
+}
+
+// Returns the number of hardware threads (at least 1)
+unsigned ThreadPool::hardwareThreads() {
+    unsigned count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
@@ -0,0 +1,61 @@
+//
+//  ThreadPool.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef ThreadPool_hpp
+#define ThreadPool_hpp
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads running blocking parallel-for loops.
+// The calling thread takes part in every loop, so a pool of N threads starts N - 1 workers.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;                  // Worker threads (numThreads - 1)
+    std::mutex mutex;                                  // Guards the job state below
+    std::condition_variable jobReady;                  // Signals workers that a new job is available
+    std::condition_variable jobDone;                   // Signals the caller that all workers finished
+    const std::function<void(size_t)>* task = nullptr; // Task of the current job
+    size_t numTasks = 0;                               // Number of task indices in the current job
+    size_t nextTask = 0;                               // Next task index to hand out
+    size_t generation = 0;                             // Incremented for every job
+    unsigned busyWorkers = 0;                          // Workers still running the current job
+    bool stopping = false;                             // Set when the pool is destroyed
+    std::exception_ptr error;                          // First exception thrown by a task
+
+    // Worker thread main loop
+    void workerLoop();
+
+    // Claims and runs task indices of the current job until none are left
+    void runTasks(std::unique_lock<std::mutex>& lock);
+
+public:
+    // Constructor: Starts a pool using numThreads threads in total (0 = one per hardware thread)
+    explicit ThreadPool(unsigned numThreads = 0);
+
+    // Destructor: Stops and joins all workers
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Runs task(i) for every i in [0, numTasks) across the pool and blocks until all are done.
+    // Rethrows the first exception thrown by a task
+    void parallelFor(size_t numTasks, const std::function<void(size_t)>& task);
+
+    // Getter: Returns the total number of threads, including the caller
+    unsigned getNumThreads() const;
+
+    // Returns the number of hardware threads (at least 1)
+    static unsigned hardwareThreads();
+};
+
+#endif /* ThreadPool_hpp */
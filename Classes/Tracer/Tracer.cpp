@@ -0,0 +1,286 @@
+//
+//  Tracer.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "Tracer.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+std::atomic<bool> Tracer::recording(false);
+std::atomic<bool> Tracer::countersEnabled(false);
+std::atomic<bool> Tracer::countersAvailable(false);
+std::chrono::steady_clock::time_point Tracer::epoch;
+std::mutex Tracer::buffersMutex;
+std::vector<std::unique_ptr<Tracer::ThreadBuffer>> Tracer::buffers;
+
+namespace {
+
+// Hardware counters of one thread, opened on first use as a single perf event group
+// (cycles leads, so all three are scheduled together and read with one system call)
+class PerfCounters {
+private:
+    static constexpr int NUM_COUNTERS = 3;
+    int fds[NUM_COUNTERS] = { -1, -1, -1 };  // cycles, instructions, LLC misses (-1 if not opened)
+    bool opened = false;                     // True once opening was attempted
+
+#ifdef __linux__
+    // Opens one counter of the calling thread, in user space only so it works without privileges
+    static int openCounter(uint64_t config, int groupFd) {
+        perf_event_attr attr = {};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.disabled = groupFd == -1 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+    }
+#endif
+
+public:
+    // Destructor: Closes the counters when the thread exits
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int fd : fds) {
+            if (fd != -1) {
+                ::close(fd);
+            }
+        }
+#endif
+    }
+
+    // Opens the counters if this has not been tried yet; returns true if at least the cycle counter is open
+    bool open() {
+        if (!opened) {
+            opened = true;
+#ifdef __linux__
+            fds[0] = openCounter(PERF_COUNT_HW_CPU_CYCLES, -1);
+            if (fds[0] != -1) {
+                // Members that the CPU or hypervisor does not support simply stay closed and read as zero
+                fds[1] = openCounter(PERF_COUNT_HW_INSTRUCTIONS, fds[0]);
+                fds[2] = openCounter(PERF_COUNT_HW_CACHE_MISSES, fds[0]);
+                ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+#endif
+        }
+        return fds[0] != -1;
+    }
+
+    // Reads the current counter values
+    Tracer::Counters read() const {
+        Tracer::Counters counters;
+#ifdef __linux__
+        // Group read format: number of counters, then one value per open counter in creation order
+        uint64_t values[1 + NUM_COUNTERS] = {};
+        if (fds[0] == -1 || ::read(fds[0], values, sizeof(values)) <= 0) {
+            return counters;
+        }
+        uint64_t* slots[NUM_COUNTERS] = { &counters.cycles, &counters.instructions, &counters.llcMisses };
+        size_t next = 1;
+        for (int i = 0; i < NUM_COUNTERS && next <= values[0]; ++i) {
+            if (fds[i] != -1) {
+                *slots[i] = values[next++];
+            }
+        }
+#endif
+        return counters;
+    }
+};
+
+// Per-layer aggregate used by printSummary()
+struct SummaryRow {
+    size_t calls = 0;
+    int64_t nanoseconds = 0;
+    Tracer::Counters counters;
+};
+
+// Escapes a string for a JSON string literal
+std::string escapeJSON(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+} // namespace
+
+// Constructor: Starts timing if the tracer is recording
+Tracer::Scope::Scope(const char* name, int layer) : name(name), layer(layer), active(recording) {
+    if (active) {
+        counters = readCounters();
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+// Destructor: Records the event
+Tracer::Scope::~Scope() {
+    if (!active) {
+        return;
+    }
+    auto end = std::chrono::steady_clock::now();
+    Counters endCounters = readCounters();
+    Event event;
+    event.name = name;
+    event.layer = layer;
+    event.start = std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch).count();
+    event.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    event.counters.cycles = endCounters.cycles - counters.cycles;
+    event.counters.instructions = endCounters.instructions - counters.instructions;
+    event.counters.llcMisses = endCounters.llcMisses - counters.llcMisses;
+    ThreadBuffer& buffer = threadBuffer();
+    event.thread = buffer.thread;
+    buffer.events.push_back(event);
+}
+
+// Clears previous events and starts recording
+void Tracer::start(bool useCounters) {
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (auto& buffer : buffers) {
+        buffer->events.clear();
+    }
+    countersEnabled = useCounters;
+    countersAvailable = false;
+    epoch = std::chrono::steady_clock::now();
+    recording = true;
+}
+
+// Stops recording
+void Tracer::stop() {
+    recording = false;
+}
+
+// True while recording
+bool Tracer::isRecording() {
+    return recording;
+}
+
+// True if at least one thread has read hardware counters since start()
+bool Tracer::hasCounters() {
+    return countersAvailable;
+}
+
+// Returns the calling thread's buffer, registering it on first use
+Tracer::ThreadBuffer& Tracer::threadBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer == nullptr) {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffer = buffers.back().get();
+        buffer->thread = static_cast<uint32_t>(buffers.size());
+    }
+    return *buffer;
+}
+
+// Reads the calling thread's counters (zeros if unavailable)
+Tracer::Counters Tracer::readCounters() {
+    if (!countersEnabled) {
+        return Counters();
+    }
+    thread_local PerfCounters perf;
+    if (!perf.open()) {
+        return Counters();
+    }
+    countersAvailable = true;
+    return perf.read();
+}
+
+// Returns a copy of all recorded events
+std::vector<Tracer::Event> Tracer::getEvents() {
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    std::vector<Event> events;
+    for (const auto& buffer : buffers) {
+        events.insert(events.end(), buffer->events.begin(), buffer->events.end());
+    }
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.start < b.start; });
+    return events;
+}
+
+// Writes the recorded events as Chrome trace JSON (complete events, timestamps in microseconds)
+void Tracer::writeChromeTrace(const std::string& filename) {
+    std::ofstream file(filename, std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not create file: " + filename);
+    }
+    std::vector<Event> events = getEvents();
+    bool counters = hasCounters();
+    file << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    for (size_t i = 0; i < events.size(); ++i) {
+        const Event& event = events[i];
+        std::string name = event.layer >= 0 ? std::string(event.name) + " L" + std::to_string(event.layer) : event.name;
+        file << (i > 0 ? ",\n" : "\n") << "{\"name\":\"" << escapeJSON(name) << "\",\"cat\":\""
+             << (event.layer >= 0 ? "layer" : "data") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+             << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << event.duration / 1000.0 << ",\"args\":{\"layer\":"
+             << event.layer;
+        if (counters) {
+            file << ",\"cycles\":" << event.counters.cycles << ",\"instructions\":" << event.counters.instructions
+                 << ",\"llcMisses\":" << event.counters.llcMisses;
+        }
+        file << "}}";
+    }
+    file << "\n]}\n";
+    if (!file) {
+        throw std::runtime_error("Could not write file: " + filename);
+    }
+}
+
+// Prints calls, time and counters aggregated per scope name and layer
+void Tracer::printSummary() {
+    std::vector<Event> events = getEvents();
+    std::map<std::pair<std::string, int>, SummaryRow> rows;
+    int64_t totalNanoseconds = 0;
+    for (const Event& event : events) {
+        SummaryRow& row = rows[{ event.name, event.layer }];
+        row.calls++;
+        row.nanoseconds += event.duration;
+        row.counters.cycles += event.counters.cycles;
+        row.counters.instructions += event.counters.instructions;
+        row.counters.llcMisses += event.counters.llcMisses;
+        totalNanoseconds += event.duration;
+    }
+    bool counters = hasCounters();
+    std::cout << std::left << std::setw(14) << "scope" << std::right << std::setw(6) << "layer" << std::setw(10)
+              << "calls" << std::setw(12) << "total ms" << std::setw(12) << "mean us" << std::setw(8) << "share";
+    if (counters) {
+        std::cout << std::setw(16) << "cycles" << std::setw(16) << "instructions" << std::setw(7) << "IPC"
+                  << std::setw(14) << "LLC misses";
+    }
+    std::cout << std::endl;
+    for (const auto& [key, row] : rows) {
+        std::cout << std::left << std::setw(14) << key.first << std::right << std::setw(6)
+                  << (key.second >= 0 ? std::to_string(key.second) : "-") << std::setw(10) << row.calls << std::fixed
+                  << std::setprecision(2) << std::setw(12) << row.nanoseconds / 1e6 << std::setw(12)
+                  << row.nanoseconds / 1e3 / row.calls << std::setprecision(1) << std::setw(7)
+                  << 100.0 * row.nanoseconds / std::max<int64_t>(1, totalNanoseconds) << "%";
+        if (counters) {
+            std::cout << std::setw(16) << row.counters.cycles << std::setw(16) << row.counters.instructions
+                      << std::setprecision(2) << std::setw(7)
+                      << static_cast<double>(row.counters.instructions) / std::max<uint64_t>(1, row.counters.cycles)
+                      << std::setw(14) << row.counters.llcMisses;
+        }
+        std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+    }
+    if (!counters) {
+        std::cout << "(hardware counters unavailable: not requested, not supported here, or not permitted by perf_event_paranoid)"
+                  << std::endl;
+    }
+}
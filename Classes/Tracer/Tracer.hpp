@@ -0,0 +1,125 @@
+//
+//  Tracer.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef Tracer_hpp
+#define Tracer_hpp
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Opt-in instrumentation of the training and inference hot paths.
+// Build with -DNN_ENABLE_TRACING to turn the NN_TRACE_SCOPE markers into scoped timers; otherwise they
+// compile to nothing. Recording also has to be switched on at run time with Tracer::start(). Each scope
+// records its wall-clock interval and, where perf_event_open is permitted (Linux), the cycles,
+// instructions and last-level cache misses of the calling thread. The recorded events can be written as
+// Chrome trace JSON (chrome://tracing, Perfetto) and summarized per layer.
+class Tracer {
+public:
+    // Hardware counter values (all zero if counters are unavailable)
+    struct Counters {
+        uint64_t cycles = 0;        // CPU cycles
+        uint64_t instructions = 0;  // Retired instructions
+        uint64_t llcMisses = 0;     // Last-level cache misses
+    };
+
+    // One timed scope
+    struct Event {
+        const char* name;       // Scope name (a string literal)
+        int layer;              // Layer index, or -1 for scopes that are not per layer
+        uint32_t thread;        // Small per-thread id assigned in order of first use
+        int64_t start;          // Start time in nanoseconds since start()
+        int64_t duration;       // Duration in nanoseconds
+        Counters counters;      // Counter deltas over the scope
+    };
+
+    // Times the enclosing scope while recording is on (used through NN_TRACE_SCOPE)
+    class Scope {
+    private:
+        const char* name;                               // Scope name
+        int layer;                                      // Layer index or -1
+        bool active;                                    // True if the tracer was recording when the scope began
+        std::chrono::steady_clock::time_point start;    // Start time
+        Counters counters;                              // Counter values at the start
+
+    public:
+        // Constructor: Starts timing if the tracer is recording
+        Scope(const char* name, int layer);
+
+        // Destructor: Records the event
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    // True if the NN_TRACE_SCOPE markers were compiled in
+    static constexpr bool isCompiledIn() {
+#ifdef NN_ENABLE_TRACING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Clears previous events and starts recording; hardware counters are read if requested and permitted.
+    // Call while no traced code is running
+    static void start(bool useCounters = true);
+
+    // Stops recording (events are kept until the next start())
+    static void stop();
+
+    // True while recording
+    static bool isRecording();
+
+    // True if at least one thread has read hardware counters since start()
+    static bool hasCounters();
+
+    // Returns a copy of all recorded events. Call while no traced code is running
+    static std::vector<Event> getEvents();
+
+    // Writes the recorded events as Chrome trace JSON; throws std::runtime_error if the file cannot be written
+    static void writeChromeTrace(const std::string& filename);
+
+    // Prints calls, time and counters aggregated per scope name and layer
+    static void printSummary();
+
+private:
+    // Events of one thread; only that thread appends to it while recording
+    struct ThreadBuffer {
+        uint32_t thread = 0;
+        std::vector<Event> events;
+    };
+
+    static std::atomic<bool> recording;                         // Set between start() and stop()
+    static std::atomic<bool> countersEnabled;                   // Counters requested by start()
+    static std::atomic<bool> countersAvailable;                 // Set once a thread managed to open its counters
+    static std::chrono::steady_clock::time_point epoch;         // Time of start()
+    static std::mutex buffersMutex;                             // Guards buffers
+    static std::vector<std::unique_ptr<ThreadBuffer>> buffers;  // One buffer per thread that ever recorded
+
+    // Returns the calling thread's buffer, registering it on first use
+    static ThreadBuffer& threadBuffer();
+
+    // Reads the calling thread's counters (zeros if unavailable)
+    static Counters readCounters();
+};
+
+#ifdef NN_ENABLE_TRACING
+#define NN_TRACE_CONCAT_INNER(a, b) a##b
+#define NN_TRACE_CONCAT(a, b) NN_TRACE_CONCAT_INNER(a, b)
+// Times the rest of the enclosing scope under the given name and layer index (-1 if not per layer)
+#define NN_TRACE_SCOPE(name, layer) Tracer::Scope NN_TRACE_CONCAT(traceScope, __LINE__)(name, static_cast<int>(layer))
+#else
+#define NN_TRACE_SCOPE(name, layer) ((void)0)
+#endif
+
+#endif /* Tracer_hpp */
@@ -0,0 +1,172 @@
+//
+//  TrainingController.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "TrainingController.hpp"
+#include "DatasetSource.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numbers>
+#include <stdexcept>
+
+// Constructor: Controller with the default options
+TrainingController::TrainingController() : TrainingController(Settings()) {}
+
+// Constructor: Controller with the given options
+TrainingController::TrainingController(const Settings& settings) : settings(settings) {
+    if (settings.maxEpochs <= 0 || settings.batchSize == 0 || settings.evaluationsPerEpoch <= 0) {
+        throw std::invalid_argument("Epochs, batch size and evaluations per epoch must be positive");
+    }
+    if (!(settings.validationFraction > 0.0 && settings.validationFraction < 1.0)) {
+        throw std::invalid_argument("Validation fraction must be between 0 and 1");
+    }
+    if (settings.patience < 0 || settings.warmupEpochs < 0.0 || settings.minLearningRate < 0.0 ||
+        !(settings.stepEpochs > 0.0) || !(settings.stepFactor > 0.0)) {
+        throw std::invalid_argument("Invalid training controller settings");
+    }
+}
+
+// Learning rate after `epoch` epochs: the schedule's rate, scaled down linearly during warmup
+double TrainingController::learningRateAt(double baseLearningRate, double epoch) const {
+    double rate = baseLearningRate;
+    switch (settings.schedule) {
+        case Schedule::Constant:
+            break;
+        case Schedule::Step:
+            rate *= std::pow(settings.stepFactor, std::floor(epoch / settings.stepEpochs));
+            break;
+        case Schedule::Cosine: {
+            // The annealing starts after the warmup and ends at maxEpochs
+            double span = std::max(1e-9, settings.maxEpochs - settings.warmupEpochs);
+            double t = std::clamp((epoch - settings.warmupEpochs) / span, 0.0, 1.0);
+            rate = settings.minLearningRate +
+                   (baseLearningRate - settings.minLearningRate) * 0.5 * (1.0 + std::cos(std::numbers::pi * t));
+            break;
+        }
+    }
+    if (epoch < settings.warmupEpochs) {
+        rate *= epoch / settings.warmupEpochs;
+    }
+    return rate;
+}
+
+// Splits the last validationFraction of the samples off as the validation set
+TrainingController::Result TrainingController::train(Network& network, const Dataset& data) const {
+    size_t numSamples = data.getNumSamples();
+    size_t numValidation = static_cast<size_t>(std::llround(settings.validationFraction * numSamples));
+    if (numValidation == 0 || numValidation >= numSamples) {
+        throw std::invalid_argument("Dataset is too small for the validation split");
+    }
+    size_t numTraining = numSamples - numValidation;
+    std::cout << "Training on " << numTraining << " samples, validating on " << numValidation << std::endl;
+    return train(network, data.slice(0, numTraining), data.slice(numTraining, numValidation));
+}
+
+// Trains batch by batch, validating evaluationsPerEpoch times per epoch
+TrainingController::Result TrainingController::train(Network& network, const Dataset& trainData,
+                                                     const Dataset& validationData) const {
+    size_t sampleSize = trainData.getSampleSize();
+    size_t numSamples = trainData.getNumSamples();
+    if (numSamples == 0 || validationData.getNumSamples() == 0) {
+        throw std::invalid_argument("Training and validation sets must not be empty");
+    }
+    if (sampleSize != static_cast<size_t>(network.getInputSize()) || validationData.getSampleSize() != sampleSize) {
+        throw std::invalid_argument("Sample size does not match network input size");
+    }
+    size_t batchSize = std::min(settings.batchSize, numSamples);
+    size_t batchesPerEpoch = (numSamples + batchSize - 1) / batchSize;
+    double baseLearningRate = network.getOptimizer().getLearningRate();
+
+    DatasetSource source(trainData, settings.shuffle, settings.seed);
+    std::vector<Scalar> inputs(batchSize * sampleSize);
+    std::vector<int> labels;
+    labels.reserve(batchSize);
+    // The best weights are copied here in place, so checkpoints do not allocate after this copy
+    Network best = network;
+
+    Result result;
+    int staleEvaluations = 0;
+    bool stopped = false;
+    auto start = std::chrono::steady_clock::now();
+    for (int epoch = 0; epoch < settings.maxEpochs && !stopped; ++epoch) {
+        source.startEpoch(epoch, batchSize);
+        Accumulator loss = 0.0;
+        size_t lossSamples = 0;
+        double learningRate = baseLearningRate;
+        for (size_t batch = 0; size_t count = source.nextBatch(inputs, labels); ++batch) {
+            // The schedule is sampled in the middle of the step, so warmup never yields a zero rate
+            learningRate = learningRateAt(baseLearningRate, epoch + (batch + 0.5) / batchesPerEpoch);
+            network.setLearningRate(learningRate);
+            if (count == 1) {
+                loss += network.trainStep(std::span<const Scalar>(inputs.data(), sampleSize), labels[0]);
+            } else {
+                loss += network.trainBatch(std::span<const Scalar>(inputs.data(), count * sampleSize), labels);
+            }
+            lossSamples += count;
+
+            // Validate at evaluationsPerEpoch evenly spaced steps, the last one ending the epoch
+            size_t evaluations = settings.evaluationsPerEpoch;
+            if ((batch + 1) * evaluations / batchesPerEpoch == batch * evaluations / batchesPerEpoch) {
+                continue;
+            }
+            Evaluation evaluation;
+            evaluation.epoch = epoch + (batch + 1.0) / batchesPerEpoch;
+            evaluation.learningRate = learningRate;
+            evaluation.trainingLoss = loss / std::max<size_t>(1, lossSamples);
+            evaluation.accuracy = network.evaluate(validationData).accuracy;
+            evaluation.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            result.history.push_back(evaluation);
+            result.epochs = evaluation.epoch;
+            loss = 0.0;
+            lossSamples = 0;
+            std::cout << "Epoch " << evaluation.epoch << ", lr " << learningRate << ", Loss: "
+                      << evaluation.trainingLoss << ", validation accuracy " << evaluation.accuracy << std::endl;
+
+            if (result.history.size() == 1 || evaluation.accuracy > result.bestAccuracy + settings.minImprovement) {
+                result.bestAccuracy = evaluation.accuracy;
+                result.bestEpoch = evaluation.epoch;
+                best.copyParameters(network);
+                staleEvaluations = 0;
+            } else {
+                staleEvaluations++;
+            }
+            if (settings.targetAccuracy > 0.0 && evaluation.accuracy >= settings.targetAccuracy) {
+                result.stopReason = StopReason::Target;
+                stopped = true;
+            } else if (settings.patience > 0 && staleEvaluations >= settings.patience) {
+                result.stopReason = StopReason::Patience;
+                stopped = true;
+            }
+            if (stopped) {
+                break;
+            }
+        }
+    }
+    if (settings.restoreBest) {
+        network.copyParameters(best);
+    }
+    network.setLearningRate(baseLearningRate);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Stopped (" << getStopReasonName(result.stopReason) << ") after " << result.epochs
+              << " epochs, best validation accuracy " << result.bestAccuracy << " at epoch " << result.bestEpoch
+              << std::endl;
+    return result;
+}
+
+// Returns a printable name for a stop reason
+const char* TrainingController::getStopReasonName(StopReason reason) {
+    switch (reason) {
+        case StopReason::MaxEpochs:
+            return "max epochs";
+        case StopReason::Target:
+            return "target reached";
+        case StopReason::Patience:
+            return "no improvement";
+    }
+    return "unknown";
+}
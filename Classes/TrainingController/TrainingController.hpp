@@ -0,0 +1,98 @@
+//
+//  TrainingController.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef TrainingController_hpp
+#define TrainingController_hpp
+
+#include "Network.hpp"
+#include "Dataset.hpp"
+#include <vector>
+
+// Trains a network against a held-out validation set instead of for a fixed number of epochs.
+// Validation accuracy is measured several times per epoch; training stops once it reaches a target or
+// stops improving, and the best weights seen are kept in memory and restored at the end.
+// The learning rate follows a schedule (constant, step or cosine, with optional linear warmup).
+class TrainingController {
+public:
+    // Learning rate schedules, applied per step on top of the optional warmup
+    enum class Schedule {
+        Constant,   // Base learning rate throughout
+        Step,       // Multiplied by stepFactor every stepEpochs epochs
+        Cosine      // Cosine annealing from the base rate to minLearningRate over maxEpochs
+    };
+
+    // Why training ended
+    enum class StopReason {
+        MaxEpochs,  // Ran all maxEpochs epochs
+        Target,     // Validation accuracy reached targetAccuracy
+        Patience    // Validation accuracy did not improve for patience evaluations
+    };
+
+    // Training options
+    struct Settings {
+        int maxEpochs = 20;                 // Upper bound on passes over the training split
+        size_t batchSize = 32;              // Samples per update
+        double validationFraction = 0.1;    // Share of the dataset held out for validation (its last samples)
+        int evaluationsPerEpoch = 1;        // Validation runs per epoch
+        int patience = 3;                   // Evaluations without improvement before stopping (0 = never stop early)
+        double minImprovement = 0.0;        // Accuracy gain over the best so far that counts as an improvement
+        double targetAccuracy = 0.0;        // Stop once validation accuracy reaches this (0 = no target)
+        Schedule schedule = Schedule::Constant;
+        double warmupEpochs = 0.0;          // Linear warmup from 0 to the base rate over this many epochs
+        double stepEpochs = 10.0;           // Step schedule: epochs between decays
+        double stepFactor = 0.1;            // Step schedule: decay factor
+        double minLearningRate = 0.0;       // Cosine schedule: learning rate reached at maxEpochs
+        bool shuffle = true;                // Reshuffle the training split every epoch
+        unsigned seed = 0;                  // Shuffle seed
+        bool restoreBest = true;            // Leave the network with the best weights rather than the last ones
+    };
+
+    // One validation run
+    struct Evaluation {
+        double epoch = 0.0;         // Epochs trained so far (fractional between epoch ends)
+        double learningRate = 0.0;  // Learning rate of the last step
+        double trainingLoss = 0.0;  // Average training loss since the previous evaluation
+        double accuracy = 0.0;      // Validation accuracy
+        double seconds = 0.0;       // Wall-clock time since training started
+    };
+
+    // Outcome of a training run
+    struct Result {
+        std::vector<Evaluation> history;        // Every validation run, in order
+        double bestAccuracy = 0.0;              // Best validation accuracy
+        double bestEpoch = 0.0;                 // Epochs trained when it was reached
+        double epochs = 0.0;                    // Epochs trained in total
+        StopReason stopReason = StopReason::MaxEpochs;
+        double seconds = 0.0;                   // Wall-clock time of the whole run, including validation
+    };
+
+private:
+    Settings settings;  // Training options
+
+public:
+    // Constructor: Controller with the default options
+    TrainingController();
+
+    // Constructor: Controller with the given options; throws std::invalid_argument if they are out of range
+    explicit TrainingController(const Settings& settings);
+
+    // Learning rate after `epoch` (fractional) epochs of training for the given base rate
+    double learningRateAt(double baseLearningRate, double epoch) const;
+
+    // Splits validationFraction of data off its end and trains on the rest.
+    // Throws std::invalid_argument if either part would be empty
+    Result train(Network& network, const Dataset& data) const;
+
+    // Trains on trainData and validates on validationData. The network's optimizer is used with its current
+    // learning rate as the base rate, and that rate is set again when training ends
+    Result train(Network& network, const Dataset& trainData, const Dataset& validationData) const;
+
+    // Returns a printable name for a stop reason
+    static const char* getStopReasonName(StopReason reason);
+};
+
+#endif /* TrainingController_hpp */
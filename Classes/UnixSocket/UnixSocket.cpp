@@ -0,0 +1,154 @@
+//
+//  UnixSocket.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "UnixSocket.hpp"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Builds the socket address for path; throws if the path does not fit
+sockaddr_un makeAddress(const std::string& path) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Socket path is too long: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+} // namespace
+
+// Constructor: Takes ownership of a descriptor
+UnixSocket::UnixSocket(int fd) : fd(fd) {}
+
+// Constructor: Closed socket
+UnixSocket::UnixSocket() : fd(-1) {}
+
+// Destructor: Closes the socket
+UnixSocket::~UnixSocket() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+// Move constructor: Takes over the descriptor
+UnixSocket::UnixSocket(UnixSocket&& other) noexcept : fd(std::exchange(other.fd, -1)) {}
+
+// Move assignment: Closes the current descriptor and takes over the other one
+UnixSocket& UnixSocket::operator=(UnixSocket&& other) noexcept {
+    if (this != &other) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        fd = std::exchange(other.fd, -1);
+    }
+    return *this;
+}
+
+// Creates a listening socket at path
+UnixSocket UnixSocket::listen(const std::string& path, int backlog) {
+    sockaddr_un address = makeAddress(path);
+    UnixSocket socket(::socket(AF_UNIX, SOCK_STREAM, 0));
+    if (socket.fd < 0) {
+        throw std::runtime_error("Could not create socket: " + std::string(std::strerror(errno)));
+    }
+    ::unlink(path.c_str()); // Remove a stale socket file from a previous run
+    if (::bind(socket.fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(socket.fd, backlog) != 0) {
+        throw std::runtime_error("Could not listen on " + path + ": " + std::strerror(errno));
+    }
+    return socket;
+}
+
+// Connects to the listening socket at path
+UnixSocket UnixSocket::connect(const std::string& path) {
+    sockaddr_un address = makeAddress(path);
+    UnixSocket socket(::socket(AF_UNIX, SOCK_STREAM, 0));
+    if (socket.fd < 0) {
+        throw std::runtime_error("Could not create socket: " + std::string(std::strerror(errno)));
+    }
+    if (::connect(socket.fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        throw std::runtime_error("Could not connect to " + path + ": " + std::strerror(errno));
+    }
+    return socket;
+}
+
+// Waits up to timeoutMilliseconds for a connection
+UnixSocket UnixSocket::accept(int timeoutMilliseconds) {
+    pollfd request = { fd, POLLIN, 0 };
+    if (::poll(&request, 1, timeoutMilliseconds) <= 0) {
+        return UnixSocket();
+    }
+    return UnixSocket(::accept(fd, nullptr, nullptr));
+}
+
+// Reads exactly size bytes; returns false if the peer closed the connection first
+bool UnixSocket::readFully(void* buffer, size_t size) {
+    char* out = static_cast<char*>(buffer);
+    while (size > 0) {
+        ssize_t received = ::read(fd, out, size);
+        if (received == 0) {
+            return false;
+        }
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == ECONNRESET) {
+                return false;
+            }
+            throw std::runtime_error("Socket read failed: " + std::string(std::strerror(errno)));
+        }
+        out += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+// Writes exactly size bytes; returns false if the peer has gone away
+bool UnixSocket::writeFully(const void* buffer, size_t size) {
+    const char* in = static_cast<const char*>(buffer);
+    while (size > 0) {
+        ssize_t sent = ::write(fd, in, size);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false; // EPIPE / ECONNRESET (SIGPIPE is ignored by the server and client), or EAGAIN on timeout
+        }
+        in += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+// Makes blocked writes give up after timeoutMilliseconds
+bool UnixSocket::setSendTimeout(int timeoutMilliseconds) {
+    timeval timeout = { timeoutMilliseconds / 1000, (timeoutMilliseconds % 1000) * 1000 };
+    return ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) == 0;
+}
+
+// Shuts down both directions
+void UnixSocket::shutdown() {
+    if (fd >= 0) {
+        ::shutdown(fd, SHUT_RDWR);
+    }
+}
+
+// Returns true if the socket is open
+bool UnixSocket::isOpen() const {
+    return fd >= 0;
+}
@@ -0,0 +1,62 @@
+//
+//  UnixSocket.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef UnixSocket_hpp
+#define UnixSocket_hpp
+
+#include <cstddef>
+#include <string>
+
+// RAII wrapper around a Unix domain stream socket (POSIX).
+// Used by the inference server and its load generator; reads and writes are blocking and complete
+class UnixSocket {
+private:
+    int fd;     // Socket descriptor (-1 when closed)
+
+    // Constructor: Takes ownership of a descriptor
+    explicit UnixSocket(int fd);
+
+public:
+    // Constructor: Closed socket
+    UnixSocket();
+
+    // Destructor: Closes the socket
+    ~UnixSocket();
+
+    UnixSocket(const UnixSocket&) = delete;
+    UnixSocket& operator=(const UnixSocket&) = delete;
+    UnixSocket(UnixSocket&& other) noexcept;
+    UnixSocket& operator=(UnixSocket&& other) noexcept;
+
+    // Creates a listening socket at path (an existing socket file is replaced); throws std::runtime_error on failure
+    static UnixSocket listen(const std::string& path, int backlog = 128);
+
+    // Connects to the listening socket at path; throws std::runtime_error on failure
+    static UnixSocket connect(const std::string& path);
+
+    // Waits up to timeoutMilliseconds for a connection; returns a closed socket on timeout
+    UnixSocket accept(int timeoutMilliseconds);
+
+    // Reads exactly size bytes; returns false if the peer closed the connection first.
+    // Throws std::runtime_error on other errors
+    bool readFully(void* buffer, size_t size);
+
+    // Writes exactly size bytes; returns false if the peer has gone away or a send timeout expired
+    // (the stream may then hold a partial message, so the connection should be shut down)
+    bool writeFully(const void* buffer, size_t size);
+
+    // Makes writes that block for longer than timeoutMilliseconds fail; returns false if it cannot be set
+    bool setSendTimeout(int timeoutMilliseconds);
+
+    // Shuts down both directions, waking up any thread blocked on the socket
+    void shutdown();
+
+    // Returns true if the socket is open
+    bool isOpen() const;
+};
+
+#endif /* UnixSocket_hpp */
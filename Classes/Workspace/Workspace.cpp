@@ -0,0 +1,56 @@
+//
+//  Workspace.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "Workspace.hpp"
+#include <algorithm>
+
+// Constructor: Empty workspace, sized by the first reserve()
+Workspace::Workspace() : capacity(0) {}
+
+// Constructor: Buffers for batches of up to batchSize samples through the given layers
+Workspace::Workspace(const std::vector<std::unique_ptr<Layer>>& layers, int inputSize, size_t batchSize) : capacity(0) {
+    reserve(layers, inputSize, batchSize);
+}
+
+// Grows the buffers so they hold batchSize samples through the given layers
+void Workspace::reserve(const std::vector<std::unique_ptr<Layer>>& layers, int inputSize, size_t batchSize) {
+    // Compare the architecture without building a temporary, so the common case never allocates
+    bool sameArchitecture = widths.size() == layers.size() + 1 && widths[0] == static_cast<size_t>(inputSize);
+    for (size_t l = 0; sameArchitecture && l < layers.size(); ++l) {
+        sameArchitecture = widths[l + 1] == layers[l]->getNumOutputs() &&
+                           weightGradients[l].size() == layers[l]->getWeights().size() &&
+                           biasGradients[l].size() == layers[l]->getBiases().size() &&
+                           scratch[l].size() >= layers[l]->getScratchSize(std::min(batchSize, capacity));
+    }
+    if (sameArchitecture && batchSize <= capacity) {
+        return;
+    }
+    widths.assign(1, inputSize);
+    activations.resize(layers.size() + 1);
+    deltas.resize(layers.size());
+    weightGradients.resize(layers.size());
+    biasGradients.resize(layers.size());
+    scratch.resize(layers.size());
+    activations[0].resize(batchSize * inputSize);
+    for (size_t l = 0; l < layers.size(); ++l) {
+        size_t width = layers[l]->getNumOutputs();
+        widths.push_back(width);
+        activations[l + 1].resize(batchSize * width);
+        deltas[l].resize(batchSize * width);
+        weightGradients[l].resize(layers[l]->getWeights().size());
+        biasGradients[l].resize(layers[l]->getBiases().size());
+        scratch[l].resize(layers[l]->getScratchSize(batchSize));
+    }
+    labels.reserve(batchSize);
+    sparseInputs.reserve(batchSize, inputSize);
+    capacity = batchSize;
+}
+
+// Getter: Returns the largest batch size the buffers can hold
+size_t Workspace::getCapacity() const {
+    return capacity;
+}
@@ -0,0 +1,46 @@
+//
+//  Workspace.hpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#ifndef Workspace_hpp
+#define Workspace_hpp
+
+#include "Layer.hpp"
+#include "SparseInputs.hpp"
+#include <vector>
+
+// Preallocated activation and gradient buffers for the training and inference passes of a network.
+// The buffers are sized once from the architecture and the largest batch; after that, passes over
+// batches up to that size reuse them without touching the heap. A workspace is used by one thread at a time.
+class Workspace {
+private:
+    size_t capacity;                // Largest batch size the buffers can hold
+    std::vector<size_t> widths;     // Input size followed by the output size of every layer the buffers were sized for
+
+public:
+    std::vector<std::vector<Scalar>> activations;       // [0] = stacked inputs, [l + 1] = outputs of layer l (batch x width)
+    std::vector<std::vector<Scalar>> deltas;            // [l] = dL/da for the outputs of layer l (batch x width)
+    std::vector<std::vector<Scalar>> weightGradients;   // Accumulated weight gradients per layer
+    std::vector<std::vector<Scalar>> biasGradients;     // Accumulated bias gradients per layer
+    std::vector<std::vector<Scalar>> scratch;           // Per-layer scratch of the batched passes (e.g. im2col columns)
+    std::vector<int> labels;                            // Labels of the stacked samples
+    SparseInputs sparseInputs;                          // Nonzeros of the stacked inputs, for the sparse first layer
+
+    // Constructor: Empty workspace, sized by the first reserve()
+    Workspace();
+
+    // Constructor: Buffers for batches of up to batchSize samples through the given layers
+    Workspace(const std::vector<std::unique_ptr<Layer>>& layers, int inputSize, size_t batchSize);
+
+    // Grows the buffers so they hold batchSize samples through the given layers. Does nothing (and does
+    // not allocate) if they already do; rebuilds them if they were sized for a different architecture
+    void reserve(const std::vector<std::unique_ptr<Layer>>& layers, int inputSize, size_t batchSize);
+
+    // Getter: Returns the largest batch size the buffers can hold
+    size_t getCapacity() const;
+};
+
+#endif /* Workspace_hpp */
@@ -1,54 +1,95 @@
-//
-//  main.cpp
-//  neuralNetworks
-//
-//  Created by Necati Sefercioğlu
-//
-
-#include "GUI.hpp"
-#include "Input.hpp"
-#include <SFML/Graphics.hpp>
-#include <iostream>
-
-// Constant parameters for training
-const double LEARNING_RATE = 0.01;
-const int EPOCHS = 50;
-
-// Main function to run the neural network simulation with GUI
-int main() {
-    try {
-        // Initialize SFML window
-        sf::RenderWindow window(sf::VideoMode(1000, 600), "Neural Network Simulation");
-        window.setFramerateLimit(60); // Limit frame rate for smoother display
-
-        // Initialize input display
-        Input inputDisplay;
-
-        // Load datasets
-        std::string trainPath = "...";
-        std::string testPath = "...";
-        Dataset trainData(trainPath);
-        Dataset testData(testPath);
-
-        // Print dataset sizes
-        std::cout << "Training samples: " << trainData.getNumSamples() << std::endl;
-        std::cout << "Test samples: " << testData.getNumSamples() << std::endl;
-
-        // Initialize GUI
-        GUI gui(window, inputDisplay, trainData, testData, LEARNING_RATE, EPOCHS);
-
-        // Main loop
-        while (window.isOpen()) {
-            // Handle events through GUI
-            gui.handleEvents();
-
-            // Draw the GUI
-            gui.draw();
-        }
-    }
-    catch (const std::exception& e) {
-        std::cerr << "Error: " << e.what() << std::endl;
-        return 1;
-    }
-    return 0;
-}
+//
+//  main.cpp
+//  neuralNetworks
+//
+//  Created by Necati Sefercioğlu
+//
+
+#include "GUI.hpp"
+#include "Input.hpp"
+#include "Benchmark.hpp"
+#include "InferenceServer.hpp"
+#include "Kernels.hpp"
+#include "LoadGenerator.hpp"
+#include <SFML/Graphics.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Constant parameters for training
+const double LEARNING_RATE = 0.01;
+const int EPOCHS = 50;
+const std::string MODEL_PATH = "network.nnmd"; // Trained network, reloaded by Build on the next run
+
+// Main function to run the neural network simulation with GUI, or one of the headless modes:
+//   neuralNetworks bench ...                                              benchmarks
+//   neuralNetworks serve <model.nnmd> <socket> [maxBatch] [windowUs]      inference server
+//   neuralNetworks loadgen <socket> <data.csv> [connections] [requests]   load generator for the server
+int main(int argc, char* argv[]) {
+    try {
+#ifndef NDEBUG
+        // Verify the SIMD kernels selected for this CPU against the scalar reference
+        // (release builds run the same check through "bench test")
+        if (!Kernels::selfTest()) {
+            throw std::runtime_error("SIMD kernel self-test failed");
+        }
+#endif
+        std::cout << "Using " << Kernels::getLevelName(Kernels::getLevel()) << " kernels" << std::endl;
+
+        // Headless benchmarks
+        std::vector<std::string> args(argv + 1, argv + argc);
+        if (!args.empty() && args[0] == "bench") {
+            return Benchmark::run(std::vector<std::string>(args.begin() + 1, args.end()));
+        }
+        if (args.size() >= 3 && args[0] == "serve") {
+            Network network = Network::load(args[1]);
+            size_t maxBatchSize = args.size() >= 4 ? std::stoul(args[3]) : 32;
+            unsigned windowMicroseconds = args.size() >= 5 ? static_cast<unsigned>(std::stoul(args[4])) : 1000;
+            InferenceServer server(network, args[2], maxBatchSize, windowMicroseconds);
+            server.run();
+            return 0;
+        }
+        if (args.size() >= 3 && args[0] == "loadgen") {
+            Dataset data = Dataset::openCached(args[2]);
+            unsigned connections = args.size() >= 4 ? static_cast<unsigned>(std::stoul(args[3])) : 16;
+            size_t requests = args.size() >= 5 ? std::stoul(args[4]) : 1000;
+            LoadGenerator::run(args[1], data, connections, requests);
+            return 0;
+        }
+
+        // Initialize SFML window
+        sf::RenderWindow window(sf::VideoMode(1000, 600), "Neural Network Simulation");
+        window.setFramerateLimit(60); // Limit frame rate for smoother display
+
+        // Initialize input display
+        Input inputDisplay;
+
+        // Load datasets
+        std::string trainPath = "...";
+        std::string testPath = "...";
+        // CSV files are parsed once and cached next to them as memory-mappable binary files
+        Dataset trainData = Dataset::openCached(trainPath);
+        Dataset testData = Dataset::openCached(testPath);
+
+        // Print dataset sizes
+        std::cout << "Training samples: " << trainData.getNumSamples() << std::endl;
+        std::cout << "Test samples: " << testData.getNumSamples() << std::endl;
+
+        // Initialize GUI
+        GUI gui(window, inputDisplay, trainData, testData, LEARNING_RATE, EPOCHS, MODEL_PATH);
+
+        // Main loop
+        while (window.isOpen()) {
+            // Handle events through GUI
+            gui.handleEvents();
+
+            // Draw the GUI
+            gui.draw();
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}